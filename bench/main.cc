@@ -0,0 +1,796 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "include/buddhabrot.h"
+#include "include/double_double.h"
+#include "include/dual_expr.h"
+#include "include/dual_number.h"
+#include "include/escape_precise.h"
+#include "include/escape_time.h"
+#include "include/newton.h"
+#include "include/perturbation.h"
+#include "include/scroll_cache.h"
+#include "include/subdivision.h"
+#include "include/thread_pool.h"
+#include "include/tile_cache.h"
+
+// meson benchmark target.
+//   fractal_bench [--golden FILE] [--update-golden] [--json FILE] [--quick]
+// Runs dual_num micro benchmarks, fixed-view kernel throughput and a thread-scaling sweep, then checks
+// fixed renders against the hashes in FILE. Results are written as JSON; exit status is 1 on any mismatch.
+
+struct bench_options {
+    const char* golden = nullptr;
+    bool update_golden = false;
+    const char* json = "bench.json";
+    bool quick = false;
+};
+
+struct bench_result {
+    std::string name;
+    std::string unit;
+    double value;
+};
+
+struct golden_result {
+    std::string name;
+    std::uint64_t hash;
+    std::uint64_t expected;
+    bool found;
+};
+
+template <typename Tp>
+inline void do_not_optimize(const Tp& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename F>
+double seconds(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief best of repeat runs, so a single preemption does not show up as a regression
+ */
+template <typename F>
+double best_seconds(int repeat, F&& f) {
+    double best = seconds(f);
+    for (int i = 1; i < repeat; i++) best = std::min(best, seconds(f));
+    return best;
+}
+
+/**
+ * @class instruction_counter
+ * @brief user-space instructions retired by this thread, from a perf_event counter
+ * Not available off Linux, without a PMU (most VMs and containers) or above perf_event_paranoid 2.
+ */
+class instruction_counter {
+private:
+    int fd_ = -1;
+
+public:
+    instruction_counter() {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    instruction_counter(const instruction_counter&) = delete;
+    instruction_counter& operator=(const instruction_counter&) = delete;
+
+    ~instruction_counter() {
+#ifdef __linux__
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+
+    bool available() const { return fd_ >= 0; }
+
+    /**
+     * @brief instructions f() retired, or 0 without a counter
+     */
+    template <typename F>
+    std::uint64_t count(F&& f) {
+        std::uint64_t ret = 0;
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            f();
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &ret, sizeof(ret)) != sizeof(ret)) ret = 0;
+        }
+#endif
+        return ret;
+    }
+};
+
+// FNV-1a over the raw bytes of a buffer
+class fnv1a {
+private:
+    std::uint64_t hash_ = 0xcbf29ce484222325ull;
+
+public:
+    template <typename Tp>
+    void update(const std::vector<Tp>& v) {
+        const auto* p = reinterpret_cast<const unsigned char*>(v.data());
+        for (std::size_t i = 0; i < v.size() * sizeof(Tp); i++) {
+            hash_ ^= p[i];
+            hash_ *= 0x100000001b3ull;
+        }
+    }
+
+    std::uint64_t value() const { return hash_; }
+};
+
+// real parts alternate 1 + e / 1 - e, so long * and / chains neither overflow nor sink into denormals
+template <typename Tp>
+dual_num<Tp> dual_value(int i) {
+    const double e = (i % 8) * 1e-3 * (i % 2 ? 1 : -1);
+    if constexpr (std::is_same_v<Tp, std::complex<double>>) {
+        return {Tp(1.0 + e, e), Tp(1e-3, -e)};
+    } else {
+        return {Tp(1 + e), Tp(1e-3)};
+    }
+}
+
+/**
+ * @brief ns per operation of a dependent chain acc = acc op x[i]
+ */
+template <typename Tp, typename Op>
+double dual_chain_ns(std::size_t n, Op op) {
+    std::vector<dual_num<Tp>> x;
+    for (int i = 0; i < 64; i++) x.push_back(dual_value<Tp>(i));
+
+    const auto elapsed = best_seconds(5, [&] {
+        auto acc = dual_value<Tp>(0);
+        for (std::size_t i = 0; i < n; i++) {
+            acc = op(acc, x[i & 63]);
+            do_not_optimize(acc);
+        }
+    });
+    return elapsed / static_cast<double>(n) * 1e9;
+}
+
+template <typename Tp>
+void bench_dual(std::string_view type, std::size_t n, std::vector<bench_result>& results) {
+    const auto name = [&](std::string_view op) { return "dual_num<" + std::string(type) + ">::" + std::string(op); };
+    results.push_back({name("operator+"), "ns/op", dual_chain_ns<Tp>(n, [](auto a, auto b) { return a + b; })});
+    results.push_back({name("operator-"), "ns/op", dual_chain_ns<Tp>(n, [](auto a, auto b) { return a - b; })});
+    results.push_back({name("operator*"), "ns/op", dual_chain_ns<Tp>(n, [](auto a, auto b) { return a * b; })});
+    results.push_back({name("operator/"), "ns/op", dual_chain_ns<Tp>(n, [](auto a, auto b) { return a / b; })});
+}
+
+/**
+ * @brief (z - r_0)(z - r_1) ... (z - r_7) with its derivative, eager dual_num or dual_expr.h in Mode
+ */
+template <typename Tp>
+dual_num<Tp> dual_product_eager(const Tp& z, const std::array<Tp, 8>& r) {
+    const dual_num<Tp> x{z, Tp{1}};
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return ((x - r[0]) * ... * (x - r[I + 1]));
+    }(std::make_index_sequence<7>{});
+}
+
+template <dual_eval_mode Mode, typename Tp>
+dual_num<Tp> dual_product_lazy(const Tp& z, const std::array<Tp, 8>& r) {
+    const auto x = dual_variable(z);
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return dual_eval<Mode>(((x - r[0]) * ... * (x - r[I + 1])));
+    }(std::make_index_sequence<7>{});
+}
+
+/**
+ * @brief degree 8 product-form polynomial evaluated eagerly against expression templates, exact and fused
+ * Reports ns per evaluation, instructions per evaluation where a counter is available, and how many exact
+ * results are bit-identical to the eager ones.
+ */
+template <typename Tp>
+void bench_dual_expr(std::string_view type, std::size_t n, std::vector<bench_result>& results) {
+    std::array<Tp, 8> roots;
+    for (int k = 0; k < 8; k++) roots[k] = dual_value<Tp>(k * 3 + 1).real();
+    std::vector<Tp> z;
+    for (int i = 0; i < 64; i++) z.push_back(dual_value<Tp>(i).real() + dual_value<Tp>(i + 5).imag());
+
+    instruction_counter counter;
+    const auto name = "poly8<" + std::string(type) + ">/";
+    const auto run = [&](std::string_view label, auto eval) {
+        const auto loop = [&] {
+            for (std::size_t i = 0; i < n; i++) do_not_optimize(eval(z[i & 63], roots));
+        };
+        results.push_back({name + std::string(label), "ns/eval", best_seconds(5, loop) / static_cast<double>(n) * 1e9});
+        if (counter.available()) {
+            results.push_back({name + std::string(label) + "/insn", "instructions/eval",
+                               static_cast<double>(counter.count(loop)) / static_cast<double>(n)});
+        }
+    };
+    run("eager", [](const Tp& x, const auto& r) { return dual_product_eager(x, r); });
+    run("exact", [](const Tp& x, const auto& r) { return dual_product_lazy<dual_eval_mode::exact>(x, r); });
+    run("fused", [](const Tp& x, const auto& r) { return dual_product_lazy<dual_eval_mode::fused>(x, r); });
+
+    std::size_t same = 0;
+    for (const auto& x : z) same += dual_product_eager(x, roots) == dual_product_lazy<dual_eval_mode::exact>(x, roots);
+    results.push_back({name + "identical", "ratio", static_cast<double>(same) / static_cast<double>(z.size())});
+}
+
+escape_buffer render_escape_view(fractal_kind kind, std::size_t size, std::uint32_t max_iter, escape_kernel kernel,
+                                 bool interior_checks = true) {
+    escape_params param;
+    param.kind = kind;
+    param.c[0] = -0.8f;
+    param.c[1] = 0.156f;
+    param.max_iter = max_iter;
+    param.interior_checks = interior_checks;
+    escape_buffer buf(size, size);
+    render_escape_time(param, kind == fractal_kind::julia ? julia_default_view : mandelbrot_default_view, buf, kernel);
+    return buf;
+}
+
+void bench_kernels(std::size_t size, std::vector<bench_result>& results) {
+    for (const auto isa : {escape_isa::scalar, escape_isa::avx2, escape_isa::avx512}) {
+        if (isa > detect_escape_isa()) continue;
+        const auto kernel = select_escape_kernel(isa);
+        const auto pixels = static_cast<double>(size * size);
+
+        const auto mandelbrot = best_seconds(3, [&] { render_escape_view(fractal_kind::mandelbrot, size, 50, kernel); });
+        results.push_back({std::string("mandelbrot/") + escape_isa_to_string(isa), "pixels/s", pixels / mandelbrot});
+
+        const auto julia = best_seconds(3, [&] { render_escape_view(fractal_kind::julia, size, 200, kernel); });
+        results.push_back({std::string("julia/") + escape_isa_to_string(isa), "pixels/s", pixels / julia});
+    }
+
+    work_stealing_pool pool(1);
+    newton_buffer reference(size / 4, size / 4);
+    render_newton(newton_default_params<double>(), reference, pool, 32, escape_isa::scalar);
+    for (const auto isa : {escape_isa::scalar, escape_isa::avx2, escape_isa::avx512}) {
+        if (isa > detect_escape_isa()) continue;
+        newton_buffer buf(size / 4, size / 4);
+        const auto newton =
+            best_seconds(3, [&] { render_newton(newton_default_params<double>(), buf, pool, 32, isa); });
+        const auto label = std::string("newton/") + escape_isa_to_string(isa);
+        results.push_back({label, "pixels/s", static_cast<double>(buf.width * buf.height) / newton});
+
+        // batched kernels divide like the shader, so only near-total agreement with std::complex is expected
+        const auto same = std::inner_product(buf.root.begin(), buf.root.end(), reference.root.begin(), std::size_t{0},
+                                             std::plus<>{}, std::equal_to<>{});
+        results.push_back({label + "/agreement", "ratio", static_cast<double>(same) / buf.root.size()});
+    }
+}
+
+/**
+ * @brief mandelbrot at 1000 iterations with the interior checks against iterating the interior to the end
+ * Agreement counts the pixels whose count and, if they escaped, final z match; stopped pixels keep a z of
+ * their own.
+ */
+void bench_interior(std::size_t size, std::vector<bench_result>& results) {
+    const auto pixels = static_cast<double>(size * size);
+    for (const auto isa : {escape_isa::scalar, escape_isa::avx2, escape_isa::avx512}) {
+        if (isa > detect_escape_isa()) continue;
+        const auto kernel = select_escape_kernel(isa);
+        escape_buffer full, early;
+        const auto full_elapsed =
+            best_seconds(3, [&] { full = render_escape_view(fractal_kind::mandelbrot, size, 1000, kernel, false); });
+        const auto early_elapsed =
+            best_seconds(3, [&] { early = render_escape_view(fractal_kind::mandelbrot, size, 1000, kernel); });
+
+        const auto label = std::string("mandelbrot/interior/") + escape_isa_to_string(isa);
+        results.push_back({label + "/full", "pixels/s", pixels / full_elapsed});
+        results.push_back({label, "pixels/s", pixels / early_elapsed});
+        results.push_back({label + "/speedup", "ratio", full_elapsed / early_elapsed});
+        std::size_t same = 0;
+        for (std::size_t i = 0; i < early.iter.size(); i++) {
+            same += early.iter[i] == full.iter[i] &&
+                    (early.iter[i] == 1000 || (early.re[i] == full.re[i] && early.im[i] == full.im[i]));
+        }
+        results.push_back({label + "/agreement", "ratio", static_cast<double>(same) / pixels});
+
+        const auto counts = count_interior(early.interior);
+        results.push_back({label + "/cardioid", "ratio", static_cast<double>(counts.cardioid) / pixels});
+        results.push_back({label + "/bulb", "ratio", static_cast<double>(counts.bulb) / pixels});
+        results.push_back({label + "/period", "ratio", static_cast<double>(counts.period) / pixels});
+    }
+}
+
+/**
+ * @brief Mariani-Silver subdivision against rendering every pixel, mandelbrot and julia at 1000 iterations
+ * The julia constant -0.5 has an attracting fixed point that float orbits on this view approach without
+ * repeating exactly, so its interior is flat but not caught by the interior checks.
+ */
+void bench_subdivision(std::size_t size, std::vector<bench_result>& results) {
+    const auto pixels = static_cast<double>(size * size);
+    work_stealing_pool pool(1);
+    for (const auto kind : {fractal_kind::mandelbrot, fractal_kind::julia}) {
+        escape_params param;
+        param.kind = kind;
+        param.c[0] = -0.5f;
+        param.max_iter = 1000;
+        const auto& view = kind == fractal_kind::julia ? julia_default_view : mandelbrot_default_view;
+        for (const auto isa : {escape_isa::scalar, escape_isa::avx2, escape_isa::avx512}) {
+            if (isa > detect_escape_isa()) continue;
+            const auto kernel = select_escape_kernel(isa);
+            escape_buffer full(size, size);
+            const auto full_elapsed = best_seconds(3, [&] { render_escape_time(param, view, full, kernel); });
+            escape_buffer subdivided(size, size);
+            subdivision_stats stats;
+            const auto subdivided_elapsed =
+                best_seconds(3, [&] { stats = render_escape_subdivided(param, view, subdivided, pool, kernel); });
+
+            const auto label = std::string(kind == fractal_kind::julia ? "julia" : "mandelbrot") + "/subdivide/" +
+                               escape_isa_to_string(isa);
+            results.push_back({label + "/full", "pixels/s", pixels / full_elapsed});
+            results.push_back({label, "pixels/s", pixels / subdivided_elapsed});
+            results.push_back({label + "/speedup", "ratio", full_elapsed / subdivided_elapsed});
+            results.push_back({label + "/filled", "ratio", stats.filled_fraction()});
+            results.push_back({label + "/agreement", "ratio",
+                               1.0 - static_cast<double>(subdivision_mismatches(subdivided, full)) / pixels});
+        }
+    }
+}
+
+/**
+ * @brief newton with the product form against Horner, degree 3 to 12 and 16 (past the unrolled kernels)
+ * Both iterate the same pixels in std::complex<double> on one thread; only the polynomial evaluation differs.
+ */
+void bench_newton_degrees(std::size_t size, std::vector<bench_result>& results) {
+    size /= 4;
+    const auto pixels = static_cast<double>(size * size);
+    for (const std::size_t degree : {3, 6, 9, 12, 16}) {
+        newton_params<double> param;
+        for (std::size_t k = 0; k < degree; k++) param.roots.push_back(std::polar(1.0, 6.283185307179586 * k / degree));
+        param.max_iter = 50;
+
+        newton_buffer product(size, size);
+        const auto product_elapsed = best_seconds(3, [&] {
+            for (std::size_t row = 0; row < size; row++) {
+                for (std::size_t col = 0; col < size; col++) {
+                    const auto p = newton_pixel_to_plane(col, row, size, size, param.scale);
+                    product.root[row * size + col] =
+                        nearest_root(newton_iterate(p, param.roots, param.max_iter), param.roots);
+                }
+            }
+        });
+
+        newton_buffer horner(size, size);
+        const auto kernel = select_newton_kernel<double>(degree, escape_isa::scalar);
+        const auto horner_elapsed = best_seconds(3, [&] { kernel(param, horner, 0, 0, size, size); });
+
+        const auto label = "newton/degree=" + std::to_string(degree);
+        results.push_back({label + "/product", "pixels/s", pixels / product_elapsed});
+        results.push_back({label + "/horner", "pixels/s", pixels / horner_elapsed});
+        const auto same = std::inner_product(horner.root.begin(), horner.root.end(), product.root.begin(),
+                                             std::size_t{0}, std::plus<>{}, std::equal_to<>{});
+        results.push_back({label + "/agreement", "ratio", static_cast<double>(same) / horner.root.size()});
+    }
+}
+
+/**
+ * @brief newton stopping at tolerance 1e-6 against running every step (tolerance 0), with the step statistics
+ */
+void bench_newton_convergence(std::size_t size, std::vector<bench_result>& results) {
+    size /= 4;
+    const auto pixels = static_cast<double>(size * size);
+    work_stealing_pool pool(1);
+    for (const auto isa : {escape_isa::scalar, escape_isa::avx2, escape_isa::avx512}) {
+        if (isa > detect_escape_isa()) continue;
+        auto param = newton_default_params<double>();
+        param.tolerance = 0;
+        newton_buffer full(size, size);
+        const auto full_elapsed = best_seconds(3, [&] { render_newton(param, full, pool, 32, isa); });
+
+        param.tolerance = 1e-6;
+        newton_buffer early(size, size);
+        const auto early_elapsed = best_seconds(3, [&] { render_newton(param, early, pool, 32, isa); });
+
+        const auto label = std::string("newton/early_exit/") + escape_isa_to_string(isa);
+        results.push_back({label + "/full", "pixels/s", pixels / full_elapsed});
+        results.push_back({label, "pixels/s", pixels / early_elapsed});
+        results.push_back({label + "/speedup", "ratio", full_elapsed / early_elapsed});
+        const auto same = std::inner_product(early.root.begin(), early.root.end(), full.root.begin(), std::size_t{0},
+                                             std::plus<>{}, std::equal_to<>{});
+        results.push_back({label + "/agreement", "ratio", static_cast<double>(same) / early.root.size()});
+
+        const auto stats = make_iteration_stats(early.iter);
+        results.push_back({label + "/steps_mean", "steps", stats.mean});
+        results.push_back({label + "/steps_p99", "steps", stats.p99});
+        results.push_back({label + "/steps_max", "steps", stats.max});
+    }
+}
+
+/**
+ * @brief a seahorse valley view at scale 1e-13, past what double resolves at this size
+ */
+escape_buffer render_precise_view(std::size_t size, precise_kernel kernel) {
+    escape_params param;
+    param.max_iter = 2500;
+    const auto view = precise_view_from_strings("-0.743643887037158704752191506114774",
+                                                "0.131825904205311970493132056385139", 1e-13);
+    escape_buffer buf(size, size);
+    render_precise_rows(param, view, buf, 0, size, kernel);
+    return buf;
+}
+
+/**
+ * @brief double-double / quad-double kernel throughput, and agreement with a perturbation render of the view
+ */
+void bench_precise(std::size_t size, std::vector<bench_result>& results) {
+    size /= 8;
+    const auto pixels = static_cast<double>(size * size);
+    for (const auto isa : {escape_isa::scalar, escape_isa::avx2, escape_isa::avx512}) {
+        if (isa > detect_escape_isa()) continue;
+        const auto kernel = select_precise_kernel(precision_level::double_double, isa);
+        const auto dd = best_seconds(3, [&] { render_precise_view(size, kernel); });
+        results.push_back({std::string("precise/dd/") + escape_isa_to_string(isa), "pixels/s", pixels / dd});
+    }
+    const auto qd = best_seconds(1, [&] { render_precise_view(size, select_precise_kernel(precision_level::quad_double)); });
+    results.push_back({"precise/qd", "pixels/s", pixels / qd});
+
+    const auto buf = render_precise_view(size, select_precise_kernel(precision_level::double_double));
+    deep_view view;
+    const auto limbs = deep_limbs(1e-13, size);
+    view.center[0] = big_fixed::from_string("-0.743643887037158704752191506114774", limbs);
+    view.center[1] = big_fixed::from_string("0.131825904205311970493132056385139", limbs);
+    view.scale = 1e-13;
+    const auto ref = compute_reference_orbit(view, size, size, 2500);
+    escape_buffer deep(size, size);
+    render_perturbation_rows(ref, view, 2500, deep, 0, size);
+
+    // glitch handling and series skip round differently, so a few chaotic pixels may disagree
+    const auto same = std::inner_product(buf.iter.begin(), buf.iter.end(), deep.iter.begin(), std::size_t{0},
+                                         std::plus<>{}, std::equal_to<>{});
+    results.push_back({"precise/dd/agreement", "ratio", static_cast<double>(same) / buf.iter.size()});
+}
+
+/**
+ * @brief frames/s of a drag over the mandelbrot view: full renders against scrolling the previous frame
+ * The scrolled frame has to end up identical to a full render at the final pan.
+ */
+void bench_scroll(std::size_t size, std::vector<bench_result>& results) {
+    constexpr int steps = 16;
+    constexpr int dx = 12;
+    constexpr int dy = -5;
+    escape_params param;
+    param.max_iter = 50;
+    work_stealing_pool pool(1);
+
+    auto view = mandelbrot_default_view;
+    escape_buffer full(size, size);
+    const auto full_elapsed = seconds([&] {
+        for (int i = 0; i < steps; i++) {
+            view.pan[0] -= dx;
+            view.pan[1] -= dy;
+            render_escape_time(param, view, full);
+        }
+    });
+
+    view = mandelbrot_default_view;
+    escape_buffer scrolled(size, size);
+    render_escape_time(param, view, scrolled);
+    const auto scroll_elapsed = seconds([&] {
+        for (int i = 0; i < steps; i++) {
+            view.pan[0] -= dx;
+            view.pan[1] -= dy;
+            scroll_escape_time(param, view, scrolled, dx, dy, pool);
+        }
+    });
+
+    results.push_back({"mandelbrot/pan/full", "frames/s", steps / full_elapsed});
+    results.push_back({"mandelbrot/pan/scroll", "frames/s", steps / scroll_elapsed});
+    const auto same = std::inner_product(scrolled.iter.begin(), scrolled.iter.end(), full.iter.begin(),
+                                         std::size_t{0}, std::plus<>{}, std::equal_to<>{});
+    results.push_back({"mandelbrot/pan/agreement", "ratio", static_cast<double>(same) / full.iter.size()});
+}
+
+/**
+ * @brief a zoom into the mandelbrot view and back out through a tile_cache, each view waited for until complete
+ * Zooming back out should only hit the tiles kept from the way in.
+ */
+void bench_tiles(std::size_t size, std::vector<bench_result>& results) {
+    escape_params param;
+    param.max_iter = 200;
+    tile_cache cache(256u << 20);
+    tile_browser browser(cache, tile_format::smooth_half);
+    std::vector<std::array<float, 2>> out;
+
+    std::vector<tile_view> path;
+    for (int i = 0; i < 8; i++) path.push_back({1.5 * std::pow(0.5, i), {-0.5 - 0.25 * (1.0 - std::pow(0.5, i)), 0.0}});
+
+    const auto browse = [&](auto first, auto last) {
+        return seconds([&] {
+            for (auto it = first; it != last; ++it) {
+                browser.compose(param, *it, size, size, out);
+                browser.wait();
+                browser.compose(param, *it, size, size, out);
+            }
+        });
+    };
+    const auto in = browse(path.begin(), path.end());
+    const auto before = cache.stats();
+    const auto back = browse(path.rbegin(), path.rend());
+    const auto after = cache.stats();
+
+    results.push_back({"tiles/zoom_in", "views/s", static_cast<double>(path.size()) / in});
+    results.push_back({"tiles/zoom_out", "views/s", static_cast<double>(path.size()) / back});
+    results.push_back({"tiles/zoom_out/hit_ratio", "ratio",
+                       static_cast<double>(after.hits - before.hits) /
+                           static_cast<double>(after.hits + after.misses - before.hits - before.misses)});
+    results.push_back({"tiles/bytes", "MiB", static_cast<double>(cache.bytes()) / (1 << 20)});
+}
+
+void bench_threads(std::size_t size, std::vector<bench_result>& results) {
+    const auto hw = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    std::vector<std::size_t> counts;
+    for (std::size_t t = 1; t < hw; t *= 2) counts.push_back(t);
+    counts.push_back(hw);
+
+    double base = 0.0;
+    for (const auto t : counts) {
+        work_stealing_pool pool(t);
+        newton_buffer buf(size / 2, size / 2);
+        const auto elapsed = best_seconds(2, [&] { render_newton(newton_default_params<double>(), buf, pool); });
+        const auto rate = static_cast<double>(buf.width * buf.height) / elapsed;
+        if (t == 1) base = rate;
+        results.push_back({"newton/threads=" + std::to_string(t), "pixels/s", rate});
+        results.push_back({"newton/threads=" + std::to_string(t) + "/efficiency", "ratio", rate / (base * t)});
+    }
+}
+
+/**
+ * @brief buddhabrot samples/s by thread count, Metropolis-Hastings and uniform, and the cost of merging the
+ * per-thread histograms
+ */
+void bench_buddhabrot(std::size_t size, std::vector<bench_result>& results) {
+    const auto hw = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    std::vector<std::size_t> counts;
+    for (std::size_t t = 1; t < hw; t *= 2) counts.push_back(t);
+    counts.push_back(hw);
+
+    const std::uint64_t samples = size * size;
+    for (const bool metropolis : {true, false}) {
+        const std::string label = std::string("buddhabrot/") + (metropolis ? "metropolis" : "uniform");
+        double base = 0.0;
+        for (const auto t : counts) {
+            work_stealing_pool pool(t);
+            buddhabrot_params param;
+            param.metropolis = metropolis;
+            buddhabrot_renderer renderer(param, mandelbrot_default_view, size, size, pool.size());
+            const auto elapsed = best_seconds(2, [&] { renderer.run(pool, samples); });
+            const auto rate = static_cast<double>(samples) / elapsed;
+            if (t == 1) base = rate;
+            results.push_back({label + "/threads=" + std::to_string(t), "samples/s", rate});
+            results.push_back({label + "/threads=" + std::to_string(t) + "/efficiency", "ratio", rate / (base * t)});
+            if (metropolis && t == hw) {
+                const auto merge = best_seconds(3, [&] { renderer.density(pool); });
+                results.push_back({label + "/merge", "bins/s", static_cast<double>(size * size) / merge});
+            }
+        }
+    }
+}
+
+/**
+ * @brief fixed renders whose bytes must not change; a faster kernel has to reproduce them exactly
+ */
+std::vector<std::pair<std::string, std::uint64_t>> golden_hashes() {
+    std::vector<std::pair<std::string, std::uint64_t>> ret;
+
+    for (const auto isa : {escape_isa::scalar, escape_isa::avx2, escape_isa::avx512}) {
+        if (isa > detect_escape_isa()) continue;
+        for (const auto kind : {fractal_kind::mandelbrot, fractal_kind::julia}) {
+            const auto buf = render_escape_view(kind, 256, 100, select_escape_kernel(isa));
+            fnv1a h;
+            h.update(buf.iter);
+            h.update(buf.re);
+            h.update(buf.im);
+            // every ISA is held to the same image: the part before '/' is the golden key
+            ret.emplace_back(std::string(kind == fractal_kind::mandelbrot ? "mandelbrot_256/" : "julia_256/") +
+                                 escape_isa_to_string(isa),
+                             h.value());
+        }
+    }
+
+    for (const auto isa : {escape_isa::scalar, escape_isa::avx2, escape_isa::avx512}) {
+        if (isa > detect_escape_isa()) continue;
+        const auto buf = render_precise_view(128, select_precise_kernel(precision_level::double_double, isa));
+        fnv1a h;
+        h.update(buf.iter);
+        h.update(buf.re);
+        h.update(buf.im);
+        ret.emplace_back(std::string("precise_dd_128/") + escape_isa_to_string(isa), h.value());
+    }
+
+    {
+        const auto buf = render_precise_view(48, select_precise_kernel(precision_level::quad_double));
+        fnv1a h;
+        h.update(buf.iter);
+        h.update(buf.re);
+        h.update(buf.im);
+        ret.emplace_back("precise_qd_48", h.value());
+    }
+
+    {
+        work_stealing_pool pool(2);
+        newton_buffer buf(128, 128);
+        render_newton(newton_default_params<double>(), buf, pool, 32, escape_isa::scalar);
+        fnv1a h;
+        h.update(buf.root);
+        ret.emplace_back("newton_128", h.value());
+
+        fnv1a steps;
+        steps.update(buf.iter);
+        steps.update(buf.smooth);
+        ret.emplace_back("newton_steps_128", steps.value());
+    }
+
+    {
+        deep_view view;
+        view.center[0] = big_fixed::from_string("-1.7497219141980389", 4);
+        view.center[1] = big_fixed::from_string("0", 4);
+        view.scale = 1e-12;
+        const auto ref = compute_reference_orbit(view, 128, 128, 3000);
+        escape_buffer buf(128, 128);
+        render_perturbation_rows(ref, view, 3000, buf, 0, buf.height);
+        fnv1a h;
+        h.update(buf.iter);
+        ret.emplace_back("deep_128", h.value());
+    }
+
+    {
+        // (a + b e) / (c + d e) with c^2 out of double range; the old operator/= squared c and returned NaN
+        const auto q = dual_num<double>{1e200, 1.0} / dual_num<double>{1e200, 0.0};
+        const std::vector<double> v = {q.real(), q.imag()};
+        fnv1a h;
+        h.update(v);
+        ret.emplace_back("dual_div_1e200", h.value());
+    }
+
+    return ret;
+}
+
+std::map<std::string, std::uint64_t> read_golden(const char* path) {
+    std::map<std::string, std::uint64_t> ret;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line.front() == '#') continue;
+        std::istringstream ss(line);
+        std::string name;
+        std::string hash;
+        if (ss >> name >> hash) ret[name] = std::stoull(hash, nullptr, 16);
+    }
+    return ret;
+}
+
+void write_golden(const char* path, const std::vector<std::pair<std::string, std::uint64_t>>& hashes) {
+    std::ofstream out(path);
+    out << "# name fnv1a-64, regenerate with fractal_bench --golden <this file> --update-golden\n";
+    std::map<std::string, std::uint64_t> unique;
+    for (const auto& [name, hash] : hashes) unique.emplace(name.substr(0, name.find('/')), hash);
+    for (const auto& [name, hash] : unique) {
+        out << name << " " << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec << "\n";
+    }
+}
+
+std::string hex(std::uint64_t v) {
+    std::ostringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << v;
+    return ss.str();
+}
+
+void write_json(const char* path, const std::vector<bench_result>& results, const std::vector<golden_result>& golden) {
+    std::ofstream out(path);
+    out << std::setprecision(9);
+    out << "{\n  \"isa\": \"" << escape_isa_to_string(detect_escape_isa()) << "\",\n";
+    out << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"unit\": \"" << r.unit << "\", \"value\": " << r.value << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"golden\": [\n";
+    for (std::size_t i = 0; i < golden.size(); i++) {
+        const auto& g = golden[i];
+        out << "    {\"name\": \"" << g.name << "\", \"hash\": \"" << hex(g.hash) << "\", \"expected\": \""
+            << (g.found ? hex(g.expected) : "") << "\", \"ok\": " << (g.found && g.hash == g.expected ? "true" : "false")
+            << "}" << (i + 1 < golden.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+bench_options parse_options(int argc, char** argv) {
+    bench_options opt;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (arg == "--golden" && i + 1 < argc) {
+            opt.golden = argv[++i];
+        } else if (arg == "--update-golden") {
+            opt.update_golden = true;
+        } else if (arg == "--json" && i + 1 < argc) {
+            opt.json = argv[++i];
+        } else if (arg == "--quick") {
+            opt.quick = true;
+        } else {
+            std::cerr << "unknown option: " << arg << std::endl;
+            std::exit(1);
+        }
+    }
+    return opt;
+}
+
+int main(int argc, char** argv) {
+    const auto opt = parse_options(argc, argv);
+    const std::size_t chain = opt.quick ? 100'000 : 5'000'000;
+    const std::size_t size = opt.quick ? 256 : 1024;
+
+    std::vector<bench_result> results;
+    bench_dual<float>("float", chain, results);
+    bench_dual<double>("double", chain, results);
+    bench_dual<std::complex<double>>("complex<double>", chain, results);
+    bench_dual<double_double<double>>("double_double<double>", chain, results);
+    bench_dual_expr<double>("double", chain, results);
+    bench_dual_expr<std::complex<double>>("complex<double>", chain, results);
+    bench_dual_expr<double_double<double>>("double_double<double>", chain, results);
+    bench_kernels(size, results);
+    bench_interior(size, results);
+    bench_subdivision(size, results);
+    bench_scroll(size, results);
+    bench_tiles(size, results);
+    bench_newton_degrees(size, results);
+    bench_newton_convergence(size, results);
+    bench_precise(size, results);
+    bench_threads(size, results);
+    bench_buddhabrot(size, results);
+
+    for (const auto& r : results) std::cout << std::setw(40) << std::left << r.name << r.value << " " << r.unit << std::endl;
+
+    const auto hashes = golden_hashes();
+    if (opt.update_golden && opt.golden) write_golden(opt.golden, hashes);
+
+    const auto expected = opt.golden ? read_golden(opt.golden) : std::map<std::string, std::uint64_t>{};
+    std::vector<golden_result> golden;
+    bool ok = true;
+    for (const auto& [name, hash] : hashes) {
+        const auto it = expected.find(name.substr(0, name.find('/')));
+        const bool found = it != expected.end();
+        golden.push_back({name, hash, found ? it->second : 0, found});
+        const bool match = found && it->second == hash;
+        ok &= match || !opt.golden;
+        std::cout << "golden " << name << ": " << (match ? "ok" : found ? "MISMATCH" : "missing") << std::endl;
+    }
+
+    write_json(opt.json, results, golden);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file adaptive_aa.h
+ * @brief adaptive supersampling of the pixels next to a band or basin boundary, CPU side of antialias.glsl
+ */
+
+#ifndef PRACC_GL_ADAPTIVE_AA_H
+#define PRACC_GL_ADAPTIVE_AA_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "include/thread_pool.h"
+
+/**
+ * @brief mean change below which a pixel stops taking samples, 8 levels of an 8 bit channel
+ * On the default mandelbrot view this stops most edge pixels at 4 - 8 samples and still comes closer to 64
+ * samples everywhere than 8 everywhere does.
+ */
+constexpr float aa_default_tolerance = 1.0f / 32.0f;
+
+/**
+ * @brief fewest and most samples an edge pixel takes
+ */
+constexpr std::uint32_t aa_min_samples = 4;
+constexpr std::uint32_t aa_max_samples = 64;
+
+/**
+ * @brief per pixel hash, same integer mixing as aa_hash() in antialias.glsl
+ */
+constexpr std::uint32_t aa_hash(std::uint32_t x, std::uint32_t y) {
+    std::uint32_t h = (x * 0x8da6b343u) ^ (y * 0xd8163841u);
+    h = (h ^ (h >> 16)) * 0x7feb352du;
+    h = (h ^ (h >> 15)) * 0x846ca68bu;
+    return h ^ (h >> 16);
+}
+
+/**
+ * @brief offset in [-0.5, 0.5)^2 of sample i of pixel (x, y), same as aa_offset() in antialias.glsl
+ * The R2 low discrepancy sequence, so every prefix covers the pixel evenly, rotated by a per pixel hash
+ * (Cranley-Patterson) so that neighbouring edge pixels do not share one pattern that would alias again.
+ */
+inline std::array<float, 2> aa_offset(std::uint32_t i, std::uint32_t x, std::uint32_t y) {
+    const auto h = aa_hash(x, y);
+    const float r[2] = {static_cast<float>(h & 0xffffu) / 65536.0f, static_cast<float>(h >> 16) / 65536.0f};
+    const float a[2] = {0.7548776662f, 0.5698402910f};
+    std::array<float, 2> ret;
+    for (int k = 0; k < 2; k++) {
+        const float t = r[k] + static_cast<float>(i) * a[k];
+        ret[k] = t - std::floor(t) - 0.5f;
+    }
+    return ret;
+}
+
+/**
+ * @brief whether two first pass results (count, smooth count or negative marker) color alike, aa_same() in
+ * antialias.glsl; smooth coloring is continuous across a step of one, so that is no edge there
+ */
+inline bool aa_same_band(float count0, float mu0, float count1, float mu1, bool smooth) {
+    if (std::min(mu0, 0.0f) != std::min(mu1, 0.0f)) return false;
+    return smooth ? std::abs(count0 - count1) <= 1.0f : count0 == count1;
+}
+
+/**
+ * @brief 1 for every pixel with an 8-neighbour that same(i, j) says is in another band or basin, else 0
+ */
+template <typename Same>
+std::vector<std::uint8_t> aa_edges(std::size_t width, std::size_t height, Same&& same) {
+    std::vector<std::uint8_t> edges(width * height, 0);
+    for (std::size_t y = 0; y < height; y++) {
+        for (std::size_t x = 0; x < width; x++) {
+            const auto i = y * width + x;
+            for (std::size_t ny = y ? y - 1 : 0; ny <= std::min(y + 1, height - 1) && !edges[i]; ny++) {
+                for (std::size_t nx = x ? x - 1 : 0; nx <= std::min(x + 1, width - 1); nx++) {
+                    if (!same(i, ny * width + nx)) {
+                        edges[i] = 1;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return edges;
+}
+
+struct aa_stats {
+    std::size_t pixels = 0;
+    std::size_t edges = 0;
+    std::size_t samples = 0;
+
+    double edge_fraction() const { return pixels ? static_cast<double>(edges) / static_cast<double>(pixels) : 0.0; }
+    double mean_samples() const { return edges ? static_cast<double>(samples) / static_cast<double>(edges) : 0.0; }
+};
+
+/**
+ * @brief sample position (x + 0.5 + dx, y + 0.5 + dy) of supersample_edges_batched()
+ */
+struct aa_point {
+    std::uint32_t x;
+    std::uint32_t y;
+    float dx;
+    float dy;
+};
+
+/**
+ * @brief replace the color of every edge pixel by the mean of its jittered samples, like antialias()
+ * Samples come in batches of 4, 4, 8, 16, ... up to max_samples: the first batch ends a pixel if its colors
+ * agree within tolerance, every later one if it moved the mean by less than that; tolerance 0 always takes
+ * max_samples, which with every pixel an edge is plain supersampling.
+ * Each pool task takes one row and asks for the current batch of every unsettled edge pixel in it at once,
+ * so that a SIMD kernel gets full lanes; the samples and where each pixel stops do not depend on that.
+ * @param sample sample(points, count, colors) writes the color of each of the count points; called from the
+ * pool's threads
+ */
+template <typename Sample>
+aa_stats supersample_edges_batched(std::vector<std::array<float, 3>>& rgb, std::size_t width, std::size_t height,
+                                   const std::vector<std::uint8_t>& edges, Sample&& sample, work_stealing_pool& pool,
+                                   std::uint32_t max_samples = aa_max_samples,
+                                   float tolerance = aa_default_tolerance) {
+    max_samples = std::clamp(max_samples, aa_min_samples, aa_max_samples);
+    std::vector<std::size_t> row_edges(height, 0);
+    std::vector<std::size_t> row_samples(height, 0);
+
+    struct pixel_state {
+        std::size_t x;
+        std::uint32_t n = 0;
+        std::array<float, 3> sum{}, lo, hi, mean{};
+    };
+
+    pool.parallel_for(height, [&](std::size_t y) {
+        std::vector<pixel_state> active;
+        for (std::size_t x = 0; x < width; x++) {
+            if (!edges[y * width + x]) continue;
+            auto& p = active.emplace_back();
+            p.x = x;
+            p.lo.fill(HUGE_VALF);
+            p.hi.fill(-HUGE_VALF);
+        }
+        row_edges[y] = active.size();
+
+        std::vector<aa_point> points;
+        std::vector<std::array<float, 3>> colors;
+        while (!active.empty()) {
+            points.clear();
+            for (const auto& p : active) {
+                const auto end = std::min(std::max(p.n * 2, aa_min_samples), max_samples);
+                for (auto i = p.n; i < end; i++) {
+                    const auto [dx, dy] = aa_offset(i, static_cast<std::uint32_t>(p.x), static_cast<std::uint32_t>(y));
+                    points.push_back({static_cast<std::uint32_t>(p.x), static_cast<std::uint32_t>(y), dx, dy});
+                }
+            }
+            colors.resize(points.size());
+            sample(points.data(), points.size(), colors.data());
+
+            std::size_t next = 0;
+            std::size_t kept = 0;
+            for (auto& p : active) {
+                const auto end = std::min(std::max(p.n * 2, aa_min_samples), max_samples);
+                for (; p.n < end; p.n++) {
+                    const auto& c = colors[next++];
+                    for (int k = 0; k < 3; k++) {
+                        p.sum[k] += c[k];
+                        p.lo[k] = std::min(p.lo[k], c[k]);
+                        p.hi[k] = std::max(p.hi[k], c[k]);
+                    }
+                }
+                bool settled = true;
+                for (int k = 0; k < 3; k++) {
+                    const float mean = p.sum[k] / static_cast<float>(p.n);
+                    const float change = p.n <= aa_min_samples ? p.hi[k] - p.lo[k] : std::abs(mean - p.mean[k]);
+                    settled = settled && change < tolerance;
+                    p.mean[k] = mean;
+                }
+                if (settled || p.n >= max_samples) {
+                    rgb[y * width + p.x] = p.mean;
+                    row_samples[y] += p.n;
+                } else {
+                    active[kept++] = p;
+                }
+            }
+            active.resize(kept);
+        }
+    });
+
+    aa_stats stats;
+    stats.pixels = width * height;
+    for (std::size_t y = 0; y < height; y++) {
+        stats.edges += row_edges[y];
+        stats.samples += row_samples[y];
+    }
+    return stats;
+}
+
+/**
+ * @brief supersample_edges_batched() with a sampler of one point at a time
+ * @param sample color at (x + 0.5 + dx, y + 0.5 + dy) for sample(x, y, dx, dy); called from the pool's threads
+ */
+template <typename Sample>
+aa_stats supersample_edges(std::vector<std::array<float, 3>>& rgb, std::size_t width, std::size_t height,
+                           const std::vector<std::uint8_t>& edges, Sample&& sample, work_stealing_pool& pool,
+                           std::uint32_t max_samples = aa_max_samples, float tolerance = aa_default_tolerance) {
+    const auto batch = [&](const aa_point* points, std::size_t count, std::array<float, 3>* colors) {
+        for (std::size_t i = 0; i < count; i++) {
+            colors[i] = sample(points[i].x, points[i].y, points[i].dx, points[i].dy);
+        }
+    };
+    return supersample_edges_batched(rgb, width, height, edges, batch, pool, max_samples, tolerance);
+}
+
+#endif  // PRACC_GL_ADAPTIVE_AA_H
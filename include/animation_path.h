@@ -0,0 +1,198 @@
+/**
+ * @file animation_path.h
+ * @brief keyframed view and parameter paths for the headless animation export
+ */
+
+#ifndef PRACC_GL_ANIMATION_PATH_H
+#define PRACC_GL_ANIMATION_PATH_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "include/big_fixed.h"
+#include "include/perturbation.h"
+
+/**
+ * @brief most roots / colors a keyframe may give, the largest root count the newton shader is built for
+ */
+constexpr std::size_t animation_max_roots = 16;
+
+/**
+ * @brief view and fractal parameters at one frame
+ * center is kept as decimal strings so that a deep zoom target keeps all its digits. Empty roots / colors
+ * leave the newton defaults alone.
+ */
+struct animation_key {
+    std::size_t frame = 0;
+    std::string center[2] = {"-0.5", "0"};
+    double scale = 1.5;
+    std::uint32_t max_iter = 1000;
+    std::array<double, 2> init = {0.5, 0.0};
+    std::vector<std::array<float, 2>> roots;
+    std::vector<std::array<float, 3>> colors;
+};
+
+/**
+ * @brief animation_key interpolated to one frame
+ */
+struct animation_frame {
+    big_fixed center[2] = {big_fixed(-0.5, 2), big_fixed(0.0, 2)};
+    double scale = 1.5;
+    std::uint32_t max_iter = 1000;
+    std::array<double, 2> init = {0.5, 0.0};
+    std::vector<std::array<float, 2>> roots;
+    std::vector<std::array<float, 3>> colors;
+};
+
+/**
+ * @brief keyframes, one per line, frames strictly increasing; # starts a comment
+ *     FRAME [center RE IM] [scale S] [iter N] [init RE IM] [roots N x y ...] [colors N r g b ...]
+ * Fields a line leaves out keep the value of the line before, the first line those of defaults, which each
+ * executable fills with its own initial view. N is at most animation_max_roots.
+ * @return std::nullopt after printing the offending line
+ */
+inline std::optional<std::vector<animation_key>> read_animation_path(std::istream& in, std::string_view name = "",
+                                                                     const animation_key& defaults = {}) {
+    std::vector<animation_key> keys;
+    animation_key key = defaults;
+    std::string line;
+    for (std::size_t number = 1; std::getline(in, line); number++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ss(line);
+        if (!(ss >> key.frame)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            std::cerr << name << ":" << number << ": expected a frame number" << std::endl;
+            return std::nullopt;
+        }
+
+        std::string field;
+        bool ok = true;
+        while (ok && ss >> field) {
+            // signed, so that -1 is an error instead of SIZE_MAX
+            long long n = 0;
+            if ((field == "roots" || field == "colors") && ss >> n &&
+                (n < 0 || static_cast<unsigned long long>(n) > animation_max_roots)) {
+                std::cerr << name << ":" << number << ": " << field << " must be 0 to " << animation_max_roots
+                          << ", not " << n << std::endl;
+                return std::nullopt;
+            }
+            if (field == "center") {
+                ok = static_cast<bool>(ss >> key.center[0] >> key.center[1]);
+            } else if (field == "scale") {
+                ok = ss >> key.scale && key.scale > 0.0;
+            } else if (field == "iter") {
+                ok = static_cast<bool>(ss >> key.max_iter);
+            } else if (field == "init") {
+                ok = static_cast<bool>(ss >> key.init[0] >> key.init[1]);
+            } else if (field == "roots" && ss) {
+                key.roots.assign(static_cast<std::size_t>(n), {});
+                for (auto& r : key.roots) ok = ok && ss >> r[0] >> r[1];
+            } else if (field == "colors" && ss) {
+                key.colors.assign(static_cast<std::size_t>(n), {});
+                for (auto& c : key.colors) ok = ok && ss >> c[0] >> c[1] >> c[2];
+            } else {
+                ok = false;
+            }
+        }
+        if (!ok || (!keys.empty() && key.frame <= keys.back().frame)) {
+            std::cerr << name << ":" << number << ": bad keyframe" << std::endl;
+            return std::nullopt;
+        }
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+inline std::optional<std::vector<animation_key>> load_animation_path(const std::string& path,
+                                                                     const animation_key& defaults = {}) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "failed to open " << path << std::endl;
+        return std::nullopt;
+    }
+    return read_animation_path(in, path, defaults);
+}
+
+/**
+ * @brief frames up to and including the last keyframe
+ */
+inline std::size_t animation_length(const std::vector<animation_key>& keys) {
+    return keys.empty() ? 1 : keys.back().frame + 1;
+}
+
+/**
+ * @brief limbs that hold a keyframe center for scale down to one pixel of a 64k pixel wide frame
+ */
+inline std::size_t animation_limbs(double scale) { return deep_limbs(scale, std::size_t{1} << 16); }
+
+/**
+ * @brief the path at frame, held at the first and last keyframe outside of them
+ * scale is interpolated geometrically, so a zoom runs at a constant rate. The center moves in step with the
+ * scale toward the key with the smaller scale: a zoom target stays where it is on screen and drifts to the
+ * middle over the last few halvings. The offset is computed from the scale difference to that key, so it
+ * stays exact at depths where a plain lerp of the centers would round it away.
+ * iter, init, roots and colors are linear; roots / colors of different counts switch at the next key.
+ * Only the frame number goes in, so every frame can be rendered on its own and in any order.
+ */
+inline animation_frame sample_animation(const std::vector<animation_key>& keys, std::size_t frame) {
+    if (keys.empty()) return {};
+
+    const auto next = std::upper_bound(keys.begin(), keys.end(), frame,
+                                       [](std::size_t f, const animation_key& k) { return f < k.frame; });
+    const auto& k0 = next == keys.begin() ? *next : *(next - 1);
+    const auto& k1 = next == keys.end() ? k0 : *next;
+    const double t = &k0 == &k1 || frame <= k0.frame
+                         ? 0.0
+                         : static_cast<double>(frame - k0.frame) / static_cast<double>(k1.frame - k0.frame);
+
+    const auto limbs = animation_limbs(std::min(k0.scale, k1.scale));
+    animation_frame ret;
+    ret.scale = t == 0.0 ? k0.scale : std::exp(std::lerp(std::log(k0.scale), std::log(k1.scale), t));
+    ret.max_iter = static_cast<std::uint32_t>(
+        std::lround(std::lerp(static_cast<double>(k0.max_iter), static_cast<double>(k1.max_iter), t)));
+    for (int i = 0; i < 2; i++) {
+        const auto c0 = big_fixed::from_string(k0.center[i], limbs);
+        const auto c1 = big_fixed::from_string(k1.center[i], limbs);
+        ret.init[i] = std::lerp(k0.init[i], k1.init[i], t);
+        if (t == 0.0) {
+            ret.center[i] = c0;
+        } else if (k0.scale == k1.scale) {
+            ret.center[i] = c0 + (c1 - c0) * big_fixed(t, limbs);
+        } else {
+            // anchored at the smaller scale a: c = c_a + (c_b - c_a) (s - s_a) / (s_b - s_a)
+            const bool in = k1.scale < k0.scale;
+            const auto& ca = in ? c1 : c0;
+            const auto& cb = in ? c0 : c1;
+            const double sa = in ? k1.scale : k0.scale;
+            const double sb = in ? k0.scale : k1.scale;
+            ret.center[i] = ca + (cb - ca) * big_fixed((ret.scale - sa) / (sb - sa), limbs);
+        }
+    }
+
+    const auto tf = static_cast<float>(t);
+    ret.roots = k0.roots;
+    if (k0.roots.size() == k1.roots.size()) {
+        for (std::size_t i = 0; i < ret.roots.size(); i++) {
+            for (int k = 0; k < 2; k++) ret.roots[i][k] = std::lerp(k0.roots[i][k], k1.roots[i][k], tf);
+        }
+    }
+    ret.colors = k0.colors;
+    if (k0.colors.size() == k1.colors.size()) {
+        for (std::size_t i = 0; i < ret.colors.size(); i++) {
+            for (int k = 0; k < 3; k++) ret.colors[i][k] = std::lerp(k0.colors[i][k], k1.colors[i][k], tf);
+        }
+    }
+    return ret;
+}
+
+#endif  // PRACC_GL_ANIMATION_PATH_H
@@ -0,0 +1,250 @@
+/**
+ * @file big_fixed.h
+ * @brief arbitrary precision signed fixed point number for reference orbits
+ */
+
+#ifndef PRACC_GL_BIG_FIXED_H
+#define PRACC_GL_BIG_FIXED_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class big_fixed
+ * @brief sign + magnitude, limbs_[0] is the integer part and limbs_[i] weighs 2^(-32 i)
+ * Only what a mandelbrot orbit needs (|x| < 2^32): add, sub, mul, conversions.
+ * Results take the precision of the left operand; lower bits are truncated.
+ */
+class big_fixed {
+private:
+    bool neg_ = false;
+    std::vector<std::uint32_t> limbs_;
+
+    static int compare_magnitude(const big_fixed& x, const big_fixed& y) {
+        const auto n = std::max(x.limbs_.size(), y.limbs_.size());
+        for (std::size_t i = 0; i < n; i++) {
+            const auto a = x.limb(i);
+            const auto b = y.limb(i);
+            if (a != b) return a < b ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // |x| + |y| into x, keeping x's precision
+    static void add_magnitude(big_fixed& x, const big_fixed& y) {
+        std::uint64_t carry = 0;
+        for (auto i = x.limbs_.size(); i-- > 0;) {
+            const std::uint64_t s = std::uint64_t{x.limbs_[i]} + y.limb(i) + carry;
+            x.limbs_[i] = static_cast<std::uint32_t>(s);
+            carry = s >> 32;
+        }
+    }
+
+    // |x| - |y| into x, requires |x| >= |y|
+    static void sub_magnitude(big_fixed& x, const big_fixed& y) {
+        std::int64_t borrow = 0;
+        for (auto i = x.limbs_.size(); i-- > 0;) {
+            std::int64_t d = std::int64_t{x.limbs_[i]} - y.limb(i) - borrow;
+            borrow = d < 0;
+            if (borrow) d += std::int64_t{1} << 32;
+            x.limbs_[i] = static_cast<std::uint32_t>(d);
+        }
+    }
+
+    // |y| - |x| into x, requires |y| >= |x|
+    static void rsub_magnitude(big_fixed& x, const big_fixed& y) {
+        std::int64_t borrow = 0;
+        for (auto i = x.limbs_.size(); i-- > 0;) {
+            std::int64_t d = std::int64_t{y.limb(i)} - x.limbs_[i] - borrow;
+            borrow = d < 0;
+            if (borrow) d += std::int64_t{1} << 32;
+            x.limbs_[i] = static_cast<std::uint32_t>(d);
+        }
+    }
+
+    void add_signed(const big_fixed& y, bool y_neg) {
+        if (neg_ == y_neg) {
+            add_magnitude(*this, y);
+        } else if (compare_magnitude(*this, y) >= 0) {
+            sub_magnitude(*this, y);
+        } else {
+            rsub_magnitude(*this, y);
+            neg_ = y_neg;
+        }
+        if (is_zero()) neg_ = false;
+    }
+
+public:
+    /**
+     * @param limbs total limb count including the integer limb
+     */
+    explicit big_fixed(std::size_t limbs = 2) : limbs_(std::max<std::size_t>(limbs, 1), 0) {}
+
+    big_fixed(double x, std::size_t limbs) : big_fixed(limbs) {
+        neg_ = x < 0;
+        x = std::fabs(x);
+        for (auto& l : limbs_) {
+            const double whole = std::floor(x);
+            l = static_cast<std::uint32_t>(whole);
+            x = (x - whole) * 4294967296.0;
+        }
+        if (is_zero()) neg_ = false;
+    }
+
+    /**
+     * @brief parse a decimal like "-0.743643887037158704752191506114774"
+     */
+    static big_fixed from_string(std::string_view str, std::size_t limbs) {
+        big_fixed ret(limbs);
+        bool neg = false;
+        if (!str.empty() && (str.front() == '-' || str.front() == '+')) {
+            neg = str.front() == '-';
+            str.remove_prefix(1);
+        }
+
+        const auto dot = str.find('.');
+        const auto int_part = str.substr(0, dot);
+        const auto frac_part = dot == std::string_view::npos ? std::string_view{} : str.substr(dot + 1);
+
+        // fraction from the last digit backwards: x = (x + d) / 10
+        for (auto i = frac_part.size(); i-- > 0;) {
+            if (frac_part[i] < '0' || frac_part[i] > '9') continue;
+            ret.limbs_[0] += static_cast<std::uint32_t>(frac_part[i] - '0');
+            ret.div_small(10);
+        }
+
+        std::uint32_t whole = 0;
+        for (const auto ch : int_part) {
+            if (ch >= '0' && ch <= '9') whole = whole * 10 + static_cast<std::uint32_t>(ch - '0');
+        }
+        ret.limbs_[0] = whole;
+        ret.neg_ = neg && !ret.is_zero();
+        return ret;
+    }
+
+    std::size_t limbs() const { return limbs_.size(); }
+    bool negative() const { return neg_; }
+
+    std::uint32_t limb(std::size_t i) const { return i < limbs_.size() ? limbs_[i] : 0; }
+
+    bool is_zero() const {
+        for (const auto l : limbs_) {
+            if (l) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief same value with a different limb count (truncates or zero-extends)
+     */
+    big_fixed with_limbs(std::size_t limbs) const {
+        big_fixed ret(limbs);
+        for (std::size_t i = 0; i < ret.limbs_.size(); i++) ret.limbs_[i] = limb(i);
+        ret.neg_ = neg_ && !ret.is_zero();
+        return ret;
+    }
+
+    void div_small(std::uint32_t d) {
+        std::uint64_t rem = 0;
+        for (auto& l : limbs_) {
+            const std::uint64_t cur = (rem << 32) | l;
+            l = static_cast<std::uint32_t>(cur / d);
+            rem = cur % d;
+        }
+    }
+
+    double to_double() const {
+        double ret = 0.0;
+        double w = 1.0;
+        for (std::size_t i = 0; i < limbs_.size() && i < 4; i++) {
+            ret += limbs_[i] * w;
+            w /= 4294967296.0;
+        }
+        return neg_ ? -ret : ret;
+    }
+
+    /**
+     * @brief decimal representation with digits fraction digits (truncated)
+     */
+    std::string to_string(std::size_t digits) const {
+        std::string ret = neg_ ? "-" : "";
+        ret += std::to_string(limbs_[0]);
+        ret += '.';
+
+        auto frac = *this;
+        frac.limbs_[0] = 0;
+        for (std::size_t d = 0; d < digits; d++) {
+            std::uint64_t carry = 0;
+            for (auto i = frac.limbs_.size(); i-- > 0;) {
+                const std::uint64_t p = std::uint64_t{frac.limbs_[i]} * 10 + carry;
+                frac.limbs_[i] = static_cast<std::uint32_t>(p);
+                carry = p >> 32;
+            }
+            ret += static_cast<char>('0' + frac.limbs_[0]);
+            frac.limbs_[0] = 0;
+        }
+        return ret;
+    }
+
+    big_fixed& operator+=(const big_fixed& y) {
+        add_signed(y, y.neg_);
+        return *this;
+    }
+
+    big_fixed& operator-=(const big_fixed& y) {
+        add_signed(y, !y.neg_);
+        return *this;
+    }
+
+    big_fixed& operator*=(const big_fixed& y) {
+        const auto n = limbs_.size();
+        const auto m = y.limbs_.size();
+        // product[k] weighs 2^(-32 (k - 1)); everything below limb n is only kept for its carries
+        std::vector<std::uint64_t> product(n + m, 0);
+        for (std::size_t i = 0; i < n; i++) {
+            std::uint64_t carry = 0;
+            for (std::size_t j = m; j-- > 0;) {
+                const std::uint64_t p = std::uint64_t{limbs_[i]} * y.limbs_[j] + product[i + j + 1] + carry;
+                product[i + j + 1] = p & 0xffffffffu;
+                carry = p >> 32;
+            }
+            product[i] += carry;
+        }
+        for (auto k = n + m; k-- > 1;) {
+            product[k - 1] += product[k] >> 32;
+            product[k] &= 0xffffffffu;
+        }
+        // product[0] is the 2^32 digit, it overflows the integer limb and is dropped
+        for (std::size_t i = 0; i < n; i++) limbs_[i] = static_cast<std::uint32_t>(product[i + 1]);
+        neg_ = (neg_ != y.neg_) && !is_zero();
+        return *this;
+    }
+
+    big_fixed operator-() const {
+        auto ret = *this;
+        ret.neg_ = !neg_ && !is_zero();
+        return ret;
+    }
+};
+
+inline big_fixed operator+(big_fixed x, const big_fixed& y) {
+    x += y;
+    return x;
+}
+
+inline big_fixed operator-(big_fixed x, const big_fixed& y) {
+    x -= y;
+    return x;
+}
+
+inline big_fixed operator*(big_fixed x, const big_fixed& y) {
+    x *= y;
+    return x;
+}
+
+#endif  // PRACC_GL_BIG_FIXED_H
@@ -0,0 +1,70 @@
+/**
+ * @file bounded_queue.h
+ * @brief blocking fixed-capacity queue between render and I/O threads
+ */
+
+#ifndef PRACC_GL_BOUNDED_QUEUE_H
+#define PRACC_GL_BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+/**
+ * @class bounded_queue
+ * @brief push blocks while full, pop blocks while empty; close() wakes everyone and makes pop drain then fail
+ * The capacity bounds how much memory the producer can run ahead by.
+ */
+template <typename Tp>
+class bounded_queue {
+private:
+    std::size_t capacity_;
+    std::deque<Tp> items_;
+    std::mutex mtx_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    bool closed_ = false;
+
+public:
+    explicit bounded_queue(std::size_t capacity) : capacity_{capacity ? capacity : 1} {}
+
+    /**
+     * @return false if the queue was closed
+     */
+    bool push(Tp item) {
+        std::unique_lock lock(mtx_);
+        not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @return std::nullopt once closed and empty
+     */
+    std::optional<Tp> pop() {
+        std::unique_lock lock(mtx_);
+        not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return std::nullopt;
+        auto item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return item;
+    }
+
+    void close() {
+        {
+            std::lock_guard lock(mtx_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+};
+
+#endif  // PRACC_GL_BOUNDED_QUEUE_H
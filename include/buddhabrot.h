@@ -0,0 +1,413 @@
+/**
+ * @file buddhabrot.h
+ * @brief orbit density renders (buddhabrot / anti-buddhabrot): Metropolis-Hastings sampling of c, per-worker
+ * histograms and resumable checkpoints
+ */
+
+#ifndef PRACC_GL_BUDDHABROT_H
+#define PRACC_GL_BUDDHABROT_H
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <numbers>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "include/escape_time.h"
+#include "include/palette.h"
+#include "include/thread_pool.h"
+
+/**
+ * @brief what is drawn and how c is sampled
+ * The buddhabrot draws the orbits that escape after at least min_iter steps, the anti-buddhabrot the ones
+ * that do not escape within max_iter. With metropolis, each chain proposes a c drawn uniformly from the
+ * domain with probability large_step, else its current c moved by a normal step of mutation * view scale.
+ */
+struct buddhabrot_params {
+    std::uint32_t max_iter = 1000;
+    std::uint32_t min_iter = 0;
+    bool anti = false;
+    bool metropolis = true;
+    float large_step = 0.2f;
+    float mutation = 0.05f;
+    std::uint64_t seed = 1;
+};
+
+/**
+ * @brief c is sampled from [-domain, domain]^2, which holds the whole set
+ */
+constexpr float buddhabrot_domain = 2.0f;
+
+/**
+ * @brief splitmix64: one word of state, so that a checkpoint can hold every chain's generator
+ */
+struct buddhabrot_rng {
+    std::uint64_t state = 0;
+
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // [0, 1)
+    float uniform() { return static_cast<float>(next() >> 40) * 0x1p-24f; }
+
+    // standard normal, Box-Muller
+    float normal() {
+        const double u = static_cast<double>((next() >> 11) + 1) * 0x1p-53;
+        const double v = static_cast<double>(next() >> 11) * 0x1p-53;
+        return static_cast<float>(std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * std::numbers::pi * v));
+    }
+};
+
+/**
+ * @class padded_histograms
+ * @brief one histogram of doubles per worker, each starting on a cache line of its own
+ * A worker only ever adds to its own histogram, so there is no lock and no false sharing at the seams;
+ * merge() sums them when the image is needed.
+ */
+class padded_histograms {
+public:
+    static constexpr std::size_t cache_line = 64;
+
+private:
+    struct aligned_delete {
+        void operator()(double* p) const { ::operator delete[](p, std::align_val_t{cache_line}); }
+    };
+
+    std::size_t count_;
+    std::size_t bins_;
+    std::size_t stride_;
+    std::unique_ptr<double[], aligned_delete> data_;
+
+public:
+    padded_histograms(std::size_t count, std::size_t bins)
+        : count_{count}, bins_{bins}, stride_{(bins * sizeof(double) + cache_line - 1) / cache_line * cache_line /
+                                              sizeof(double)} {
+        const auto size = std::max<std::size_t>(count_ * stride_, 1);
+        data_.reset(static_cast<double*>(::operator new[](size * sizeof(double), std::align_val_t{cache_line})));
+        std::fill_n(data_.get(), size, 0.0);
+    }
+
+    std::size_t count() const { return count_; }
+    std::size_t bins() const { return bins_; }
+    double* operator[](std::size_t i) { return data_.get() + i * stride_; }
+    const double* operator[](std::size_t i) const { return data_.get() + i * stride_; }
+
+    /**
+     * @brief bin-wise sum over every histogram; each pool task sums its own range of bins
+     */
+    std::vector<double> merge(work_stealing_pool& pool) const {
+        std::vector<double> ret(bins_, 0.0);
+        constexpr std::size_t chunk = 1 << 14;
+        pool.parallel_for((bins_ + chunk - 1) / chunk, [&](std::size_t t) {
+            const auto end = std::min((t + 1) * chunk, bins_);
+            for (std::size_t h = 0; h < count_; h++) {
+                const auto* src = (*this)[h];
+                for (auto i = t * chunk; i < end; i++) ret[i] += src[i];
+            }
+        });
+        return ret;
+    }
+};
+
+/**
+ * @brief plane -> histogram bin, the inverse of the pixel mapping of escape_view (without pan)
+ */
+class buddhabrot_bins {
+private:
+    float k_;
+    float offset_[2];
+    std::size_t width_;
+    std::size_t height_;
+
+public:
+    buddhabrot_bins(const escape_view& view, std::size_t width, std::size_t height)
+        : k_{static_cast<float>(std::min(width, height)) / (2.0f * view.scale)},
+          offset_{static_cast<float>(width) / 2.0f - view.center[0] * k_,
+                  static_cast<float>(height) / 2.0f - view.center[1] * k_},
+          width_{width}, height_{height} {}
+
+    /**
+     * @brief append the bin of (re, im) to bins if it is in the image
+     */
+    void add(float re, float im, std::vector<std::uint32_t>& bins) const {
+        const float x = re * k_ + offset_[0];
+        const float y = im * k_ + offset_[1];
+        if (!(x >= 0.0f && y >= 0.0f && x < static_cast<float>(width_) && y < static_cast<float>(height_))) return;
+        bins.push_back(static_cast<std::uint32_t>(static_cast<std::size_t>(y) * width_ + static_cast<std::size_t>(x)));
+    }
+};
+
+/**
+ * @brief bins of the orbit c, z_1, z_2, ... of mandelbrot() that lie in the image, if the orbit is drawn
+ * Same escape_step() and |z|^2 > 4 test as escape_time_scalar(). A c in the main cardioid or the period-2
+ * bulb never escapes, so the buddhabrot rejects it without iterating.
+ * @return whether the orbit is drawn; bins is left empty if not
+ */
+inline bool buddhabrot_orbit(const buddhabrot_params& param, const buddhabrot_bins& map, float cr, float ci,
+                             std::vector<std::uint32_t>& bins) {
+    bins.clear();
+    if (!param.anti && (in_main_cardioid(cr, ci) || in_period2_bulb(cr, ci))) return false;
+
+    float zr = cr;
+    float zi = ci;
+    map.add(zr, zi, bins);
+    std::uint32_t i = 0;
+    for (; i < param.max_iter; i++) {
+        escape_step(zr, zi, cr, ci);
+        if (zr * zr + zi * zi > 4.0f) break;
+        map.add(zr, zi, bins);
+    }
+
+    const bool escaped = i < param.max_iter;
+    const bool drawn = param.anti ? !escaped : escaped && i >= param.min_iter;
+    if (!drawn) bins.clear();
+    return drawn;
+}
+
+/**
+ * @brief state of one sampling chain; contribution is the number of in-image orbit points of c, 0 until the
+ * chain has found a c that is drawn there
+ */
+struct buddhabrot_chain {
+    buddhabrot_rng rng;
+    float c[2] = {};
+    double contribution = 0.0;
+    std::uint64_t samples = 0;
+    std::uint64_t accepted = 0;
+    std::vector<std::uint32_t> bins;
+    std::vector<std::uint32_t> proposal;
+};
+
+/**
+ * @class buddhabrot_renderer
+ * @brief orbit density of a view, accumulated over any number of run() calls and checkpoints
+ * Every chain adds to its own padded histogram. With metropolis the chain samples c in proportion to its
+ * contribution f(c) and adds each visited orbit with weight 1 / f(c), which keeps the image that of c drawn
+ * uniformly while spending the samples on the orbits that reach the view. Uniform sampling adds weight 1
+ * per orbit point instead, so the two modes differ by a constant factor only.
+ */
+class buddhabrot_renderer {
+private:
+    buddhabrot_params param_;
+    escape_view view_;
+    std::size_t width_;
+    std::size_t height_;
+    buddhabrot_bins map_;
+    std::vector<buddhabrot_chain> chains_;
+    padded_histograms histograms_;
+
+    static bool write_all(int fd, const void* data, std::size_t size) {
+        const auto* p = static_cast<const char*>(data);
+        for (std::size_t done = 0; done < size;) {
+            const auto n = ::write(fd, p + done, size - done);
+            if (n <= 0) return false;
+            done += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    static bool read_all(int fd, void* data, std::size_t size) {
+        auto* p = static_cast<char*>(data);
+        for (std::size_t done = 0; done < size;) {
+            const auto n = ::read(fd, p + done, size - done);
+            if (n <= 0) return false;
+            done += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    void step(buddhabrot_chain& chain, double* histogram) const {
+        float c[2];
+        if (!param_.metropolis || chain.contribution == 0.0 || chain.rng.uniform() < param_.large_step) {
+            c[0] = (chain.rng.uniform() * 2.0f - 1.0f) * buddhabrot_domain;
+            c[1] = (chain.rng.uniform() * 2.0f - 1.0f) * buddhabrot_domain;
+        } else {
+            c[0] = chain.c[0] + chain.rng.normal() * param_.mutation * view_.scale;
+            c[1] = chain.c[1] + chain.rng.normal() * param_.mutation * view_.scale;
+        }
+        chain.samples++;
+
+        // outside the domain the target is 0, which keeps the proposal symmetric
+        const bool inside = std::abs(c[0]) <= buddhabrot_domain && std::abs(c[1]) <= buddhabrot_domain;
+        if (!inside || !buddhabrot_orbit(param_, map_, c[0], c[1], chain.proposal) || chain.proposal.empty()) {
+            if (param_.metropolis && chain.contribution > 0.0) {
+                for (const auto b : chain.bins) histogram[b] += 1.0 / chain.contribution;
+            }
+            return;
+        }
+
+        if (!param_.metropolis) {
+            for (const auto b : chain.proposal) histogram[b] += 1.0;
+            return;
+        }
+
+        const auto f = static_cast<double>(chain.proposal.size());
+        if (chain.contribution == 0.0 || static_cast<double>(chain.rng.uniform()) * chain.contribution < f) {
+            chain.c[0] = c[0];
+            chain.c[1] = c[1];
+            chain.contribution = f;
+            chain.bins.swap(chain.proposal);
+            chain.accepted++;
+        }
+        for (const auto b : chain.bins) histogram[b] += 1.0 / chain.contribution;
+    }
+
+public:
+    /**
+     * @param chains independent chains, each with its own histogram; normally the pool's size
+     */
+    buddhabrot_renderer(const buddhabrot_params& param, const escape_view& view, std::size_t width,
+                        std::size_t height, std::size_t chains)
+        : param_{param}, view_{view}, width_{width}, height_{height}, map_{view, width, height},
+          chains_(std::max<std::size_t>(chains, 1)), histograms_{chains_.size(), width * height} {
+        for (std::size_t i = 0; i < chains_.size(); i++) {
+            chains_[i].rng.state = param_.seed * 0x2545f4914f6cdd1dull + i * 0x9e3779b97f4a7c15ull;
+        }
+    }
+
+    std::size_t width() const { return width_; }
+    std::size_t height() const { return height_; }
+
+    std::uint64_t samples() const {
+        std::uint64_t ret = 0;
+        for (const auto& c : chains_) ret += c.samples;
+        return ret;
+    }
+
+    std::uint64_t accepted() const {
+        std::uint64_t ret = 0;
+        for (const auto& c : chains_) ret += c.accepted;
+        return ret;
+    }
+
+    /**
+     * @brief take samples more samples, split evenly over the chains, one pool task per chain
+     */
+    void run(work_stealing_pool& pool, std::uint64_t samples) {
+        const auto n = chains_.size();
+        pool.parallel_for(n, [&](std::size_t i) {
+            const auto count = samples / n + (i < samples % n ? 1 : 0);
+            auto& chain = chains_[i];
+            auto* histogram = histograms_[i];
+            for (std::uint64_t s = 0; s < count; s++) step(chain, histogram);
+        });
+    }
+
+    /**
+     * @brief sum of every chain's histogram, row 0 at the bottom like escape_buffer
+     */
+    std::vector<double> density(work_stealing_pool& pool) const { return histograms_.merge(pool); }
+
+    /**
+     * @brief one line naming everything a checkpoint must match to be resumed
+     */
+    std::string identity() const {
+        std::ostringstream out;
+        out.precision(9);
+        out << "buddhabrot 1 " << width_ << ' ' << height_ << ' ' << view_.scale << ' ' << view_.center[0] << ' '
+            << view_.center[1] << ' ' << param_.max_iter << ' ' << param_.min_iter << ' ' << param_.anti << ' '
+            << param_.metropolis << ' ' << param_.large_step << ' ' << param_.mutation << ' ' << param_.seed << ' '
+            << chains_.size();
+        return out.str();
+    }
+
+    /**
+     * @brief write the chains and the merged density to path, through path.tmp and a rename, so that a crash
+     * while writing leaves the previous checkpoint intact
+     * The file is the identity line followed by the state in native byte order.
+     */
+    bool save(const std::string& path, work_stealing_pool& pool) const {
+        const auto tmp = path + ".tmp";
+        const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+
+        const auto text = identity() + '\n';
+        bool ok = write_all(fd, text.data(), text.size());
+        for (const auto& c : chains_) {
+            ok = ok && write_all(fd, &c.rng.state, sizeof(c.rng.state)) && write_all(fd, c.c, sizeof(c.c)) &&
+                 write_all(fd, &c.contribution, sizeof(c.contribution)) &&
+                 write_all(fd, &c.samples, sizeof(c.samples)) && write_all(fd, &c.accepted, sizeof(c.accepted));
+        }
+        const auto d = density(pool);
+        ok = ok && write_all(fd, d.data(), d.size() * sizeof(double));
+        ok = ::fdatasync(fd) == 0 && ok;
+        ok = ::close(fd) == 0 && ok;
+        ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+        if (!ok) std::remove(tmp.c_str());
+        return ok;
+    }
+
+    /**
+     * @brief continue from the checkpoint at path if it was written for the same identity()
+     * The saved density goes into the first histogram; the chains pick up where they stopped.
+     * @return false, with the renderer unchanged, if there is no matching checkpoint
+     */
+    bool load(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        const auto text = identity() + '\n';
+        std::string head(text.size(), '\0');
+        auto chains = chains_;
+        std::vector<double> d(width_ * height_);
+        bool ok = read_all(fd, head.data(), head.size()) && head == text;
+        for (auto& c : chains) {
+            ok = ok && read_all(fd, &c.rng.state, sizeof(c.rng.state)) && read_all(fd, c.c, sizeof(c.c)) &&
+                 read_all(fd, &c.contribution, sizeof(c.contribution)) &&
+                 read_all(fd, &c.samples, sizeof(c.samples)) && read_all(fd, &c.accepted, sizeof(c.accepted));
+        }
+        ok = ok && read_all(fd, d.data(), d.size() * sizeof(double));
+        char extra;
+        ok = ok && ::read(fd, &extra, 1) == 0;
+        ::close(fd);
+        if (!ok) return false;
+
+        // the orbits are not saved, only the c they come from
+        for (auto& c : chains) {
+            if (c.contribution > 0.0) buddhabrot_orbit(param_, map_, c.c[0], c.c[1], c.bins);
+        }
+        chains_ = std::move(chains);
+        for (std::size_t h = 0; h < histograms_.count(); h++) std::fill_n(histograms_[h], d.size(), 0.0);
+        std::copy(d.begin(), d.end(), histograms_[0]);
+        return true;
+    }
+};
+
+/**
+ * @brief colors of a density: the square root of it over its 99.9th percentile through lut, black where no
+ * orbit went
+ */
+inline std::vector<std::array<float, 3>> colorize_buddhabrot(const std::vector<double>& density,
+                                                             const palette_lut& lut) {
+    std::vector<double> nonzero;
+    for (const auto d : density) {
+        if (d > 0.0) nonzero.push_back(d);
+    }
+    std::vector<std::array<float, 3>> rgb(density.size());
+    if (nonzero.empty()) return rgb;
+
+    const auto k = std::min(nonzero.size() - 1, nonzero.size() * 999 / 1000);
+    std::nth_element(nonzero.begin(), nonzero.begin() + static_cast<std::ptrdiff_t>(k), nonzero.end());
+    const auto reference = nonzero[k];
+    for (std::size_t i = 0; i < density.size(); i++) {
+        if (density[i] > 0.0) rgb[i] = lut.sample(static_cast<float>(std::min(std::sqrt(density[i] / reference), 1.0)));
+    }
+    return rgb;
+}
+
+#endif  // PRACC_GL_BUDDHABROT_H
@@ -0,0 +1,501 @@
+/**
+ * @file double_double.h
+ * @brief double-double and quad-double arithmetic from error-free transformations, for zooms past double
+ */
+
+#ifndef PRACC_GL_DOUBLE_DOUBLE_H
+#define PRACC_GL_DOUBLE_DOUBLE_H
+
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+
+#include "include/big_fixed.h"
+#include "include/simd_batch.h"
+
+// Error-free transformations: the rounded result plus the exact error, so that value + err == the exact result.
+// They rely on round to nearest and must not be reassociated, so never build this with -ffast-math.
+// T is a floating point type or a simd<T, N> of one.
+
+/**
+ * @brief s + err == a + b exactly
+ */
+template <typename T>
+constexpr T two_sum(const T& a, const T& b, T& err) {
+    const T s = a + b;
+    const T bb = s - a;
+    err = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+/**
+ * @brief two_sum for |a| >= |b|, three operations instead of six
+ */
+template <typename T>
+constexpr T quick_two_sum(const T& a, const T& b, T& err) {
+    const T s = a + b;
+    err = b - (s - a);
+    return s;
+}
+
+/**
+ * @brief p + err == a * b exactly; the error is what fma(a, b, -p) leaves
+ */
+template <typename T>
+inline T two_prod(const T& a, const T& b, T& err) {
+    using std::fma;
+    const T p = a * b;
+    err = fma(a, b, -p);
+    return p;
+}
+
+/**
+ * @class double_double
+ * @brief unevaluated sum hi + lo with |lo| <= ulp(hi) / 2, about 106 bits for T = double
+ * With T = simd<double, N> it holds N independent values and every operation works lane by lane, which is
+ * what the batched kernels iterate. Comparisons are only provided for scalar T.
+ */
+template <typename T>
+class double_double {
+private:
+    T hi_;
+    T lo_;
+
+    static constexpr double_double renormalized(const T& hi, const T& lo) {
+        T err{};
+        const T s = quick_two_sum(hi, lo, err);
+        return {s, err};
+    }
+
+public:
+    using value_type = T;
+
+    constexpr double_double(T hi = T{}, T lo = T{}) : hi_{hi}, lo_{lo} {}
+
+    constexpr T hi() const { return hi_; }
+    constexpr T lo() const { return lo_; }
+
+    double_double& operator+=(const double_double& x) {
+        T e1{};
+        T e2{};
+        T s = two_sum(hi_, x.hi_, e1);
+        const T t = two_sum(lo_, x.lo_, e2);
+        e1 += t;
+        s = quick_two_sum(s, e1, e1);
+        e1 += e2;
+        return *this = renormalized(s, e1);
+    }
+
+    double_double& operator+=(const T& x) {
+        T e{};
+        const T s = two_sum(hi_, x, e);
+        e += lo_;
+        return *this = renormalized(s, e);
+    }
+
+    double_double& operator-=(const double_double& x) { return *this += -x; }
+    double_double& operator-=(const T& x) { return *this += -x; }
+
+    double_double& operator*=(const double_double& x) {
+        T e{};
+        const T p = two_prod(hi_, x.hi_, e);
+        e += hi_ * x.lo_ + lo_ * x.hi_;
+        return *this = renormalized(p, e);
+    }
+
+    double_double& operator*=(const T& x) {
+        T e{};
+        const T p = two_prod(hi_, x, e);
+        e += lo_ * x;
+        return *this = renormalized(p, e);
+    }
+
+    // long division: one quotient term per step from the leading parts, the remainder recomputed exactly
+    double_double& operator/=(const double_double& x) {
+        const T q1 = hi_ / x.hi_;
+        auto r = *this - x * q1;
+        const T q2 = r.hi_ / x.hi_;
+        r -= x * q2;
+        const T q3 = r.hi_ / x.hi_;
+        return *this = renormalized(q1, q2) + q3;
+    }
+
+    double_double& operator/=(const T& x) { return *this /= double_double{x}; }
+
+    friend double_double operator+(double_double x, const double_double& y) { return x += y; }
+    friend double_double operator+(double_double x, const T& y) { return x += y; }
+    friend double_double operator+(const T& x, double_double y) { return y += x; }
+    friend double_double operator-(double_double x, const double_double& y) { return x -= y; }
+    friend double_double operator-(double_double x, const T& y) { return x -= y; }
+    friend double_double operator-(const T& x, const double_double& y) { return -y + x; }
+    friend double_double operator*(double_double x, const double_double& y) { return x *= y; }
+    friend double_double operator*(double_double x, const T& y) { return x *= y; }
+    friend double_double operator*(const T& x, double_double y) { return y *= x; }
+    friend double_double operator/(double_double x, const double_double& y) { return x /= y; }
+    friend double_double operator/(double_double x, const T& y) { return x /= y; }
+    friend double_double operator/(const T& x, const double_double& y) { return double_double{x} /= y; }
+
+    friend constexpr double_double operator+(const double_double& x) { return x; }
+    friend constexpr double_double operator-(const double_double& x) { return {-x.hi_, -x.lo_}; }
+};
+
+template <typename T>
+constexpr T sqr(const T& x) {
+    return x * x;
+}
+
+/**
+ * @brief x^2 with one product fewer than x * x
+ */
+template <typename T>
+double_double<T> sqr(const double_double<T>& x) {
+    T e{};
+    const T p = two_prod(x.hi(), x.hi(), e);
+    const T cross = x.hi() * x.lo();
+    e += cross + cross;
+    return double_double<T>{p} + e;
+}
+
+template <typename T>
+    requires std::is_floating_point_v<T>
+constexpr bool operator==(const double_double<T>& x, const double_double<T>& y) {
+    return x.hi() == y.hi() && x.lo() == y.lo();
+}
+
+template <typename T>
+    requires std::is_floating_point_v<T>
+constexpr bool operator<(const double_double<T>& x, const double_double<T>& y) {
+    return x.hi() < y.hi() || (x.hi() == y.hi() && x.lo() < y.lo());
+}
+
+template <typename T>
+    requires std::is_floating_point_v<T>
+constexpr bool operator>(const double_double<T>& x, const double_double<T>& y) {
+    return y < x;
+}
+
+template <typename T>
+    requires std::is_floating_point_v<T>
+constexpr bool operator<=(const double_double<T>& x, const double_double<T>& y) {
+    return !(y < x);
+}
+
+template <typename T>
+    requires std::is_floating_point_v<T>
+constexpr bool operator>=(const double_double<T>& x, const double_double<T>& y) {
+    return !(x < y);
+}
+
+template <typename T>
+    requires std::is_floating_point_v<T>
+double_double<T> abs(const double_double<T>& x) {
+    return x.hi() < 0 ? -x : x;
+}
+
+/**
+ * @brief one Newton step on the double square root, which doubles its precision
+ */
+template <typename T>
+    requires std::is_floating_point_v<T>
+double_double<T> sqrt(const double_double<T>& x) {
+    if (!(x.hi() > 0)) return x.hi() == 0 ? x : double_double<T>{std::sqrt(x.hi())};
+    const T s = std::sqrt(x.hi());
+    T e{};
+    const T p = two_prod(s, s, e);
+    const auto r = x - double_double<T>{p, e};
+    return double_double<T>{s} + r.hi() / (2 * s);
+}
+
+/**
+ * @brief lanes where mask is set come from x, the rest from y
+ */
+template <typename T, std::size_t N>
+constexpr double_double<simd<T, N>> where(const simd_mask<T, N>& mask, const double_double<simd<T, N>>& x,
+                                          const double_double<simd<T, N>>& y) {
+    return {where(mask, x.hi(), y.hi()), where(mask, x.lo(), y.lo())};
+}
+
+template <typename T, typename Char, typename Traits>
+std::basic_ostream<Char, Traits>& operator<<(std::basic_ostream<Char, Traits>& os, const double_double<T>& x) {
+    os << x.hi() << (x.lo() < 0 ? " - " : " + ") << std::abs(x.lo());
+    return os;
+}
+
+/**
+ * @class quad_double
+ * @brief unevaluated sum of four doubles, about 212 bits
+ * Addition and multiplication are the "sloppy" variants of Hida, Li and Bailey's QD library: their error is
+ * bounded relative to the operands rather than to the result, which is all an escape-time iteration needs.
+ */
+class quad_double {
+private:
+    double x_[4] = {};
+
+    static void three_sum(double& a, double& b, double& c) {
+        double t2{};
+        double t3{};
+        const double t1 = two_sum(a, b, t2);
+        a = two_sum(c, t1, t3);
+        b = two_sum(t2, t3, c);
+    }
+
+    static void three_sum2(double& a, double& b, double& c) {
+        double t2{};
+        double t3{};
+        const double t1 = two_sum(a, b, t2);
+        a = two_sum(c, t1, t3);
+        b = t2 + t3;
+    }
+
+    /**
+     * @brief five overlapping terms into four non-overlapping ones
+     */
+    static quad_double renormalized(double c0, double c1, double c2, double c3, double c4) {
+        if (std::isinf(c0)) return quad_double{c0};
+
+        double s0 = quick_two_sum(c3, c4, c4);
+        s0 = quick_two_sum(c2, s0, c3);
+        s0 = quick_two_sum(c1, s0, c2);
+        c0 = quick_two_sum(c0, s0, c1);
+
+        s0 = c0;
+        double s1 = c1;
+        double s2 = 0.0;
+        double s3 = 0.0;
+        if (s1 != 0.0) {
+            s1 = quick_two_sum(s1, c2, s2);
+            if (s2 != 0.0) {
+                s2 = quick_two_sum(s2, c3, s3);
+                if (s3 != 0.0) {
+                    s3 += c4;
+                } else {
+                    s2 += c4;
+                }
+            } else {
+                s1 = quick_two_sum(s1, c3, s2);
+                if (s2 != 0.0) {
+                    s2 = quick_two_sum(s2, c4, s3);
+                } else {
+                    s1 = quick_two_sum(s1, c4, s2);
+                }
+            }
+        } else {
+            s0 = quick_two_sum(s0, c2, s1);
+            if (s1 != 0.0) {
+                s1 = quick_two_sum(s1, c3, s2);
+                if (s2 != 0.0) {
+                    s2 = quick_two_sum(s2, c4, s3);
+                } else {
+                    s1 = quick_two_sum(s1, c4, s2);
+                }
+            } else {
+                s0 = quick_two_sum(s0, c3, s1);
+                if (s1 != 0.0) {
+                    s1 = quick_two_sum(s1, c4, s2);
+                } else {
+                    s0 = quick_two_sum(s0, c4, s1);
+                }
+            }
+        }
+        return quad_double{s0, s1, s2, s3};
+    }
+
+public:
+    using value_type = double;
+
+    constexpr quad_double(double x0 = 0.0, double x1 = 0.0, double x2 = 0.0, double x3 = 0.0) : x_{x0, x1, x2, x3} {}
+    constexpr quad_double(const double_double<double>& x) : x_{x.hi(), x.lo(), 0.0, 0.0} {}
+
+    constexpr double operator[](std::size_t i) const { return x_[i]; }
+
+    quad_double& operator+=(const quad_double& b) {
+        double t0{};
+        double t1{};
+        double t2{};
+        double t3{};
+        double s0 = two_sum(x_[0], b.x_[0], t0);
+        double s1 = two_sum(x_[1], b.x_[1], t1);
+        double s2 = two_sum(x_[2], b.x_[2], t2);
+        double s3 = two_sum(x_[3], b.x_[3], t3);
+
+        s1 = two_sum(s1, t0, t0);
+        three_sum(s2, t0, t1);
+        three_sum2(s3, t0, t2);
+        t0 = t0 + t1 + t3;
+        return *this = renormalized(s0, s1, s2, s3, t0);
+    }
+
+    quad_double& operator-=(const quad_double& b) { return *this += -b; }
+
+    quad_double& operator*=(const quad_double& b) {
+        const auto& a = x_;
+        const auto& c = b.x_;
+        double q0{};
+        double q1{};
+        double q2{};
+        double q3{};
+        double q4{};
+        double q5{};
+        const double p0 = two_prod(a[0], c[0], q0);
+        double p1 = two_prod(a[0], c[1], q1);
+        double p2 = two_prod(a[1], c[0], q2);
+        double p3 = two_prod(a[0], c[2], q3);
+        double p4 = two_prod(a[1], c[1], q4);
+        double p5 = two_prod(a[2], c[0], q5);
+
+        three_sum(p1, p2, q0);
+        three_sum(p2, q1, q2);
+        three_sum(p3, p4, p5);
+
+        double t0{};
+        double t1{};
+        const double s0 = two_sum(p2, p3, t0);
+        double s1 = two_sum(q1, p4, t1);
+        double s2 = q2 + p5;
+        s1 = two_sum(s1, t0, t0);
+        s2 += t0 + t1;
+
+        s1 += a[0] * c[3] + a[1] * c[2] + a[2] * c[1] + a[3] * c[0] + q0 + q3 + q4 + q5;
+        return *this = renormalized(p0, p1, s0, s1, s2);
+    }
+
+    quad_double& operator/=(const quad_double& b) {
+        const double q0 = x_[0] / b.x_[0];
+        auto r = *this - b * q0;
+        const double q1 = r.x_[0] / b.x_[0];
+        r -= b * q1;
+        const double q2 = r.x_[0] / b.x_[0];
+        r -= b * q2;
+        const double q3 = r.x_[0] / b.x_[0];
+        r -= b * q3;
+        const double q4 = r.x_[0] / b.x_[0];
+        return *this = renormalized(q0, q1, q2, q3, q4);
+    }
+
+    friend quad_double operator+(quad_double x, const quad_double& y) { return x += y; }
+    friend quad_double operator-(quad_double x, const quad_double& y) { return x -= y; }
+    friend quad_double operator*(quad_double x, const quad_double& y) { return x *= y; }
+    friend quad_double operator/(quad_double x, const quad_double& y) { return x /= y; }
+
+    friend constexpr quad_double operator+(const quad_double& x) { return x; }
+    friend constexpr quad_double operator-(const quad_double& x) { return {-x.x_[0], -x.x_[1], -x.x_[2], -x.x_[3]}; }
+
+    friend bool operator==(const quad_double& x, const quad_double& y) {
+        return x.x_[0] == y.x_[0] && x.x_[1] == y.x_[1] && x.x_[2] == y.x_[2] && x.x_[3] == y.x_[3];
+    }
+
+    friend bool operator<(const quad_double& x, const quad_double& y) {
+        for (std::size_t i = 0; i < 4; i++) {
+            if (x.x_[i] != y.x_[i]) return x.x_[i] < y.x_[i];
+        }
+        return false;
+    }
+
+    friend bool operator>(const quad_double& x, const quad_double& y) { return y < x; }
+    friend bool operator<=(const quad_double& x, const quad_double& y) { return !(y < x); }
+    friend bool operator>=(const quad_double& x, const quad_double& y) { return !(x < y); }
+};
+
+inline quad_double sqr(const quad_double& x) {
+    return x * x;
+}
+
+inline quad_double abs(const quad_double& x) {
+    return x[0] < 0.0 ? -x : x;
+}
+
+/**
+ * @brief three Newton steps on 1 / sqrt(x) from the double estimate, each doubling the precision
+ * Two would be enough from an exact 53 bit start; the rounded estimate leaves them about 12 ulp short of qd.
+ */
+inline quad_double sqrt(const quad_double& x) {
+    if (!(x[0] > 0.0)) return x[0] == 0.0 ? x : quad_double{std::sqrt(x[0])};
+    quad_double r = 1.0 / std::sqrt(x[0]);
+    const quad_double half = 0.5;
+    for (int i = 0; i < 3; i++) r += r * (half - half * x * sqr(r));
+    return x * r;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const quad_double& x) {
+    os << x[0] << " + " << x[1] << " + " << x[2] << " + " << x[3];
+    return os;
+}
+
+/**
+ * @brief leading part of a floating point, double-double or quad-double value
+ */
+template <typename T>
+constexpr auto leading(const T& x) {
+    return x;
+}
+
+template <typename T>
+constexpr T leading(const double_double<T>& x) {
+    return x.hi();
+}
+
+constexpr double leading(const quad_double& x) {
+    return x[0];
+}
+
+/**
+ * @brief round x to the narrower type T: double, double_double<double> or quad_double itself
+ */
+template <typename T>
+constexpr T narrow(const quad_double& x) {
+    if constexpr (std::is_same_v<T, quad_double>) {
+        return x;
+    } else if constexpr (std::is_same_v<T, double_double<double>>) {
+        return double_double<double>{x[0], x[1]};
+    } else {
+        return static_cast<T>(x[0]);
+    }
+}
+
+enum class precision_level { float32, float64, double_double, quad_double };
+
+inline const char* precision_level_to_string(precision_level p) {
+    switch (p) {
+        case precision_level::float32:
+            return "float";
+        case precision_level::float64:
+            return "double";
+        case precision_level::double_double:
+            return "double-double";
+        case precision_level::quad_double:
+            return "quad-double";
+        default:
+            return "No match precision";
+    }
+}
+
+/**
+ * @brief narrowest precision whose mantissa covers coordinates of magnitude down to spacing
+ * guard_bits absorb the rounding error the iteration amplifies. With 8 of them and 1000 pixels around the
+ * mandelbrot set, float hands over to double below scale ~1e-2, double to double-double below ~3e-11 and
+ * double-double to quad-double below ~3e-27. Past quad-double (~1e-58) only perturbation.h still resolves
+ * pixels; quad_double is returned regardless.
+ */
+inline precision_level required_precision(double magnitude, double spacing, double guard_bits = 8.0) {
+    const double bits = std::log2(magnitude / spacing) + guard_bits;
+    if (bits <= 24.0) return precision_level::float32;
+    if (bits <= 53.0) return precision_level::float64;
+    if (bits <= 106.0) return precision_level::double_double;
+    return precision_level::quad_double;
+}
+
+/**
+ * @brief big_fixed to quad_double; every 32 bit limb is exact in a double, so only the sums round
+ */
+inline quad_double to_quad_double(const big_fixed& x) {
+    quad_double ret;
+    double w = 1.0;
+    for (std::size_t i = 0; i < x.limbs(); i++) {
+        ret += quad_double{static_cast<double>(x.limb(i)) * w};
+        w /= 4294967296.0;
+    }
+    return x.negative() ? -ret : ret;
+}
+
+#endif  // PRACC_GL_DOUBLE_DOUBLE_H
@@ -0,0 +1,435 @@
+/**
+ * @file dual_expr.h
+ * @brief opt-in expression templates over dual_num: lazy nodes evaluated in one pass, optionally with FMA
+ */
+
+#ifndef PRACC_GL_DUAL_EXPR_H
+#define PRACC_GL_DUAL_EXPR_H
+
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <utility>
+
+#include "include/dual_number.h"
+
+/**
+ * @brief how dual_eval() rounds
+ * exact performs the operations the eager dual_num operators would for the same expression, in the same
+ * order, so the result is bit-identical unless the compiler contracts either one into FMA (GCC does by
+ * default once FMA is enabled); it only drops multiplications by the known dual part 1 of
+ * dual_variable() where that is exact (floating point Tp, x * 1 == x). fused also drops them for every Tp,
+ * multiplies std::complex without the inf/nan recovery of its operator* and, where the target has FMA,
+ * contracts the product rule and the complex products into fma: fewer instructions and roundings, but not
+ * the eager result. std::fma is not constexpr in C++20, so a constant expression only gets the folding.
+ */
+enum class dual_eval_mode { exact, fused };
+
+/**
+ * @brief base of every node, which is what makes the operators below apply; a plain dual_num never matches
+ */
+struct dual_expr_node {};
+
+template <typename E>
+concept dual_expression = std::is_base_of_v<dual_expr_node, std::remove_cvref_t<E>>;
+
+template <typename Tp>
+inline constexpr bool dual_is_complex = false;
+
+template <typename T>
+inline constexpr bool dual_is_complex<std::complex<T>> = std::is_floating_point_v<T>;
+
+/**
+ * @brief whether std::fma on T is a hardware instruction (FP_FAST_FMA); elsewhere it is a slow libm call
+ */
+template <typename T>
+inline constexpr bool dual_fast_fma =
+#ifdef FP_FAST_FMAF
+    std::is_same_v<T, float> ||
+#endif
+#ifdef FP_FAST_FMA
+    std::is_same_v<T, double> ||
+#endif
+    false;
+
+/**
+ * @brief a * b + c, with a single rounding where the target has FMA for Tp, its parts or its simd lanes
+ */
+template <typename Tp>
+constexpr Tp dual_fma(const Tp& a, const Tp& b, const Tp& c) {
+    if constexpr (dual_fast_fma<Tp>) {
+        if (!std::is_constant_evaluated()) return std::fma(a, b, c);
+    } else if constexpr (dual_is_complex<Tp>) {
+        if constexpr (dual_fast_fma<typename Tp::value_type>) {
+            if (!std::is_constant_evaluated()) {
+                return {std::fma(a.real(), b.real(), std::fma(-a.imag(), b.imag(), c.real())),
+                        std::fma(a.real(), b.imag(), std::fma(a.imag(), b.real(), c.imag()))};
+            }
+        }
+        return {a.real() * b.real() - a.imag() * b.imag() + c.real(),
+                a.real() * b.imag() + a.imag() * b.real() + c.imag()};
+    } else if constexpr (requires { typename Tp::value_type; fma(a, b, c); }) {
+        if constexpr (dual_fast_fma<typename Tp::value_type>) return fma(a, b, c);
+    }
+    return a * b + c;
+}
+
+/**
+ * @brief a * b; fused std::complex products skip the inf/nan recovery call of operator*
+ */
+template <dual_eval_mode Mode, typename Tp>
+constexpr Tp dual_product(const Tp& a, const Tp& b) {
+    if constexpr (Mode == dual_eval_mode::fused && dual_is_complex<Tp>) {
+        if constexpr (dual_fast_fma<typename Tp::value_type>) {
+            if (!std::is_constant_evaluated()) {
+                return {std::fma(a.real(), b.real(), -(a.imag() * b.imag())),
+                        std::fma(a.real(), b.imag(), a.imag() * b.real())};
+            }
+        }
+        return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+    } else {
+        return a * b;
+    }
+}
+
+/**
+ * @brief a * b + c in Mode
+ */
+template <dual_eval_mode Mode, typename Tp>
+constexpr Tp dual_product_add(const Tp& a, const Tp& b, const Tp& c) {
+    if constexpr (Mode == dual_eval_mode::fused) {
+        return dual_fma(a, b, c);
+    } else {
+        return a * b + c;
+    }
+}
+
+/**
+ * @brief whether x * 1 may be replaced by x in Mode
+ */
+template <dual_eval_mode Mode, typename Tp>
+inline constexpr bool dual_fold_unit = Mode == dual_eval_mode::fused || std::is_floating_point_v<Tp>;
+
+/**
+ * @class dual_leaf
+ * @brief a dual_num operand, lazy(x)
+ */
+template <typename Tp>
+class dual_leaf : public dual_expr_node {
+private:
+    dual_num<Tp> x_;
+
+public:
+    using value_type = Tp;
+    static constexpr bool unit_imag = false;
+    static constexpr bool zero_imag = false;
+
+    constexpr explicit dual_leaf(const dual_num<Tp>& x) : x_{x} {}
+
+    template <dual_eval_mode>
+    [[gnu::always_inline]] constexpr dual_num<Tp> eval() const {
+        return x_;
+    }
+};
+
+/**
+ * @class dual_variable_leaf
+ * @brief the independent variable z + e, whose dual part is known to be 1
+ */
+template <typename Tp>
+class dual_variable_leaf : public dual_expr_node {
+private:
+    Tp z_;
+
+public:
+    using value_type = Tp;
+    static constexpr bool unit_imag = true;
+    static constexpr bool zero_imag = false;
+
+    constexpr explicit dual_variable_leaf(const Tp& z) : z_{z} {}
+
+    template <dual_eval_mode>
+    [[gnu::always_inline]] constexpr dual_num<Tp> eval() const {
+        return {z_, Tp{1}};
+    }
+};
+
+/**
+ * @class dual_scalar_leaf
+ * @brief a plain value next to a node, applied through the same compound assignments as the dual_num
+ * operators taking a U
+ */
+template <typename U>
+class dual_scalar_leaf : public dual_expr_node {
+public:
+    static constexpr bool unit_imag = false;
+    static constexpr bool zero_imag = true;
+
+    U value;
+
+    constexpr explicit dual_scalar_leaf(const U& u) : value{u} {}
+};
+
+template <typename E>
+inline constexpr bool dual_is_scalar_leaf = false;
+
+template <typename U>
+inline constexpr bool dual_is_scalar_leaf<dual_scalar_leaf<U>> = true;
+
+/**
+ * @brief value_type of whichever of L, R is not a scalar
+ */
+template <typename L, typename R>
+using dual_node_value_t = typename std::conditional_t<dual_is_scalar_leaf<L>, R, L>::value_type;
+
+template <typename Tp>
+constexpr dual_leaf<Tp> lazy(const dual_num<Tp>& x) {
+    return dual_leaf<Tp>{x};
+}
+
+/**
+ * @brief z + e, the argument to build f(z) with f'(z) in the dual part from
+ */
+template <typename Tp>
+constexpr dual_variable_leaf<Tp> dual_variable(const Tp& z) {
+    return dual_variable_leaf<Tp>{z};
+}
+
+/**
+ * @class dual_expr_base
+ * @brief what every non-scalar node shares: conversion to dual_num evaluates exactly
+ */
+template <typename Derived, typename Tp>
+class dual_expr_base : public dual_expr_node {
+public:
+    using value_type = Tp;
+
+    constexpr operator dual_num<Tp>() const {
+        return static_cast<const Derived&>(*this).template eval<dual_eval_mode::exact>();
+    }
+};
+
+template <typename L, typename R>
+class dual_add_node : public dual_expr_base<dual_add_node<L, R>, dual_node_value_t<L, R>> {
+private:
+    L l_;
+    R r_;
+
+public:
+    using value_type = dual_node_value_t<L, R>;
+    static constexpr bool unit_imag = (L::unit_imag && R::zero_imag) || (L::zero_imag && R::unit_imag);
+    static constexpr bool zero_imag = false;
+
+    constexpr dual_add_node(const L& l, const R& r) : l_{l}, r_{r} {}
+
+    template <dual_eval_mode Mode>
+    [[gnu::always_inline]] constexpr dual_num<value_type> eval() const {
+        if constexpr (dual_is_scalar_leaf<R>) {
+            auto l = l_.template eval<Mode>();
+            return l += r_.value;
+        } else if constexpr (dual_is_scalar_leaf<L>) {
+            auto r = r_.template eval<Mode>();
+            return r += l_.value;
+        } else {
+            const auto l = l_.template eval<Mode>();
+            const auto r = r_.template eval<Mode>();
+            return {l.real() + r.real(), l.imag() + r.imag()};
+        }
+    }
+};
+
+template <typename L, typename R>
+class dual_sub_node : public dual_expr_base<dual_sub_node<L, R>, dual_node_value_t<L, R>> {
+private:
+    L l_;
+    R r_;
+
+public:
+    using value_type = dual_node_value_t<L, R>;
+    static constexpr bool unit_imag = L::unit_imag && R::zero_imag;
+    static constexpr bool zero_imag = false;
+
+    constexpr dual_sub_node(const L& l, const R& r) : l_{l}, r_{r} {}
+
+    template <dual_eval_mode Mode>
+    [[gnu::always_inline]] constexpr dual_num<value_type> eval() const {
+        if constexpr (dual_is_scalar_leaf<R>) {
+            auto l = l_.template eval<Mode>();
+            return l -= r_.value;
+        } else if constexpr (dual_is_scalar_leaf<L>) {
+            const auto r = r_.template eval<Mode>();
+            return {value_type(l_.value) - r.real(), -r.imag()};
+        } else {
+            const auto l = l_.template eval<Mode>();
+            const auto r = r_.template eval<Mode>();
+            return {l.real() - r.real(), l.imag() - r.imag()};
+        }
+    }
+};
+
+/**
+ * @brief product rule (a + b e)(c + d e) = ac + (ad + bc) e, without the multiplications by a known 1
+ */
+template <typename L, typename R>
+class dual_mul_node : public dual_expr_base<dual_mul_node<L, R>, dual_node_value_t<L, R>> {
+private:
+    L l_;
+    R r_;
+
+public:
+    using value_type = dual_node_value_t<L, R>;
+    static constexpr bool unit_imag = false;
+    static constexpr bool zero_imag = false;
+
+    constexpr dual_mul_node(const L& l, const R& r) : l_{l}, r_{r} {}
+
+    template <dual_eval_mode Mode>
+    [[gnu::always_inline]] constexpr dual_num<value_type> eval() const {
+        using Tp = value_type;
+        if constexpr (dual_is_scalar_leaf<R>) {
+            auto l = l_.template eval<Mode>();
+            return l *= r_.value;
+        } else if constexpr (dual_is_scalar_leaf<L>) {
+            auto r = r_.template eval<Mode>();
+            return r *= l_.value;
+        } else {
+            const auto l = l_.template eval<Mode>();
+            const auto r = r_.template eval<Mode>();
+            const Tp re = dual_product<Mode>(l.real(), r.real());
+            constexpr bool lu = L::unit_imag && dual_fold_unit<Mode, Tp>;
+            constexpr bool ru = R::unit_imag && dual_fold_unit<Mode, Tp>;
+            if constexpr (lu && ru) {
+                return {re, l.real() + r.real()};
+            } else if constexpr (ru) {
+                return {re, dual_product_add<Mode>(l.imag(), r.real(), l.real())};
+            } else if constexpr (lu) {
+                return {re, dual_product_add<Mode>(l.real(), r.imag(), r.real())};
+            } else if constexpr (Mode == dual_eval_mode::fused) {
+                return {re, dual_fma(l.real(), r.imag(), dual_product<Mode>(l.imag(), r.real()))};
+            } else {
+                return {re, l.real() * r.imag() + l.imag() * r.real()};
+            }
+        }
+    }
+};
+
+/**
+ * @brief (a + b e) / (c + d e) = a / c + (b - (a / c) d) / c e, as dual_num::operator/=
+ */
+template <typename L, typename R>
+class dual_div_node : public dual_expr_base<dual_div_node<L, R>, dual_node_value_t<L, R>> {
+private:
+    L l_;
+    R r_;
+
+public:
+    using value_type = dual_node_value_t<L, R>;
+    static constexpr bool unit_imag = false;
+    static constexpr bool zero_imag = false;
+
+    constexpr dual_div_node(const L& l, const R& r) : l_{l}, r_{r} {}
+
+    template <dual_eval_mode Mode>
+    [[gnu::always_inline]] constexpr dual_num<value_type> eval() const {
+        using Tp = value_type;
+        if constexpr (dual_is_scalar_leaf<R>) {
+            auto l = l_.template eval<Mode>();
+            return l /= r_.value;
+        } else {
+            const dual_num<Tp> l = [&] {
+                if constexpr (dual_is_scalar_leaf<L>) {
+                    return dual_num<Tp>(l_.value);
+                } else {
+                    return l_.template eval<Mode>();
+                }
+            }();
+            const auto r = r_.template eval<Mode>();
+            const Tp re = l.real() / r.real();
+            if constexpr (R::unit_imag && dual_fold_unit<Mode, Tp>) {
+                return {re, (l.imag() - re) / r.real()};
+            } else if constexpr (Mode == dual_eval_mode::fused) {
+                return {re, dual_fma(-re, r.imag(), l.imag()) / r.real()};
+            } else {
+                return {re, (l.imag() - re * r.imag()) / r.real()};
+            }
+        }
+    }
+};
+
+template <typename E>
+class dual_neg_node : public dual_expr_base<dual_neg_node<E>, typename E::value_type> {
+private:
+    E e_;
+
+public:
+    using value_type = typename E::value_type;
+    static constexpr bool unit_imag = false;
+    static constexpr bool zero_imag = false;
+
+    constexpr explicit dual_neg_node(const E& e) : e_{e} {}
+
+    template <dual_eval_mode Mode>
+    [[gnu::always_inline]] constexpr dual_num<value_type> eval() const {
+        const auto e = e_.template eval<Mode>();
+        return {-e.real(), -e.imag()};
+    }
+};
+
+/**
+ * @brief an operand as a node: nodes stay, anything else is a scalar
+ * A dual_num next to a node has to be wrapped in lazy(), or the eager operators taking a U win overload
+ * resolution and fail to compile.
+ */
+template <typename X>
+constexpr auto dual_operand(const X& x) {
+    if constexpr (dual_expression<X>) {
+        return x;
+    } else {
+        return dual_scalar_leaf<X>{x};
+    }
+}
+
+/**
+ * @brief at least one side is a node, so eager dual_num arithmetic never ends up here
+ */
+template <typename L, typename R>
+concept dual_expr_operands = dual_expression<L> || dual_expression<R>;
+
+template <typename L, typename R>
+    requires dual_expr_operands<L, R>
+constexpr auto operator+(const L& l, const R& r) {
+    return dual_add_node{dual_operand(l), dual_operand(r)};
+}
+
+template <typename L, typename R>
+    requires dual_expr_operands<L, R>
+constexpr auto operator-(const L& l, const R& r) {
+    return dual_sub_node{dual_operand(l), dual_operand(r)};
+}
+
+template <typename L, typename R>
+    requires dual_expr_operands<L, R>
+constexpr auto operator*(const L& l, const R& r) {
+    return dual_mul_node{dual_operand(l), dual_operand(r)};
+}
+
+template <typename L, typename R>
+    requires dual_expr_operands<L, R>
+constexpr auto operator/(const L& l, const R& r) {
+    return dual_div_node{dual_operand(l), dual_operand(r)};
+}
+
+template <dual_expression E>
+constexpr auto operator-(const E& e) {
+    return dual_neg_node{e};
+}
+
+/**
+ * @brief evaluate a node in one pass; dual_eval<dual_eval_mode::fused>(e) to contract with fma
+ */
+template <dual_eval_mode Mode = dual_eval_mode::exact, dual_expression E>
+constexpr dual_num<typename E::value_type> dual_eval(const E& e) {
+    return e.template eval<Mode>();
+}
+
+#endif  // PRACC_GL_DUAL_EXPR_H
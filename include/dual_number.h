@@ -92,10 +92,9 @@ public:
     }
 
     constexpr dual_num<Tp>& operator/=(const dual_num<Tp>& z) {
-        const Tp r = re_ * z.real();
-        const Tp n = z.real() * z.real();
-        im_ = (im_ * z.real() - re_ * z.imag()) / n;
-        re_ = r / n;
+        // (a + b e) / (c + d e) = a / c + (b - (a / c) d) / c e, no c^2 to overflow
+        re_ /= z.real();
+        im_ = (im_ - re_ * z.imag()) / z.real();
         return *this;
     }
 };
@@ -0,0 +1,534 @@
+/**
+ * @file escape_precise.h
+ * @brief escape-time kernels in double, double-double and quad-double for zooms the float kernels cannot resolve
+ */
+
+#ifndef PRACC_GL_ESCAPE_PRECISE_H
+#define PRACC_GL_ESCAPE_PRECISE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "include/big_fixed.h"
+#include "include/double_double.h"
+#include "include/escape_time.h"
+#include "include/simd_batch.h"
+
+/**
+ * @brief escape_view with a quad_double center
+ * Pixel offsets from the center are only ever a few scales wide, so they stay doubles; only the sum
+ * center + offset needs the wide type.
+ */
+struct precise_view {
+    quad_double center[2] = {-0.5, 0.0};
+    double scale = 1.5;
+    double pan[2] = {0.0, 0.0};
+    std::size_t frame[2] = {0, 0};
+};
+
+inline precise_view to_precise_view(const escape_view& view) {
+    return {{view.center[0], view.center[1]}, view.scale, {view.pan[0], view.pan[1]}, {view.frame[0], view.frame[1]}};
+}
+
+/**
+ * @brief view centered on decimal strings of any length, like deep_view; digits past quad-double are dropped
+ */
+inline precise_view precise_view_from_strings(std::string_view re, std::string_view im, double scale) {
+    return {{to_quad_double(big_fixed::from_string(re, 8)), to_quad_double(big_fixed::from_string(im, 8))}, scale};
+}
+
+/**
+ * @brief precision an escape-time view of width x height needs
+ * Orbits are tested against radius 2, so the magnitude is at least that even for views around the origin.
+ */
+inline precision_level escape_precision(const precise_view& view, std::size_t width, std::size_t height) {
+    const auto m = static_cast<double>(std::max<std::size_t>(std::min(width, height), 1));
+    const double spacing = 2.0 * view.scale / m;
+    const double extent = static_cast<double>(std::max(width, height)) / m * view.scale;
+    const double magnitude = std::max(std::abs(view.center[0][0]) + std::abs(view.center[1][0]) + extent, 2.0);
+    return required_precision(magnitude, spacing);
+}
+
+using precise_kernel = void (*)(const escape_params&, const precise_view&, escape_buffer&, std::size_t, std::size_t,
+                                std::size_t, std::size_t);
+
+/**
+ * @brief kernel over a list of pixel indices of the buffer, row * width + column, instead of a rectangle
+ */
+using precise_points_kernel = void (*)(const escape_params&, const precise_view&, escape_buffer&, const std::size_t*,
+                                       std::size_t);
+
+/**
+ * @brief plane coordinate of column (or row) i, escape_axis() with the center c added in T
+ */
+template <typename T>
+T precise_coordinate(const T& c, std::size_t i, std::size_t len, std::size_t min_len, double scale, double pan) {
+    const auto w = static_cast<double>(len);
+    const auto m = static_cast<double>(min_len);
+    return c + ((static_cast<double>(i) + pan + 0.5) * 2.0 - w) / m * scale;
+}
+
+/**
+ * @brief plane coordinates of columns (or rows) [begin, end), escape_axis() with the center added in T
+ */
+template <typename T>
+std::vector<T> precise_axis(std::size_t begin, std::size_t end, std::size_t len, std::size_t min_len, double scale,
+                            const quad_double& center, double pan) {
+    std::vector<T> axis;
+    axis.reserve(end - begin);
+    const auto c = narrow<T>(center);
+    for (auto i = begin; i < end; i++) axis.push_back(precise_coordinate(c, i, len, min_len, scale, pan));
+    return axis;
+}
+
+/**
+ * @brief in_main_cardioid() in T: a bool, or a mask for a lane type
+ * The sign of the difference is that of its leading part, so only that is compared.
+ */
+template <typename T>
+auto precise_in_cardioid(const T& x, const T& y) {
+    const T yy = sqr(y);
+    const T a = x - T{0.25};
+    const T q = sqr(a) + yy;
+    const auto d = leading(q * (q + a) - T{0.25} * yy);
+    return d <= decltype(d){0.0};
+}
+
+/**
+ * @brief in_period2_bulb() in T
+ */
+template <typename T>
+auto precise_in_bulb(const T& x, const T& y) {
+    const auto d = leading(sqr(x + T{1.0}) + sqr(y) - T{0.0625});
+    return d <= decltype(d){0.0};
+}
+
+/**
+ * @brief exact equality of every part, for the period check; lane types give a mask
+ */
+template <typename T>
+bool precise_same(const T& a, const T& b) {
+    return a == b;
+}
+
+template <std::size_t N>
+simd_mask<double, N> precise_same(const simd<double, N>& a, const simd<double, N>& b) {
+    return (a <= b) & (b <= a);
+}
+
+template <std::size_t N>
+simd_mask<double, N> precise_same(const double_double<simd<double, N>>& a, const double_double<simd<double, N>>& b) {
+    return precise_same(a.hi(), b.hi()) & precise_same(a.lo(), b.lo());
+}
+
+/**
+ * @brief a pixel handed to the kernels: its plane coordinates and its index in the buffer
+ */
+template <typename T>
+struct precise_pixel {
+    T x;
+    T y;
+    std::size_t index;
+};
+
+// One iteration z = z^2 + c. The escape test only looks at the leading doubles: |z| is near 2 when it
+// matters, where a double decides |z|^2 > 4 as well as any wider type would. The interior checks are
+// those of escape_time_scalar(), with the period check comparing every part of z.
+// pixel(j) is the precise_pixel of each j in [0, count).
+template <typename T, typename Pixel>
+void render_precise_pixels(const escape_params& param, escape_buffer& out, std::size_t count, Pixel&& pixel) {
+    const bool julia = param.kind == fractal_kind::julia;
+    const bool checks = param.interior_checks;
+    const auto n = param.max_iter;
+
+    for (std::size_t j = 0; j < count; j++) {
+        const precise_pixel<T> p = pixel(j);
+        T zr = p.x;
+        T zi = p.y;
+        T cr = zr;
+        T ci = zi;
+
+        if (julia) {
+            cr = T{static_cast<double>(param.c[0])};
+            ci = T{static_cast<double>(param.c[1])};
+            const T r = sqr(zr) - sqr(zi);
+            T i = zr * zi;
+            i += i;
+            zr = r + cr;
+            zi = i + ci;
+        }
+
+        auto test = interior_test::none;
+        if (checks && !julia) {
+            if (precise_in_cardioid(cr, ci)) {
+                test = interior_test::cardioid;
+            } else if (precise_in_bulb(cr, ci)) {
+                test = interior_test::bulb;
+            }
+        }
+
+        std::uint32_t i = 0;
+        T sr = zr;
+        T si = zi;
+        for (; i < n && test == interior_test::none; i++) {
+            const T r = sqr(zr) - sqr(zi);
+            T im = zr * zi;
+            im += im;
+            zr = r + cr;
+            zi = im + ci;
+
+            const double lr = leading(zr);
+            const double li = leading(zi);
+            if (lr * lr + li * li > 4.0) break;
+            if (!checks) continue;
+            if (precise_same(zr, sr) && precise_same(zi, si)) {
+                test = interior_test::period;
+            } else if ((i & (i + 1)) == 0) {
+                sr = zr;
+                si = zi;
+            }
+        }
+
+        out.re[p.index] = static_cast<float>(leading(zr));
+        out.im[p.index] = static_cast<float>(leading(zi));
+        out.iter[p.index] = test == interior_test::none ? i : n;
+        out.interior[p.index] = static_cast<std::uint8_t>(test);
+    }
+}
+
+/**
+ * @brief the pixels [x0, x1) x [y0, y1) of out as pixel sources for render_precise_pixels(), row by row
+ */
+template <typename T>
+class precise_rect_pixels {
+private:
+    std::vector<T> xs_;
+    std::vector<T> ys_;
+    std::size_t x0_;
+    std::size_t y0_;
+    std::size_t width_;
+    std::size_t stride_;
+
+public:
+    precise_rect_pixels(const precise_view& view, const escape_buffer& out, std::size_t x0, std::size_t y0,
+                        std::size_t x1, std::size_t y1)
+        : x0_{x0}, y0_{y0}, width_{x1 - x0}, stride_{out.width} {
+        const auto frame = view_frame(view, out);
+        const auto m = std::min(frame[0], frame[1]);
+        xs_ = precise_axis<T>(x0, x1, frame[0], m, view.scale, view.center[0], view.pan[0]);
+        ys_ = precise_axis<T>(y0, y1, frame[1], m, view.scale, view.center[1], view.pan[1]);
+    }
+
+    std::size_t size() const { return xs_.size() * ys_.size(); }
+
+    precise_pixel<T> operator()(std::size_t j) const {
+        const auto col = j % width_;
+        const auto row = j / width_;
+        return {xs_[col], ys_[row], (y0_ + row) * stride_ + x0_ + col};
+    }
+};
+
+/**
+ * @brief the listed pixels of out, row * width + column each, as pixel sources for render_precise_pixels()
+ */
+template <typename T>
+class precise_listed_pixels {
+private:
+    const std::size_t* pixels_;
+    std::size_t width_;
+    std::array<std::size_t, 2> frame_;
+    std::size_t min_len_;
+    std::array<T, 2> center_;
+    const precise_view& view_;
+
+public:
+    precise_listed_pixels(const precise_view& view, const escape_buffer& out, const std::size_t* pixels)
+        : pixels_{pixels}, width_{out.width}, frame_{view_frame(view, out)},
+          min_len_{std::min(frame_[0], frame_[1])}, center_{narrow<T>(view.center[0]), narrow<T>(view.center[1])},
+          view_{view} {}
+
+    precise_pixel<T> operator()(std::size_t j) const {
+        const auto idx = pixels_[j];
+        return {precise_coordinate(center_[0], idx % width_, frame_[0], min_len_, view_.scale, view_.pan[0]),
+                precise_coordinate(center_[1], idx / width_, frame_[1], min_len_, view_.scale, view_.pan[1]), idx};
+    }
+};
+
+template <typename T>
+void render_precise_rect(const escape_params& param, const precise_view& view, escape_buffer& out, std::size_t x0,
+                         std::size_t y0, std::size_t x1, std::size_t y1) {
+    const precise_rect_pixels<T> pixels(view, out, x0, y0, x1, y1);
+    render_precise_pixels<T>(param, out, pixels.size(), pixels);
+}
+
+template <typename T>
+void render_precise_points(const escape_params& param, const precise_view& view, escape_buffer& out,
+                           const std::size_t* pixels, std::size_t count) {
+    render_precise_pixels<T>(param, out, count, precise_listed_pixels<T>(view, out, pixels));
+}
+
+/**
+ * @brief lane type holding N values of the scalar type T: simd<double, N> or double_double<simd<double, N>>
+ */
+template <typename T, std::size_t N>
+struct precise_lanes {
+    using type = simd<double, N>;
+
+    static type gather(const std::array<T, N>& x) { return type::load(x.data()); }
+};
+
+template <std::size_t N>
+struct precise_lanes<double_double<double>, N> {
+    using type = double_double<simd<double, N>>;
+
+    static type gather(const std::array<double_double<double>, N>& x) {
+        simd<double, N> hi;
+        simd<double, N> lo;
+        for (std::size_t i = 0; i < N; i++) {
+            hi.set(i, x[i].hi());
+            lo.set(i, x[i].lo());
+        }
+        return {hi, lo};
+    }
+};
+
+/**
+ * @brief render_precise_pixels() with N pixels per lane type
+ * Escaped lanes are frozen with where() while the rest continue, so the result equals the scalar kernel's.
+ * The last batch repeats the final pixel to fill the unused lanes.
+ */
+template <typename T, std::size_t N, typename Pixel>
+[[gnu::always_inline]] inline void render_precise_pixels_batch(const escape_params& param, escape_buffer& out,
+                                                               std::size_t count, Pixel&& pixel) {
+    using lanes = precise_lanes<T, N>;
+    using L = typename lanes::type;
+
+    const bool julia = param.kind == fractal_kind::julia;
+    const bool checks = param.interior_checks;
+    const auto n = param.max_iter;
+    const simd<double, N> four{4.0};
+
+    std::array<T, N> px;
+    std::array<T, N> py;
+    std::array<std::size_t, N> index;
+    for (std::size_t j = 0; j < count; j += N) {
+        for (std::size_t k = 0; k < N; k++) {
+            const precise_pixel<T> p = pixel(std::min(j + k, count - 1));
+            px[k] = p.x;
+            py[k] = p.y;
+            index[k] = p.index;
+        }
+        L zr = lanes::gather(px);
+        L zi = lanes::gather(py);
+        L cr = zr;
+        L ci = zi;
+
+        if (julia) {
+            px.fill(T{static_cast<double>(param.c[0])});
+            cr = lanes::gather(px);
+            px.fill(T{static_cast<double>(param.c[1])});
+            ci = lanes::gather(px);
+            const L r = sqr(zr) - sqr(zi);
+            L i = zr * zi;
+            i += i;
+            zr = r + cr;
+            zi = i + ci;
+        }
+
+        std::array<std::uint32_t, N> iter;
+        iter.fill(n);
+        std::array<interior_test, N> test;
+        test.fill(interior_test::none);
+        auto active = simd_mask<double, N>::all_true();
+        if (checks && !julia) {
+            const auto cardioid = precise_in_cardioid(cr, ci);
+            const auto bulb = (!cardioid) & precise_in_bulb(cr, ci);
+            for (std::size_t k = 0; k < N; k++) {
+                if (cardioid[k]) test[k] = interior_test::cardioid;
+                if (bulb[k]) test[k] = interior_test::bulb;
+            }
+            active = active & !(cardioid | bulb);
+        }
+
+        L sr = zr;
+        L si = zi;
+        for (std::uint32_t i = 0; i < n && any(active); i++) {
+            const L r = sqr(zr) - sqr(zi);
+            L im = zr * zi;
+            im += im;
+            zr = where(active, r + cr, zr);
+            zi = where(active, im + ci, zi);
+
+            const auto lr = leading(zr);
+            const auto li = leading(zi);
+            const auto escaped = active & (lr * lr + li * li > four);
+            if (any(escaped)) {
+                for (std::size_t k = 0; k < N; k++) {
+                    if (escaped[k]) iter[k] = i;
+                }
+                active = active & !escaped;
+            }
+
+            if (!checks) continue;
+            const auto cycle = active & precise_same(zr, sr) & precise_same(zi, si);
+            if (any(cycle)) {
+                for (std::size_t k = 0; k < N; k++) {
+                    if (cycle[k]) test[k] = interior_test::period;
+                }
+                active = active & !cycle;
+            }
+            if ((i & (i + 1)) == 0) {
+                sr = zr;
+                si = zi;
+            }
+        }
+
+        const auto re = leading(zr);
+        const auto im = leading(zi);
+        for (std::size_t k = 0; k < N && j + k < count; k++) {
+            out.re[index[k]] = static_cast<float>(re[k]);
+            out.im[index[k]] = static_cast<float>(im[k]);
+            out.iter[index[k]] = iter[k];
+            out.interior[index[k]] = static_cast<std::uint8_t>(test[k]);
+        }
+    }
+}
+
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+
+// fma() in the error-free products is explicit; contracting anything else would make the batch kernels round
+// differently from render_precise_rect, which runs without FMA code generation.
+#if !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// Two registers of lanes per batch so that the dependent multiplies of one hide behind the other.
+// flatten pulls every double_double operator into the target region, where fma() is one instruction.
+template <typename T>
+__attribute__((target("avx2,fma"), flatten)) void render_precise_rect_avx2(const escape_params& param,
+                                                                          const precise_view& view, escape_buffer& out,
+                                                                          std::size_t x0, std::size_t y0,
+                                                                          std::size_t x1, std::size_t y1) {
+    const precise_rect_pixels<T> pixels(view, out, x0, y0, x1, y1);
+    render_precise_pixels_batch<T, 2 * 32 / sizeof(double)>(param, out, pixels.size(), pixels);
+}
+
+template <typename T>
+__attribute__((target("avx2,fma"), flatten)) void render_precise_points_avx2(const escape_params& param,
+                                                                            const precise_view& view,
+                                                                            escape_buffer& out,
+                                                                            const std::size_t* pixels,
+                                                                            std::size_t count) {
+    render_precise_pixels_batch<T, 2 * 32 / sizeof(double)>(param, out, count,
+                                                            precise_listed_pixels<T>(view, out, pixels));
+}
+
+template <typename T>
+__attribute__((target("avx512f,fma"), flatten)) void render_precise_rect_avx512(const escape_params& param,
+                                                                               const precise_view& view,
+                                                                               escape_buffer& out, std::size_t x0,
+                                                                               std::size_t y0, std::size_t x1,
+                                                                               std::size_t y1) {
+    const precise_rect_pixels<T> pixels(view, out, x0, y0, x1, y1);
+    render_precise_pixels_batch<T, 2 * 64 / sizeof(double)>(param, out, pixels.size(), pixels);
+}
+
+template <typename T>
+__attribute__((target("avx512f,fma"), flatten)) void render_precise_points_avx512(const escape_params& param,
+                                                                                 const precise_view& view,
+                                                                                 escape_buffer& out,
+                                                                                 const std::size_t* pixels,
+                                                                                 std::size_t count) {
+    render_precise_pixels_batch<T, 2 * 64 / sizeof(double)>(param, out, count,
+                                                            precise_listed_pixels<T>(view, out, pixels));
+}
+
+// quad_double has no lane form; the FMA target still turns each two_prod into one instruction instead of a libm call
+__attribute__((target("avx2,fma"), flatten)) inline void render_precise_rect_qd_fma(const escape_params& param,
+                                                                                   const precise_view& view,
+                                                                                   escape_buffer& out, std::size_t x0,
+                                                                                   std::size_t y0, std::size_t x1,
+                                                                                   std::size_t y1) {
+    render_precise_rect<quad_double>(param, view, out, x0, y0, x1, y1);
+}
+
+__attribute__((target("avx2,fma"), flatten)) inline void render_precise_points_qd_fma(const escape_params& param,
+                                                                                     const precise_view& view,
+                                                                                     escape_buffer& out,
+                                                                                     const std::size_t* pixels,
+                                                                                     std::size_t count) {
+    render_precise_points<quad_double>(param, view, out, pixels, count);
+}
+
+#if !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+#endif  // PRACC_GL_ESCAPE_TIME_X86
+
+/**
+ * @brief kernel for precision and isa; float32 gets the double kernels, the float ones live in escape_time.h
+ */
+inline precise_kernel select_precise_kernel(precision_level precision, escape_isa isa = detect_escape_isa()) {
+    isa = std::min(isa, detect_escape_isa());
+    if (precision == precision_level::quad_double) {
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+        if (isa != escape_isa::scalar) return render_precise_rect_qd_fma;
+#endif
+        return render_precise_rect<quad_double>;
+    }
+    if (precision == precision_level::double_double) {
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+        if (isa == escape_isa::avx512) return render_precise_rect_avx512<double_double<double>>;
+        if (isa == escape_isa::avx2) return render_precise_rect_avx2<double_double<double>>;
+#endif
+        return render_precise_rect<double_double<double>>;
+    }
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+    if (isa == escape_isa::avx512) return render_precise_rect_avx512<double>;
+    if (isa == escape_isa::avx2) return render_precise_rect_avx2<double>;
+#endif
+    return render_precise_rect<double>;
+}
+
+/**
+ * @brief select_precise_kernel() for lists of pixels
+ */
+inline precise_points_kernel select_precise_points_kernel(precision_level precision,
+                                                          escape_isa isa = detect_escape_isa()) {
+    isa = std::min(isa, detect_escape_isa());
+    if (precision == precision_level::quad_double) {
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+        if (isa != escape_isa::scalar) return render_precise_points_qd_fma;
+#endif
+        return render_precise_points<quad_double>;
+    }
+    if (precision == precision_level::double_double) {
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+        if (isa == escape_isa::avx512) return render_precise_points_avx512<double_double<double>>;
+        if (isa == escape_isa::avx2) return render_precise_points_avx2<double_double<double>>;
+#endif
+        return render_precise_points<double_double<double>>;
+    }
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+    if (isa == escape_isa::avx512) return render_precise_points_avx512<double>;
+    if (isa == escape_isa::avx2) return render_precise_points_avx2<double>;
+#endif
+    return render_precise_points<double>;
+}
+
+/**
+ * @brief render rows [row_begin, row_end) of out with kernel
+ */
+inline void render_precise_rows(const escape_params& param, const precise_view& view, escape_buffer& out,
+                                std::size_t row_begin, std::size_t row_end, precise_kernel kernel) {
+    kernel(param, view, out, 0, row_begin, out.width, row_end);
+}
+
+#endif  // PRACC_GL_ESCAPE_PRECISE_H
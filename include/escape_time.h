@@ -0,0 +1,549 @@
+/**
+ * @file escape_time.h
+ * @brief CPU escape-time engine mirroring mandelbrot()/julia() in src/mandelbrot/shader
+ */
+
+#ifndef PRACC_GL_ESCAPE_TIME_H
+#define PRACC_GL_ESCAPE_TIME_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define PRACC_GL_ESCAPE_TIME_X86 1
+#endif
+
+enum class fractal_kind { mandelbrot, julia };
+
+enum class escape_isa { scalar, avx2, avx512 };
+
+/**
+ * @brief parameters of one escape-time render
+ * c is only read for julia; the mandelbrot kernel uses the pixel itself.
+ * interior_checks stops pixels that provably never escape early, see escape_time_scalar().
+ */
+struct escape_params {
+    fractal_kind kind = fractal_kind::mandelbrot;
+    float c[2] = {};
+    std::uint32_t max_iter = 50;
+    bool interior_checks = true;
+};
+
+/**
+ * @brief which interior check stopped a pixel; none if it escaped, ran to max_iter or was not checked
+ */
+enum class interior_test : std::uint8_t { none, cardioid, bulb, period };
+
+/**
+ * @brief how many pixels each interior check stopped
+ */
+struct interior_stats {
+    std::size_t cardioid = 0;
+    std::size_t bulb = 0;
+    std::size_t period = 0;
+
+    std::size_t total() const { return cardioid + bulb + period; }
+
+    interior_stats& operator+=(const interior_stats& x) {
+        cardioid += x.cardioid;
+        bulb += x.bulb;
+        period += x.period;
+        return *this;
+    }
+};
+
+inline interior_stats count_interior(const std::vector<std::uint8_t>& interior) {
+    interior_stats ret;
+    for (const auto t : interior) {
+        ret.cardioid += t == static_cast<std::uint8_t>(interior_test::cardioid);
+        ret.bulb += t == static_cast<std::uint8_t>(interior_test::bulb);
+        ret.period += t == static_cast<std::uint8_t>(interior_test::period);
+    }
+    return ret;
+}
+
+/**
+ * @brief pixel -> plane mapping, same as main() of the shaders
+ * p = ((frag + pan) * 2 - winsize) / min(winsize) * scale + center
+ * pan is a whole number of pixels, so a panned pixel maps to exactly the point its old position did.
+ * frame, when set, is the winsize of an image the buffer is only one tile of; pan is then the tile's
+ * origin in it, and the tile gets exactly the values the whole image would have there.
+ */
+struct escape_view {
+    float scale = 1.5f;
+    float center[2] = {-0.5f, 0.0f};
+    float pan[2] = {0.0f, 0.0f};
+    std::size_t frame[2] = {0, 0};
+};
+
+constexpr escape_view mandelbrot_default_view = {1.5f, {-0.5f, 0.0f}};
+constexpr escape_view julia_default_view = {2.0f, {0.0f, 0.0f}};
+
+/**
+ * @brief winsize of the pixel mapping of view: its frame, or the buffer itself
+ */
+template <typename View, typename Buffer>
+std::array<std::size_t, 2> view_frame(const View& view, const Buffer& out) {
+    if (view.frame[0] && view.frame[1]) return {view.frame[0], view.frame[1]};
+    return {out.width, out.height};
+}
+
+/**
+ * @brief SoA result buffer, one entry per pixel; the same triple as the vec3 the shaders return
+ * interior holds the interior_test that stopped each pixel, for statistics only.
+ */
+struct escape_buffer {
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::vector<float> re;
+    std::vector<float> im;
+    std::vector<std::uint32_t> iter;
+    std::vector<std::uint8_t> interior;
+
+    escape_buffer() = default;
+    escape_buffer(std::size_t w, std::size_t h) { resize(w, h); }
+
+    void resize(std::size_t w, std::size_t h) {
+        width = w;
+        height = h;
+        re.assign(w * h, 0.0f);
+        im.assign(w * h, 0.0f);
+        iter.assign(w * h, 0);
+        interior.assign(w * h, 0);
+    }
+};
+
+/**
+ * @brief one row of pixels handed to a kernel
+ * z0 of each lane is (x[i], y), or (x[i], ys[i]) for pixels gathered from anywhere when ys is set; out points
+ * into the row of an escape_buffer. interior may be null.
+ */
+struct escape_span {
+    const float* x;
+    float y;
+    std::size_t count;
+    float* re;
+    float* im;
+    std::uint32_t* iter;
+    std::uint8_t* interior = nullptr;
+    const float* ys = nullptr;
+};
+
+using escape_kernel = void (*)(const escape_params&, const escape_span&);
+
+/**
+ * @brief c in the main cardioid, the closed form of the set of c with an attracting fixed point
+ */
+inline bool in_main_cardioid(float x, float y) {
+    const float a = x - 0.25f;
+    const float q = a * a + y * y;
+    return q * (q + a) <= 0.25f * (y * y);
+}
+
+/**
+ * @brief c in the period-2 bulb, the disc of radius 1/4 around -1
+ */
+inline bool in_period2_bulb(float x, float y) {
+    const float a = x + 1.0f;
+    return a * a + y * y <= 0.0625f;
+}
+
+/**
+ * @brief one step z = z^2 + c, the operations of mandelbrot() in the shaders and of every kernel here
+ */
+inline void escape_step(float& zr, float& zi, float cr, float ci) {
+    const float r = zr * zr - zi * zi;
+    const float m = zr * zi + zi * zr;
+    zr = r + cr;
+    zi = m + ci;
+}
+
+// The escape test is |z|^2 > 4 instead of the shader's length(z) > 2.0 so that every kernel
+// performs the exact same float operations and therefore returns bit-identical results.
+//
+// Interior checks: a mandelbrot c in the main cardioid or the period-2 bulb stops before the first step
+// with z = c. Every orbit is also compared with a saved point that is replaced after steps 1, 2, 4, 8, ...
+// (Brent), which finds any cycle within twice its length plus its start. The comparison is exact, so a hit
+// means the float iteration itself has entered a cycle and would never have escaped. Stopped pixels report
+// iter = max_iter like a pixel that ran out; only their z differs from a full run.
+inline void escape_time_scalar(const escape_params& param, const escape_span& span) {
+    const auto n = param.max_iter;
+    const bool checks = param.interior_checks;
+    for (std::size_t k = 0; k < span.count; k++) {
+        float zr = span.x[k];
+        float zi = span.ys ? span.ys[k] : span.y;
+        float cr = zr;
+        float ci = zi;
+
+        if (param.kind == fractal_kind::julia) {
+            cr = param.c[0];
+            ci = param.c[1];
+            escape_step(zr, zi, cr, ci);
+        }
+
+        auto test = interior_test::none;
+        if (checks && param.kind == fractal_kind::mandelbrot) {
+            if (in_main_cardioid(cr, ci)) {
+                test = interior_test::cardioid;
+            } else if (in_period2_bulb(cr, ci)) {
+                test = interior_test::bulb;
+            }
+        }
+
+        std::uint32_t i = 0;
+        float sr = zr;
+        float si = zi;
+        for (i = 0; i < n && test == interior_test::none; i++) {
+            escape_step(zr, zi, cr, ci);
+
+            if (zr * zr + zi * zi > 4.0f) break;
+            if (!checks) continue;
+            if (zr == sr && zi == si) {
+                test = interior_test::period;
+            } else if ((i & (i + 1)) == 0) {
+                sr = zr;
+                si = zi;
+            }
+        }
+
+        span.re[k] = zr;
+        span.im[k] = zi;
+        span.iter[k] = test == interior_test::none ? i : n;
+        if (span.interior) span.interior[k] = static_cast<std::uint8_t>(test);
+    }
+}
+
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+
+// GCC would otherwise fuse the mul/add pairs into FMA in the avx512f kernel and break bit-exactness.
+#if !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// Two independent vectors are iterated together so the multiply latency of one hides behind the other.
+__attribute__((target("avx2"))) inline void escape_time_avx2(const escape_params& param, const escape_span& span) {
+    constexpr std::size_t lanes = 8;
+    const auto n = param.max_iter;
+    const bool julia = param.kind == fractal_kind::julia;
+    const bool checks = param.interior_checks;
+    const auto four = _mm256_set1_ps(4.0f);
+    const auto one = _mm256_set1_epi32(1);
+    const auto y = _mm256_set1_ps(span.y);
+    const auto max_iter = _mm256_set1_epi32(static_cast<int>(n));
+
+    std::size_t k = 0;
+    for (; k + 2 * lanes <= span.count; k += 2 * lanes) {
+        __m256 zr[2], zi[2], cr[2], ci[2], sr[2], si[2];
+        __m256i it[2], test[2];
+        __m256 active[2];
+
+        for (int v = 0; v < 2; v++) {
+            zr[v] = _mm256_loadu_ps(span.x + k + v * lanes);
+            zi[v] = span.ys ? _mm256_loadu_ps(span.ys + k + v * lanes) : y;
+            cr[v] = zr[v];
+            ci[v] = zi[v];
+            if (julia) {
+                cr[v] = _mm256_set1_ps(param.c[0]);
+                ci[v] = _mm256_set1_ps(param.c[1]);
+                const auto r = _mm256_sub_ps(_mm256_mul_ps(zr[v], zr[v]), _mm256_mul_ps(zi[v], zi[v]));
+                const auto i = _mm256_add_ps(_mm256_mul_ps(zr[v], zi[v]), _mm256_mul_ps(zi[v], zr[v]));
+                zr[v] = _mm256_add_ps(r, cr[v]);
+                zi[v] = _mm256_add_ps(i, ci[v]);
+            }
+            it[v] = _mm256_setzero_si256();
+            test[v] = _mm256_setzero_si256();
+            active[v] = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            sr[v] = zr[v];
+            si[v] = zi[v];
+
+            // in_main_cardioid() / in_period2_bulb(), same operations
+            if (checks && !julia) {
+                const auto yy = _mm256_mul_ps(ci[v], ci[v]);
+                const auto a = _mm256_sub_ps(cr[v], _mm256_set1_ps(0.25f));
+                const auto q = _mm256_add_ps(_mm256_mul_ps(a, a), yy);
+                const auto cardioid = _mm256_cmp_ps(_mm256_mul_ps(q, _mm256_add_ps(q, a)),
+                                                    _mm256_mul_ps(_mm256_set1_ps(0.25f), yy), _CMP_LE_OQ);
+                const auto b = _mm256_add_ps(cr[v], _mm256_set1_ps(1.0f));
+                const auto bulb = _mm256_andnot_ps(cardioid, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(b, b), yy),
+                                                                           _mm256_set1_ps(0.0625f), _CMP_LE_OQ));
+                test[v] = _mm256_blendv_epi8(test[v], _mm256_set1_epi32(static_cast<int>(interior_test::cardioid)),
+                                             _mm256_castps_si256(cardioid));
+                test[v] = _mm256_blendv_epi8(test[v], _mm256_set1_epi32(static_cast<int>(interior_test::bulb)),
+                                             _mm256_castps_si256(bulb));
+                active[v] = _mm256_andnot_ps(_mm256_or_ps(cardioid, bulb), active[v]);
+            }
+        }
+
+        for (std::uint32_t i = 0; i < n; i++) {
+            if (_mm256_testz_ps(_mm256_or_ps(active[0], active[1]), _mm256_or_ps(active[0], active[1]))) break;
+
+            for (int v = 0; v < 2; v++) {
+                const auto r = _mm256_sub_ps(_mm256_mul_ps(zr[v], zr[v]), _mm256_mul_ps(zi[v], zi[v]));
+                const auto m = _mm256_add_ps(_mm256_mul_ps(zr[v], zi[v]), _mm256_mul_ps(zi[v], zr[v]));
+                zr[v] = _mm256_blendv_ps(zr[v], _mm256_add_ps(r, cr[v]), active[v]);
+                zi[v] = _mm256_blendv_ps(zi[v], _mm256_add_ps(m, ci[v]), active[v]);
+
+                const auto norm = _mm256_add_ps(_mm256_mul_ps(zr[v], zr[v]), _mm256_mul_ps(zi[v], zi[v]));
+                active[v] = _mm256_andnot_ps(_mm256_cmp_ps(norm, four, _CMP_GT_OQ), active[v]);
+                it[v] = _mm256_add_epi32(it[v], _mm256_and_si256(_mm256_castps_si256(active[v]), one));
+
+                if (!checks) continue;
+                const auto same = _mm256_and_ps(_mm256_cmp_ps(zr[v], sr[v], _CMP_EQ_OQ),
+                                                _mm256_cmp_ps(zi[v], si[v], _CMP_EQ_OQ));
+                const auto cycle = _mm256_and_ps(active[v], same);
+                test[v] = _mm256_blendv_epi8(test[v], _mm256_set1_epi32(static_cast<int>(interior_test::period)),
+                                             _mm256_castps_si256(cycle));
+                active[v] = _mm256_andnot_ps(cycle, active[v]);
+                if ((i & (i + 1)) == 0) {
+                    sr[v] = zr[v];
+                    si[v] = zi[v];
+                }
+            }
+        }
+
+        for (int v = 0; v < 2; v++) {
+            // stopped pixels report max_iter, like escape_time_scalar()
+            it[v] = _mm256_blendv_epi8(it[v], max_iter, _mm256_cmpgt_epi32(test[v], _mm256_setzero_si256()));
+            _mm256_storeu_ps(span.re + k + v * lanes, zr[v]);
+            _mm256_storeu_ps(span.im + k + v * lanes, zi[v]);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(span.iter + k + v * lanes), it[v]);
+            if (span.interior) {
+                alignas(32) std::int32_t t[lanes];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(t), test[v]);
+                for (std::size_t j = 0; j < lanes; j++) {
+                    span.interior[k + v * lanes + j] = static_cast<std::uint8_t>(t[j]);
+                }
+            }
+        }
+    }
+
+    escape_time_scalar(param, {span.x + k, span.y, span.count - k, span.re + k, span.im + k, span.iter + k,
+                               span.interior ? span.interior + k : nullptr, span.ys ? span.ys + k : nullptr});
+}
+
+__attribute__((target("avx512f"))) inline void escape_time_avx512(const escape_params& param,
+                                                                   const escape_span& span) {
+    constexpr std::size_t lanes = 16;
+    const auto n = param.max_iter;
+    const bool julia = param.kind == fractal_kind::julia;
+    const bool checks = param.interior_checks;
+    const auto four = _mm512_set1_ps(4.0f);
+    const auto one = _mm512_set1_epi32(1);
+    const auto y = _mm512_set1_ps(span.y);
+    const auto max_iter = _mm512_set1_epi32(static_cast<int>(n));
+
+    std::size_t k = 0;
+    for (; k + 2 * lanes <= span.count; k += 2 * lanes) {
+        __m512 zr[2], zi[2], cr[2], ci[2], sr[2], si[2];
+        __m512i it[2], test[2];
+        __mmask16 active[2];
+
+        for (int v = 0; v < 2; v++) {
+            zr[v] = _mm512_loadu_ps(span.x + k + v * lanes);
+            zi[v] = span.ys ? _mm512_loadu_ps(span.ys + k + v * lanes) : y;
+            cr[v] = zr[v];
+            ci[v] = zi[v];
+            if (julia) {
+                cr[v] = _mm512_set1_ps(param.c[0]);
+                ci[v] = _mm512_set1_ps(param.c[1]);
+                const auto r = _mm512_sub_ps(_mm512_mul_ps(zr[v], zr[v]), _mm512_mul_ps(zi[v], zi[v]));
+                const auto i = _mm512_add_ps(_mm512_mul_ps(zr[v], zi[v]), _mm512_mul_ps(zi[v], zr[v]));
+                zr[v] = _mm512_add_ps(r, cr[v]);
+                zi[v] = _mm512_add_ps(i, ci[v]);
+            }
+            it[v] = _mm512_setzero_si512();
+            test[v] = _mm512_setzero_si512();
+            active[v] = 0xffff;
+            sr[v] = zr[v];
+            si[v] = zi[v];
+
+            // in_main_cardioid() / in_period2_bulb(), same operations
+            if (checks && !julia) {
+                const auto yy = _mm512_mul_ps(ci[v], ci[v]);
+                const auto a = _mm512_sub_ps(cr[v], _mm512_set1_ps(0.25f));
+                const auto q = _mm512_add_ps(_mm512_mul_ps(a, a), yy);
+                const __mmask16 cardioid = _mm512_cmp_ps_mask(_mm512_mul_ps(q, _mm512_add_ps(q, a)),
+                                                              _mm512_mul_ps(_mm512_set1_ps(0.25f), yy), _CMP_LE_OQ);
+                const auto b = _mm512_add_ps(cr[v], _mm512_set1_ps(1.0f));
+                const __mmask16 bulb = _mm512_mask_cmp_ps_mask(
+                    ~cardioid, _mm512_add_ps(_mm512_mul_ps(b, b), yy), _mm512_set1_ps(0.0625f), _CMP_LE_OQ);
+                test[v] = _mm512_mask_mov_epi32(test[v], cardioid,
+                                                _mm512_set1_epi32(static_cast<int>(interior_test::cardioid)));
+                test[v] =
+                    _mm512_mask_mov_epi32(test[v], bulb, _mm512_set1_epi32(static_cast<int>(interior_test::bulb)));
+                active[v] = static_cast<__mmask16>(~(cardioid | bulb));
+            }
+        }
+
+        for (std::uint32_t i = 0; i < n; i++) {
+            if (!(active[0] | active[1])) break;
+
+            for (int v = 0; v < 2; v++) {
+                const auto r = _mm512_sub_ps(_mm512_mul_ps(zr[v], zr[v]), _mm512_mul_ps(zi[v], zi[v]));
+                const auto m = _mm512_add_ps(_mm512_mul_ps(zr[v], zi[v]), _mm512_mul_ps(zi[v], zr[v]));
+                zr[v] = _mm512_mask_add_ps(zr[v], active[v], r, cr[v]);
+                zi[v] = _mm512_mask_add_ps(zi[v], active[v], m, ci[v]);
+
+                const auto norm = _mm512_add_ps(_mm512_mul_ps(zr[v], zr[v]), _mm512_mul_ps(zi[v], zi[v]));
+                active[v] = _mm512_mask_cmp_ps_mask(active[v], norm, four, _CMP_LE_OQ);
+                it[v] = _mm512_mask_add_epi32(it[v], active[v], it[v], one);
+
+                if (!checks) continue;
+                const __mmask16 same_re = _mm512_mask_cmp_ps_mask(active[v], zr[v], sr[v], _CMP_EQ_OQ);
+                const __mmask16 cycle = _mm512_mask_cmp_ps_mask(same_re, zi[v], si[v], _CMP_EQ_OQ);
+                test[v] =
+                    _mm512_mask_mov_epi32(test[v], cycle, _mm512_set1_epi32(static_cast<int>(interior_test::period)));
+                active[v] = static_cast<__mmask16>(active[v] & ~cycle);
+                if ((i & (i + 1)) == 0) {
+                    sr[v] = zr[v];
+                    si[v] = zi[v];
+                }
+            }
+        }
+
+        for (int v = 0; v < 2; v++) {
+            // stopped pixels report max_iter, like escape_time_scalar()
+            it[v] = _mm512_mask_mov_epi32(it[v], _mm512_test_epi32_mask(test[v], test[v]), max_iter);
+            _mm512_storeu_ps(span.re + k + v * lanes, zr[v]);
+            _mm512_storeu_ps(span.im + k + v * lanes, zi[v]);
+            _mm512_storeu_si512(span.iter + k + v * lanes, it[v]);
+            if (span.interior) _mm512_mask_cvtepi32_storeu_epi8(span.interior + k + v * lanes, 0xffff, test[v]);
+        }
+    }
+
+    escape_time_scalar(param, {span.x + k, span.y, span.count - k, span.re + k, span.im + k, span.iter + k,
+                               span.interior ? span.interior + k : nullptr, span.ys ? span.ys + k : nullptr});
+}
+
+#if !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+#endif  // PRACC_GL_ESCAPE_TIME_X86
+
+/**
+ * @brief widest instruction set supported by the running CPU
+ */
+inline escape_isa detect_escape_isa() {
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return escape_isa::avx512;
+    if (__builtin_cpu_supports("avx2")) return escape_isa::avx2;
+#endif
+    return escape_isa::scalar;
+}
+
+inline const char* escape_isa_to_string(escape_isa isa) {
+    switch (isa) {
+        case escape_isa::scalar:
+            return "scalar";
+        case escape_isa::avx2:
+            return "avx2";
+        case escape_isa::avx512:
+            return "avx512";
+        default:
+            return "No match isa";
+    }
+}
+
+/**
+ * @brief kernel for isa, falling back to narrower ones the CPU actually has
+ */
+inline escape_kernel select_escape_kernel(escape_isa isa = detect_escape_isa()) {
+    isa = std::min(isa, detect_escape_isa());
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+    if (isa == escape_isa::avx512) return escape_time_avx512;
+    if (isa == escape_isa::avx2) return escape_time_avx2;
+#endif
+    return escape_time_scalar;
+}
+
+/**
+ * @brief plane coordinate of each pixel column (or row), computed like the shader does from gl_FragCoord
+ * @param frame_len winsize the mapping is for when the len pixels are a tile of a larger frame
+ */
+inline std::vector<float> escape_axis(std::size_t len, std::size_t min_len, float scale, float center,
+                                      float pan = 0.0f, std::size_t frame_len = 0) {
+    std::vector<float> axis(len);
+    const auto w = static_cast<float>(frame_len ? frame_len : len);
+    const auto m = static_cast<float>(min_len);
+    for (std::size_t i = 0; i < len; i++) {
+        axis[i] = ((static_cast<float>(i) + pan + 0.5f) * 2.0f - w) / m * scale + center;
+    }
+    return axis;
+}
+
+/**
+ * @brief render the pixels [x0, x1) x [y0, y1) of out with kernel, leaving the rest untouched
+ * Row 0 is the bottom row, as with gl_FragCoord.
+ */
+inline void render_escape_time_rect(const escape_params& param, const escape_view& view, escape_buffer& out,
+                                    std::size_t x0, std::size_t y0, std::size_t x1, std::size_t y1,
+                                    escape_kernel kernel = select_escape_kernel()) {
+    const auto frame = view_frame(view, out);
+    const auto m = std::min(frame[0], frame[1]);
+    const auto xs = escape_axis(out.width, m, view.scale, view.center[0], view.pan[0], frame[0]);
+    const auto ys = escape_axis(out.height, m, view.scale, view.center[1], view.pan[1], frame[1]);
+
+    for (auto row = y0; row < y1; row++) {
+        const auto offset = row * out.width + x0;
+        kernel(param, {xs.data() + x0, ys[row], x1 - x0, out.re.data() + offset, out.im.data() + offset,
+                       out.iter.data() + offset, out.interior.data() + offset});
+    }
+}
+
+/**
+ * @brief render rows [row_begin, row_end) of out with kernel
+ */
+inline void render_escape_time_rows(const escape_params& param, const escape_view& view, escape_buffer& out,
+                                    std::size_t row_begin, std::size_t row_end,
+                                    escape_kernel kernel = select_escape_kernel()) {
+    render_escape_time_rect(param, view, out, 0, row_begin, out.width, row_end, kernel);
+}
+
+inline void render_escape_time(const escape_params& param, const escape_view& view, escape_buffer& out,
+                               escape_kernel kernel = select_escape_kernel()) {
+    render_escape_time_rows(param, view, out, 0, out.height, kernel);
+}
+
+/**
+ * @brief same coloring as main() of mandelbrot.frag / julia.frag (50 / 100 there are max_iter / 2 * max_iter)
+ */
+inline std::array<float, 3> escape_color(float re, float im, std::uint32_t iter, std::uint32_t max_iter) {
+    const float escaped = re * re + im * im > 4.0f ? 1.0f : 0.0f;
+    const float t = static_cast<float>(iter) / static_cast<float>(max_iter);
+    return {t * escaped, t * escaped, (1.0f - t / 2.0f) * escaped};
+}
+
+inline std::vector<std::array<float, 3>> colorize_escape_time(const escape_buffer& buf, std::uint32_t max_iter) {
+    std::vector<std::array<float, 3>> rgb(buf.width * buf.height);
+    for (std::size_t i = 0; i < rgb.size(); i++) {
+        rgb[i] = escape_color(buf.re[i], buf.im[i], buf.iter[i], max_iter);
+    }
+    return rgb;
+}
+
+/**
+ * @brief white axis lines drawn by main() of mandelbrot.frag
+ */
+inline void draw_escape_axes(std::vector<std::array<float, 3>>& rgb, std::size_t width, std::size_t height,
+                             const escape_view& view) {
+    const auto m = std::min(width, height);
+    const auto xs = escape_axis(width, m, view.scale, view.center[0], view.pan[0]);
+    const auto ys = escape_axis(height, m, view.scale, view.center[1], view.pan[1]);
+
+    for (std::size_t row = 0; row < height; row++) {
+        for (std::size_t col = 0; col < width; col++) {
+            const bool on_x = xs[col] < 0.005f && xs[col] > 0.0f;
+            const bool on_y = ys[row] < 0.005f && ys[row] > 0.0f;
+            if (on_x || on_y) rgb[row * width + col] = {1.0f, 1.0f, 1.0f};
+        }
+    }
+}
+
+#endif  // PRACC_GL_ESCAPE_TIME_H
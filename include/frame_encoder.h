@@ -0,0 +1,159 @@
+/**
+ * @file frame_encoder.h
+ * @brief encoder threads turning read back frames into numbered images or one Y4M / raw video stream
+ */
+
+#ifndef PRACC_GL_FRAME_ENCODER_H
+#define PRACC_GL_FRAME_ENCODER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "include/bounded_queue.h"
+#include "include/image_io.h"
+
+/**
+ * @brief one finished frame, bottom-up RGBA8
+ */
+struct readback_frame {
+    std::size_t index;
+    int width;
+    int height;
+    std::vector<std::uint8_t> rgba;
+};
+
+/**
+ * @brief ppm / png: PREFIX000000.ext per frame; y4m / raw (rgb24): every frame appended to one file
+ */
+enum class frame_format {
+    ppm,
+    png,
+    y4m,
+    raw,
+};
+
+inline frame_format frame_format_from_string(std::string_view name) {
+    if (name == "png") return frame_format::png;
+    if (name == "y4m") return frame_format::y4m;
+    if (name == "raw") return frame_format::raw;
+    return frame_format::ppm;
+}
+
+inline const char* frame_format_to_string(frame_format format) {
+    switch (format) {
+        case frame_format::png:
+            return "png";
+        case frame_format::y4m:
+            return "y4m";
+        case frame_format::raw:
+            return "raw";
+        default:
+            return "ppm";
+    }
+}
+
+/**
+ * @class frame_encoder
+ * @brief encodes frames on its own threads so neither the conversion nor disk I/O stalls the GL thread
+ * Frames are encoded in parallel. The streamed formats write them strictly in index order, so a frame
+ * that finished early waits for its turn. push() blocks once capacity frames are queued. The memory held
+ * is therefore at most capacity + threads frames, however long the animation is. Frames have to be pushed
+ * in index order starting at 0; the output only depends on their content, not on the thread count.
+ */
+class frame_encoder {
+private:
+    std::string out_;
+    frame_format format_;
+    int fps_;
+    bounded_queue<readback_frame> queue_;
+    std::ofstream stream_;
+    std::mutex mtx_;
+    std::condition_variable turn_;
+    std::size_t next_ = 0;
+    std::vector<std::thread> threads_;
+
+    std::vector<std::uint8_t> encode(const readback_frame& frame) const {
+        switch (format_) {
+            case frame_format::png:
+                return encode_png_rgba8(frame.width, frame.height, frame.rgba.data());
+            case frame_format::y4m:
+                return encode_y4m_frame_rgba8(frame.width, frame.height, frame.rgba.data());
+            case frame_format::raw:
+                return encode_rgb24_rgba8(frame.width, frame.height, frame.rgba.data());
+            default:
+                return encode_ppm_rgba8(frame.width, frame.height, frame.rgba.data());
+        }
+    }
+
+    void write_file(const readback_frame& frame, const std::vector<std::uint8_t>& bytes) const {
+        char number[32];
+        std::snprintf(number, sizeof(number), "%06zu", frame.index);
+        const auto path = out_ + number + "." + frame_format_to_string(format_);
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!out) std::cerr << "failed to write " << path << std::endl;
+    }
+
+    void write_stream(const readback_frame& frame, const std::vector<std::uint8_t>& bytes) {
+        std::unique_lock lock(mtx_);
+        turn_.wait(lock, [&] { return next_ == frame.index; });
+        if (next_ == 0 && format_ == frame_format::y4m) {
+            stream_ << "YUV4MPEG2 W" << frame.width << " H" << frame.height << " F" << fps_ << ":1 Ip A1:1 C420jpeg\n";
+        }
+        stream_.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        next_++;
+        lock.unlock();
+        turn_.notify_all();
+    }
+
+    bool streamed() const { return format_ == frame_format::y4m || format_ == frame_format::raw; }
+
+public:
+    /**
+     * @param out file name prefix for ppm / png, the file itself for y4m / raw
+     * @param fps frame rate written into the Y4M header
+     */
+    frame_encoder(std::string out, frame_format format = frame_format::ppm, std::size_t threads = 2, int fps = 60,
+                  std::size_t capacity = 4)
+        : out_{std::move(out)}, format_{format}, fps_{fps}, queue_{capacity} {
+        if (streamed()) {
+            stream_.open(out_, std::ios::binary);
+            if (!stream_) std::cerr << "failed to open " << out_ << std::endl;
+        }
+        for (std::size_t i = 0; i < (threads ? threads : 1); i++) {
+            threads_.emplace_back([this] {
+                while (auto frame = queue_.pop()) {
+                    const auto bytes = encode(*frame);
+                    if (streamed()) {
+                        write_stream(*frame, bytes);
+                    } else {
+                        write_file(*frame, bytes);
+                    }
+                }
+            });
+        }
+    }
+
+    frame_encoder(const frame_encoder&) = delete;
+    frame_encoder& operator=(const frame_encoder&) = delete;
+
+    ~frame_encoder() {
+        queue_.close();
+        for (auto& t : threads_) t.join();
+        if (streamed() && !stream_.flush()) std::cerr << "failed to write " << out_ << std::endl;
+    }
+
+    void push(readback_frame frame) { queue_.push(std::move(frame)); }
+};
+
+#endif  // PRACC_GL_FRAME_ENCODER_H
@@ -0,0 +1,237 @@
+/**
+ * @file frame_profiler.h
+ * @brief per-pass CPU timers and GL_TIME_ELAPSED queries per frame, with Chrome trace export
+ */
+
+#ifndef PRACC_GL_FRAME_PROFILER_H
+#define PRACC_GL_FRAME_PROFILER_H
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @class frame_profiler
+ * @brief times named passes of every frame on the CPU and, through timer queries, on the GPU
+ * Every GPU pass has two queries used on alternating frames. A result is collected once it is available,
+ * normally one frame later, and dropped if it is still pending when its query comes around again, so
+ * nothing ever waits on the GPU. GL_TIME_ELAPSED cannot nest, so GPU passes must not overlap; each name is
+ * meant to be timed once per frame. The last history frames are kept for the overlay and the trace.
+ */
+class frame_profiler {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct slice {
+        std::size_t pass;
+        double begin_us;
+        double cpu_us;
+        double gpu_us = -1.0;  // still pending, or a CPU-only pass
+    };
+
+    struct frame_record {
+        std::size_t index;
+        double begin_us;
+        double end_us = 0.0;
+        std::vector<slice> slices;
+    };
+
+    /**
+     * @class scope
+     * @brief ends its pass when destroyed
+     */
+    class scope {
+    private:
+        frame_profiler* profiler_;
+        std::size_t pass_;
+        clock::time_point begin_;
+
+    public:
+        scope(frame_profiler* profiler, std::size_t pass) : profiler_{profiler}, pass_{pass}, begin_{clock::now()} {}
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+        ~scope() { profiler_->end_pass(pass_, begin_); }
+    };
+
+private:
+    struct pass_info {
+        std::string name;
+        bool gpu;
+        std::array<GLuint, 2> query = {};
+        std::array<bool, 2> pending = {};
+        std::array<std::size_t, 2> frame = {};  // frame and slice the pending result belongs to
+        std::array<std::size_t, 2> slice = {};
+    };
+
+    std::vector<pass_info> passes_;
+    std::deque<frame_record> frames_;
+    std::size_t history_;
+    std::size_t next_index_ = 0;
+    clock::time_point origin_ = clock::now();
+
+    double now_us() const { return std::chrono::duration<double, std::micro>(clock::now() - origin_).count(); }
+
+    frame_record* find_frame(std::size_t index) {
+        if (frames_.empty() || index < frames_.front().index || index > frames_.back().index) return nullptr;
+        return &frames_[index - frames_.front().index];
+    }
+
+    void collect(pass_info& p, std::size_t slot) {
+        if (!p.pending[slot]) return;
+        GLint available = 0;
+        glGetQueryObjectiv(p.query[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(p.query[slot], GL_QUERY_RESULT, &ns);
+        p.pending[slot] = false;
+        if (auto* f = find_frame(p.frame[slot])) f->slices[p.slice[slot]].gpu_us = static_cast<double>(ns) / 1000.0;
+    }
+
+    std::size_t find_pass(std::string_view name, bool gpu) {
+        for (std::size_t i = 0; i < passes_.size(); i++) {
+            if (passes_[i].name == name) return i;
+        }
+        pass_info p;
+        p.name = name;
+        p.gpu = gpu;
+        if (gpu) glCreateQueries(GL_TIME_ELAPSED, 2, p.query.data());
+        passes_.push_back(std::move(p));
+        return passes_.size() - 1;
+    }
+
+    void end_pass(std::size_t pass, clock::time_point begin) {
+        auto& p = passes_[pass];
+        if (p.gpu) glEndQuery(GL_TIME_ELAPSED);
+        if (frames_.empty()) return;
+        auto& f = frames_.back();
+        const double begin_us = std::chrono::duration<double, std::micro>(begin - origin_).count();
+        f.slices.push_back({pass, begin_us, now_us() - begin_us, -1.0});
+        if (p.gpu) {
+            const auto slot = f.index % 2;
+            p.pending[slot] = true;
+            p.frame[slot] = f.index;
+            p.slice[slot] = f.slices.size() - 1;
+        }
+    }
+
+public:
+    explicit frame_profiler(std::size_t history = 600) : history_{std::max<std::size_t>(history, 1)} {}
+
+    frame_profiler(const frame_profiler&) = delete;
+    frame_profiler& operator=(const frame_profiler&) = delete;
+
+    ~frame_profiler() {
+        for (auto& p : passes_) {
+            if (p.gpu) glDeleteQueries(2, p.query.data());
+        }
+    }
+
+    /**
+     * @brief start a frame and pick up whatever GPU results have arrived since the last one
+     */
+    void begin_frame() {
+        for (auto& p : passes_) {
+            if (!p.gpu) continue;
+            collect(p, 0);
+            collect(p, 1);
+        }
+        frames_.push_back({next_index_++, now_us(), 0.0, {}});
+        while (frames_.size() > history_) frames_.pop_front();
+    }
+
+    void end_frame() {
+        if (!frames_.empty()) frames_.back().end_us = now_us();
+    }
+
+    /**
+     * @brief time everything until the returned scope is destroyed; gpu adds a timer query around it
+     */
+    [[nodiscard]] scope pass(std::string_view name, bool gpu = true) {
+        const auto i = find_pass(name, gpu);
+        auto& p = passes_[i];
+        if (p.gpu) {
+            // a result still pending from two frames ago is dropped rather than waited for
+            const auto slot = frames_.empty() ? 0 : frames_.back().index % 2;
+            collect(p, slot);
+            p.pending[slot] = false;
+            glBeginQuery(GL_TIME_ELAPSED, p.query[slot]);
+        }
+        return {this, i};
+    }
+
+    std::size_t pass_count() const { return passes_.size(); }
+    const std::string& pass_name(std::size_t pass) const { return passes_[pass].name; }
+    bool pass_gpu(std::size_t pass) const { return passes_[pass].gpu; }
+    const std::deque<frame_record>& frames() const { return frames_; }
+
+    /**
+     * @brief milliseconds pass took in each kept frame, oldest first; 0 where it did not run or is pending
+     */
+    std::vector<float> series(std::size_t pass, bool gpu) const {
+        std::vector<float> ret;
+        ret.reserve(frames_.size());
+        for (const auto& f : frames_) {
+            double us = 0.0;
+            for (const auto& s : f.slices) {
+                if (s.pass == pass) us += gpu ? std::max(s.gpu_us, 0.0) : s.cpu_us;
+            }
+            ret.push_back(static_cast<float>(us / 1000.0));
+        }
+        return ret;
+    }
+
+    /**
+     * @brief whole frames in milliseconds, oldest first
+     */
+    std::vector<float> frame_series() const {
+        std::vector<float> ret;
+        ret.reserve(frames_.size());
+        for (const auto& f : frames_) ret.push_back(static_cast<float>(std::max(f.end_us - f.begin_us, 0.0) / 1000.0));
+        return ret;
+    }
+
+    /**
+     * @brief the kept frames as Chrome trace event JSON (chrome://tracing, ui.perfetto.dev)
+     * CPU passes go on a "cpu" track inside their frame slice. GL_TIME_ELAPSED only measures durations, so GPU
+     * slices go on a "gpu" track, each starting at its pass's CPU start or where the previous one ended.
+     */
+    bool write_chrome_trace(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+
+        out << "{\"traceEvents\": [\n";
+        out << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"cpu\"}},\n";
+        out << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": {\"name\": \"gpu\"}}";
+        const auto event = [&](std::string_view name, int tid, double ts, double dur) {
+            out << ",\n  {\"name\": \"" << name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tid
+                << ", \"ts\": " << ts << ", \"dur\": " << dur << "}";
+        };
+        out << std::fixed;
+        out.precision(3);
+        double gpu_end = 0.0;
+        for (const auto& f : frames_) {
+            if (f.end_us > f.begin_us) event("frame " + std::to_string(f.index), 1, f.begin_us, f.end_us - f.begin_us);
+            for (const auto& s : f.slices) {
+                event(passes_[s.pass].name, 1, s.begin_us, s.cpu_us);
+                if (s.gpu_us < 0.0) continue;
+                const double ts = std::max(s.begin_us, gpu_end);
+                event(passes_[s.pass].name, 2, ts, s.gpu_us);
+                gpu_end = ts + s.gpu_us;
+            }
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+};
+
+#endif  // PRACC_GL_FRAME_PROFILER_H
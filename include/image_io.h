@@ -0,0 +1,198 @@
+#ifndef PRACC_GL_IMAGE_IO_H
+#define PRACC_GL_IMAGE_IO_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief float [0, 1] -> 8bit
+ */
+constexpr std::uint8_t to_u8(float v) {
+    return static_cast<std::uint8_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+/**
+ * @brief write binary PPM (P6)
+ * rows are bottom-up like glReadPixels / gl_FragCoord, PPM is top-down, so they are flipped here.
+ */
+inline bool write_ppm(const char* path, std::size_t width, std::size_t height, const std::vector<std::array<float, 3>>& rgb) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+
+    out << "P6\n" << width << ' ' << height << "\n255\n";
+
+    std::vector<std::uint8_t> line(width * 3);
+    for (std::size_t row = height; row-- > 0;) {
+        for (std::size_t col = 0; col < width; col++) {
+            const auto& px = rgb[row * width + col];
+            line[col * 3 + 0] = to_u8(px[0]);
+            line[col * 3 + 1] = to_u8(px[1]);
+            line[col * 3 + 2] = to_u8(px[2]);
+        }
+        out.write(reinterpret_cast<const char*>(line.data()), static_cast<std::streamsize>(line.size()));
+    }
+
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief binary PPM (P6) from bottom-up RGBA8 rows as returned by glReadPixels
+ */
+inline std::vector<std::uint8_t> encode_ppm_rgba8(std::size_t width, std::size_t height, const std::uint8_t* rgba) {
+    const auto header = "P6\n" + std::to_string(width) + ' ' + std::to_string(height) + "\n255\n";
+    std::vector<std::uint8_t> ret(header.begin(), header.end());
+    ret.reserve(header.size() + width * height * 3);
+    for (std::size_t row = height; row-- > 0;) {
+        const auto* src = rgba + row * width * 4;
+        for (std::size_t col = 0; col < width; col++) ret.insert(ret.end(), src + col * 4, src + col * 4 + 3);
+    }
+    return ret;
+}
+
+inline bool write_ppm_rgba8(const char* path, std::size_t width, std::size_t height, const std::uint8_t* rgba) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    const auto bytes = encode_ppm_rgba8(width, height, rgba);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief top-down rgb24 rows without any header, e.g. for ffmpeg -f rawvideo -pixel_format rgb24
+ */
+inline std::vector<std::uint8_t> encode_rgb24_rgba8(std::size_t width, std::size_t height, const std::uint8_t* rgba) {
+    std::vector<std::uint8_t> ret;
+    ret.reserve(width * height * 3);
+    for (std::size_t row = height; row-- > 0;) {
+        const auto* src = rgba + row * width * 4;
+        for (std::size_t col = 0; col < width; col++) ret.insert(ret.end(), src + col * 4, src + col * 4 + 3);
+    }
+    return ret;
+}
+
+/**
+ * @brief one Y4M "FRAME" of 4:2:0 BT.601 limited range YCbCr
+ * Chroma is taken from the average of each 2x2 block (centered, C420jpeg); odd sizes repeat the last row / column.
+ */
+inline std::vector<std::uint8_t> encode_y4m_frame_rgba8(std::size_t width, std::size_t height,
+                                                        const std::uint8_t* rgba) {
+    const std::string header = "FRAME\n";
+    const auto cw = (width + 1) / 2;
+    const auto ch = (height + 1) / 2;
+    std::vector<std::uint8_t> ret(header.size() + width * height + 2 * cw * ch);
+    std::copy(header.begin(), header.end(), ret.begin());
+    auto* y = ret.data() + header.size();
+    auto* cb = y + width * height;
+    auto* cr = cb + cw * ch;
+
+    // glReadPixels rows are bottom-up, Y4M is top-down
+    const auto px = [&](std::size_t col, std::size_t row) { return rgba + ((height - 1 - row) * width + col) * 4; };
+    for (std::size_t row = 0; row < height; row++) {
+        for (std::size_t col = 0; col < width; col++) {
+            const auto* p = px(col, row);
+            y[row * width + col] = static_cast<std::uint8_t>(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+        }
+    }
+    for (std::size_t row = 0; row < ch; row++) {
+        for (std::size_t col = 0; col < cw; col++) {
+            int rgb[3] = {};
+            for (const auto dy : {std::size_t{0}, std::size_t{1}}) {
+                for (const auto dx : {std::size_t{0}, std::size_t{1}}) {
+                    const auto* p = px(std::min(2 * col + dx, width - 1), std::min(2 * row + dy, height - 1));
+                    for (int k = 0; k < 3; k++) rgb[k] += p[k];
+                }
+            }
+            for (auto& c : rgb) c = (c + 2) / 4;
+            cb[row * cw + col] = static_cast<std::uint8_t>(((-38 * rgb[0] - 74 * rgb[1] + 112 * rgb[2] + 128) >> 8) + 128);
+            cr[row * cw + col] = static_cast<std::uint8_t>(((112 * rgb[0] - 94 * rgb[1] - 18 * rgb[2] + 128) >> 8) + 128);
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief CRC-32 (ISO 3309) as PNG chunks use it
+ */
+inline std::uint32_t png_crc32(const std::uint8_t* data, std::size_t len, std::uint32_t crc = 0) {
+    static const auto table = [] {
+        std::array<std::uint32_t, 256> t;
+        for (std::uint32_t n = 0; n < 256; n++) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < len; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+/**
+ * @brief RGB PNG from bottom-up RGBA8 rows, stored without compression
+ * The zlib stream holds only stored deflate blocks, which needs no zlib and costs a copy per frame; files
+ * are as large as PPM. Re-encode them (e.g. optipng, ffmpeg) where size matters.
+ */
+inline std::vector<std::uint8_t> encode_png_rgba8(std::size_t width, std::size_t height, const std::uint8_t* rgba) {
+    std::vector<std::uint8_t> ret = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    const auto be32 = [](std::vector<std::uint8_t>& v, std::uint32_t x) {
+        for (int shift = 24; shift >= 0; shift -= 8) v.push_back(static_cast<std::uint8_t>(x >> shift));
+    };
+    const auto chunk = [&](const char* type, const std::vector<std::uint8_t>& data) {
+        be32(ret, static_cast<std::uint32_t>(data.size()));
+        const auto start = ret.size();
+        ret.insert(ret.end(), type, type + 4);
+        ret.insert(ret.end(), data.begin(), data.end());
+        be32(ret, png_crc32(ret.data() + start, ret.size() - start));
+    };
+
+    std::vector<std::uint8_t> ihdr;
+    be32(ihdr, static_cast<std::uint32_t>(width));
+    be32(ihdr, static_cast<std::uint32_t>(height));
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0});  // 8 bit, RGB, deflate, adaptive filters, no interlace
+    chunk("IHDR", ihdr);
+
+    // every scanline is filter type 0 (none) followed by its pixels, top-down
+    std::vector<std::uint8_t> raw;
+    raw.reserve(height * (1 + width * 3));
+    for (std::size_t row = height; row-- > 0;) {
+        raw.push_back(0);
+        const auto* src = rgba + row * width * 4;
+        for (std::size_t col = 0; col < width; col++) raw.insert(raw.end(), src + col * 4, src + col * 4 + 3);
+    }
+
+    std::vector<std::uint8_t> z = {0x78, 0x01};
+    std::uint32_t a = 1;
+    std::uint32_t b = 0;
+    for (std::size_t pos = 0; pos < raw.size() || pos == 0;) {
+        const auto len = std::min<std::size_t>(raw.size() - pos, 65535);
+        z.push_back(pos + len == raw.size() ? 1 : 0);
+        z.insert(z.end(), {static_cast<std::uint8_t>(len), static_cast<std::uint8_t>(len >> 8),
+                           static_cast<std::uint8_t>(~len), static_cast<std::uint8_t>(~len >> 8)});
+        z.insert(z.end(), raw.begin() + static_cast<std::ptrdiff_t>(pos),
+                 raw.begin() + static_cast<std::ptrdiff_t>(pos + len));
+        for (std::size_t i = pos; i < pos + len;) {
+            // 5552 bytes is the longest run whose sums cannot overflow before the modulo
+            const auto end = std::min(pos + len, i + 5552);
+            for (; i < end; i++) {
+                a += raw[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        pos += len;
+        if (len == 0) break;
+    }
+    be32(z, (b << 16) | a);
+    chunk("IDAT", z);
+    chunk("IEND", {});
+    return ret;
+}
+
+#endif  // PRACC_GL_IMAGE_IO_H
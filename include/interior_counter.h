@@ -0,0 +1,104 @@
+/**
+ * @file interior_counter.h
+ * @brief GL side of the interior checks: per frame counts of the pixels each check stopped
+ */
+
+#ifndef PRACC_GL_INTERIOR_COUNTER_H
+#define PRACC_GL_INTERIOR_COUNTER_H
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+
+#include "include/escape_time.h"
+
+/**
+ * @class interior_counter
+ * @brief the interior_counts SSBO of mandelbrot.frag / julia.frag, read back without stalling
+ * Two buffers are used on alternating frames, like the timer queries of frame_profiler. begin_frame() clears
+ * one and binds it, end_frame() fences the frame's draws into it, and a fenced buffer is read once its fence
+ * has signalled, normally one frame later. A frame that drew nothing keeps the last counts.
+ */
+class interior_counter {
+public:
+    static constexpr GLuint binding = 2;
+
+private:
+    std::array<GLuint, 2> buffer_ = {};
+    std::array<GLsync, 2> fence_ = {};
+    std::size_t slot_ = 0;
+    interior_stats last_;
+    interior_stats total_;
+
+    void collect(std::size_t slot, GLuint64 timeout) {
+        if (!fence_[slot]) return;
+        const auto status = glClientWaitSync(fence_[slot], timeout ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+        glDeleteSync(fence_[slot]);
+        fence_[slot] = nullptr;
+
+        GLuint counts[3];
+        glGetNamedBufferSubData(buffer_[slot], 0, sizeof(counts), counts);
+        last_ = {counts[0], counts[1], counts[2]};
+        total_ += last_;
+    }
+
+public:
+    interior_counter() {
+        glCreateBuffers(2, buffer_.data());
+        for (auto b : buffer_) glNamedBufferStorage(b, 3 * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+
+    interior_counter(const interior_counter&) = delete;
+    interior_counter& operator=(const interior_counter&) = delete;
+
+    ~interior_counter() {
+        for (auto f : fence_) {
+            if (f) glDeleteSync(f);
+        }
+        glDeleteBuffers(2, buffer_.data());
+    }
+
+    /**
+     * @brief collect the counts that have arrived, then clear the next buffer and bind it for this frame
+     */
+    void begin_frame() {
+        // older frame first, so last() ends up with the newer one
+        collect(slot_ ^ 1, 0);
+        collect(slot_, 0);
+        slot_ ^= 1;
+        // still pending from two frames ago: dropped rather than waited for
+        if (fence_[slot_]) {
+            glDeleteSync(fence_[slot_]);
+            fence_[slot_] = nullptr;
+        }
+        glClearNamedBufferData(buffer_[slot_], GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer_[slot_]);
+    }
+
+    /**
+     * @brief drew tells whether any counting pass ran this frame; only then are its counts read back
+     */
+    void end_frame(bool drew) {
+        if (!drew) return;
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        fence_[slot_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    /**
+     * @brief wait for every fenced frame, e.g. before reading total() at the end of a batch
+     */
+    void finish() {
+        collect(slot_ ^ 1, GL_TIMEOUT_IGNORED);
+        collect(slot_, GL_TIMEOUT_IGNORED);
+    }
+
+    /**
+     * @brief counts of the last frame read back that drew, and the sum over all of them
+     */
+    const interior_stats& last() const { return last_; }
+    const interior_stats& total() const { return total_; }
+};
+
+#endif  // PRACC_GL_INTERIOR_COUNTER_H
@@ -0,0 +1,415 @@
+/**
+ * @file julia_atlas.h
+ * @brief low resolution julia renders over a grid of c, shown while the exact julia pane is computed
+ */
+
+#ifndef PRACC_GL_JULIA_ATLAS_H
+#define PRACC_GL_JULIA_ATLAS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "include/escape_time.h"
+#include "include/palette.h"
+#include "include/thread_pool.h"
+
+/**
+ * @brief julia constant julia.frag uses for its init uniform
+ */
+inline std::array<float, 2> julia_constant(float init_re, float init_im) {
+    return {init_re * 1.5f - 0.5f, init_im * 1.5f};
+}
+
+/**
+ * @brief the plane julia.frag shows on a width x height pane, in escape_axis() terms
+ * The shader maps window coordinates, so a pane wider than tall is off center by 4 * width / height - 4.
+ */
+inline escape_view julia_pane_view(std::size_t width, std::size_t height) {
+    const auto m = static_cast<float>(std::min(width, height));
+    return {2.0f, {4.0f * static_cast<float>(width) / m - 4.0f, 0.0f}};
+}
+
+/**
+ * @brief (iteration count, smooth count) pairs of buf as the first pass of the shaders writes them
+ */
+inline void escape_texels(const escape_buffer& buf, std::vector<std::array<float, 2>>& out) {
+    out.resize(buf.iter.size());
+    for (std::size_t i = 0; i < out.size(); i++) {
+        out[i] = {static_cast<float>(buf.iter[i]), smooth_iteration(buf.re[i], buf.im[i], buf.iter[i])};
+    }
+}
+
+/**
+ * @brief layout of a julia_atlas
+ * The c range [low, high] is split into grid x grid cells, and a cell that straddles the boundary of the
+ * mandelbrot set is halved up to refine more times. Every cell corner holds a size x size render of
+ * julia_default_view. The default range is the c of julia.frag for init in [-1, 1]^2, which is where the
+ * cursor puts it over the mandelbrot pane.
+ */
+struct julia_atlas_options {
+    std::size_t grid = 16;
+    std::size_t refine = 2;
+    std::size_t size = 64;
+    float low[2] = {-2.0f, -1.5f};
+    float high[2] = {1.0f, 1.5f};
+};
+
+/**
+ * @class julia_atlas
+ * @brief julia previews for any c in the atlas range, from renders computed on its own background threads
+ * One thread runs the requests with the others as its work_stealing_pool. An exact render asked for by
+ * exact() goes first. The entries go after it, coarse grid corners first, then the corners of ever smaller
+ * cells. preview() blends the corners of the finest cell around c whose corners are all done.
+ */
+class julia_atlas {
+public:
+    using texels = std::vector<std::array<float, 2>>;
+
+private:
+    struct exact_request {
+        escape_params param;
+        std::size_t width;
+        std::size_t height;
+
+        bool operator==(const exact_request& x) const {
+            return param.c[0] == x.param.c[0] && param.c[1] == x.param.c[1] &&
+                   param.max_iter == x.param.max_iter && param.interior_checks == x.param.interior_checks &&
+                   width == x.width && height == x.height;
+        }
+    };
+
+    julia_atlas_options opt_;
+    std::size_t n_;  // cells per side at the finest level
+    std::size_t step_;  // finest cells per grid cell
+    escape_kernel kernel_;
+    work_stealing_pool pool_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::size_t generation_ = 0;
+
+    // the atlas of param_, rebuilt from scratch when it changes; epoch_ tells stale results apart
+    std::optional<escape_params> param_;
+    std::size_t epoch_ = 0;
+    bool planned_ = false;
+    std::vector<std::size_t> leaf_;  // per finest cell, the size of the cell it belongs to
+    std::vector<std::size_t> order_;  // corners to render, in order
+    std::size_t next_ = 0;
+    std::size_t ready_ = 0;
+    std::vector<std::shared_ptr<const texels>> entries_;  // per corner, null until rendered
+
+    std::optional<exact_request> exact_pending_;
+    std::optional<exact_request> exact_running_;
+    std::optional<exact_request> exact_key_;
+    std::shared_ptr<const texels> exact_;
+
+    std::thread thread_;
+
+    std::array<float, 2> corner_c(std::size_t i, std::size_t j) const {
+        const auto t = [&](std::size_t k, std::size_t axis) {
+            return opt_.low[axis] + (opt_.high[axis] - opt_.low[axis]) * static_cast<float>(k) /
+                                        static_cast<float>(n_);
+        };
+        return {t(i, 0), t(j, 1)};
+    }
+
+    // which cells are split, and the corners they need; inside is whether the c of each corner is in the set
+    void plan(const escape_params& param, std::vector<std::size_t>& leaf, std::vector<std::size_t>& order) {
+        const auto nodes = n_ + 1;
+        std::vector<std::uint8_t> inside(nodes * nodes);
+        auto p = param;
+        p.kind = fractal_kind::mandelbrot;
+        pool_.parallel_for(nodes, [&](std::size_t j) {
+            std::vector<float> xs(nodes), re(nodes), im(nodes);
+            std::vector<std::uint32_t> iter(nodes);
+            std::vector<std::uint8_t> interior(nodes);
+            for (std::size_t i = 0; i < nodes; i++) xs[i] = corner_c(i, j)[0];
+            kernel_(p, {xs.data(), corner_c(0, j)[1], nodes, re.data(), im.data(), iter.data(), interior.data()});
+            for (std::size_t i = 0; i < nodes; i++) inside[j * nodes + i] = iter[i] == p.max_iter;
+        });
+
+        leaf.assign(n_ * n_, step_);
+        std::vector<std::size_t> level(nodes * nodes, 0);  // largest cell size a corner is needed for, 0 if none
+        const auto split = [&](auto&& self, std::size_t x0, std::size_t y0, std::size_t s) -> void {
+            bool mixed = false;
+            for (auto y = y0; y <= y0 + s && !mixed; y++) {
+                for (auto x = x0; x <= x0 + s && !mixed; x++) mixed = inside[y * nodes + x] != inside[y0 * nodes + x0];
+            }
+            if (mixed && s > 1) {
+                const auto h = s / 2;
+                for (const auto [dx, dy] : {std::array<std::size_t, 2>{0, 0}, {h, 0}, {0, h}, {h, h}}) {
+                    self(self, x0 + dx, y0 + dy, h);
+                }
+                return;
+            }
+            for (auto y = y0; y < y0 + s; y++) std::fill_n(leaf.begin() + y * n_ + x0, s, s);
+            const std::array<std::size_t, 2> corners[] = {{x0, y0}, {x0 + s, y0}, {x0, y0 + s}, {x0 + s, y0 + s}};
+            for (const auto [x, y] : corners) {
+                // a corner of a cell is also a corner of its ancestors when aligned to them
+                std::size_t a = s;
+                while (a < step_ && x % (2 * a) == 0 && y % (2 * a) == 0) a *= 2;
+                level[y * nodes + x] = std::max(level[y * nodes + x], a);
+            }
+        };
+        for (std::size_t y = 0; y < n_; y += step_) {
+            for (std::size_t x = 0; x < n_; x += step_) split(split, x, y, step_);
+        }
+
+        order.clear();
+        for (std::size_t k = 0; k < level.size(); k++) {
+            if (level[k]) order.push_back(k);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](auto a, auto b) { return level[a] > level[b]; });
+    }
+
+    std::shared_ptr<const texels> render_entry(const escape_params& param, std::size_t node) {
+        const auto c = corner_c(node % (n_ + 1), node / (n_ + 1));
+        auto p = param;
+        p.kind = fractal_kind::julia;
+        p.c[0] = c[0];
+        p.c[1] = c[1];
+        escape_buffer buf(opt_.size, opt_.size);
+        render_escape_time(p, julia_default_view, buf, kernel_);
+        auto ret = std::make_shared<texels>();
+        escape_texels(buf, *ret);
+        return ret;
+    }
+
+    std::shared_ptr<const texels> render_exact(const exact_request& req) {
+        escape_buffer buf(req.width, req.height);
+        const auto view = julia_pane_view(req.width, req.height);
+        parallel_tiles(pool_, req.width, req.height, 64,
+                       [&](std::size_t x0, std::size_t y0, std::size_t x1, std::size_t y1) {
+                           render_escape_time_rect(req.param, view, buf, x0, y0, x1, y1, kernel_);
+                       });
+        auto ret = std::make_shared<texels>();
+        escape_texels(buf, *ret);
+        return ret;
+    }
+
+    void run() {
+        std::unique_lock lock(mtx_);
+        while (true) {
+            cv_.wait(lock, [this] {
+                return stop_ || exact_pending_ || (param_ && !planned_) || next_ < order_.size();
+            });
+            if (stop_) return;
+
+            if (exact_pending_) {
+                exact_running_ = exact_pending_;
+                exact_pending_.reset();
+                const auto req = *exact_running_;
+                lock.unlock();
+                auto result = render_exact(req);
+                lock.lock();
+                exact_running_.reset();
+                exact_key_ = req;
+                exact_ = std::move(result);
+            } else if (!planned_) {
+                const auto param = *param_;
+                const auto epoch = epoch_;
+                lock.unlock();
+                std::vector<std::size_t> leaf, order;
+                plan(param, leaf, order);
+                lock.lock();
+                if (epoch != epoch_) continue;
+                leaf_ = std::move(leaf);
+                order_ = std::move(order);
+                planned_ = true;
+                continue;
+            } else {
+                // one corner per thread at a time, so that an exact request waits for little
+                const auto param = *param_;
+                const auto epoch = epoch_;
+                const auto count = std::min(pool_.size(), order_.size() - next_);
+                const std::vector<std::size_t> batch(order_.begin() + next_, order_.begin() + next_ + count);
+                next_ += count;
+                lock.unlock();
+                std::vector<std::shared_ptr<const texels>> results(count);
+                pool_.parallel_for(count, [&](std::size_t i) { results[i] = render_entry(param, batch[i]); });
+                lock.lock();
+                if (epoch != epoch_) continue;
+                for (std::size_t i = 0; i < count; i++) entries_[batch[i]] = std::move(results[i]);
+                ready_ += count;
+            }
+
+            generation_++;
+            lock.unlock();
+            if (on_ready) on_ready();
+            lock.lock();
+        }
+    }
+
+public:
+    /**
+     * @brief called on the background thread after every finished render, e.g. glfwPostEmptyEvent
+     */
+    std::function<void()> on_ready;
+
+    julia_atlas(const julia_atlas_options& opt = {},
+                std::size_t threads = std::max(std::thread::hardware_concurrency(), 2u) - 1)
+        : opt_{opt}, n_{std::max<std::size_t>(opt.grid, 1) << opt.refine}, step_{std::size_t{1} << opt.refine},
+          kernel_{select_escape_kernel()}, pool_{std::max<std::size_t>(threads, 1)} {
+        thread_ = std::thread([this] { run(); });
+    }
+
+    julia_atlas(const julia_atlas&) = delete;
+    julia_atlas& operator=(const julia_atlas&) = delete;
+
+    ~julia_atlas() {
+        {
+            std::lock_guard lock(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    /**
+     * @brief number of renders finished so far; a change means preview() or exact() may have more to show
+     */
+    std::size_t generation() {
+        std::lock_guard lock(mtx_);
+        return generation_;
+    }
+
+    /**
+     * @brief entries rendered and entries planned, the latter 0 until the boundary cells are known
+     */
+    std::array<std::size_t, 2> progress() {
+        std::lock_guard lock(mtx_);
+        return {ready_, order_.size()};
+    }
+
+    /**
+     * @brief start over for the iteration cap and interior checks of param, unless the atlas is for them already
+     */
+    void build(const escape_params& param) {
+        std::lock_guard lock(mtx_);
+        if (param_ && param_->max_iter == param.max_iter && param_->interior_checks == param.interior_checks) return;
+        param_ = param;
+        epoch_++;
+        planned_ = false;
+        leaf_.clear();
+        order_.clear();
+        next_ = 0;
+        ready_ = 0;
+        entries_.assign((n_ + 1) * (n_ + 1), nullptr);
+        cv_.notify_one();
+    }
+
+    /**
+     * @brief fill out with a width x height julia pane for c out of the entries around it
+     * The entries are blended bilinearly in c, or the nearest one is taken where any of them did not escape
+     * or without blend. Pane pixels outside julia_default_view escape at once and are shown so.
+     * @return false, with out untouched, if c is outside the atlas or none of its entries are done yet
+     */
+    bool preview(const std::array<float, 2>& c, std::size_t width, std::size_t height, bool blend, texels& out) {
+        std::array<std::shared_ptr<const texels>, 4> corner;
+        float f[2];
+        {
+            std::lock_guard lock(mtx_);
+            if (!planned_) return false;
+            float u[2];
+            std::size_t cell[2];
+            for (std::size_t a = 0; a < 2; a++) {
+                u[a] = (c[a] - opt_.low[a]) / (opt_.high[a] - opt_.low[a]) * static_cast<float>(n_);
+                if (!(u[a] >= 0.0f && u[a] <= static_cast<float>(n_))) return false;
+                cell[a] = std::min(static_cast<std::size_t>(u[a]), n_ - 1);
+            }
+
+            // the cell itself, or the nearest ancestor whose corners are done
+            const auto nodes = n_ + 1;
+            bool found = false;
+            for (auto s = leaf_[cell[1] * n_ + cell[0]]; s <= step_ && !found; s *= 2) {
+                const auto x0 = cell[0] / s * s;
+                const auto y0 = cell[1] / s * s;
+                corner = {entries_[y0 * nodes + x0], entries_[y0 * nodes + x0 + s], entries_[(y0 + s) * nodes + x0],
+                          entries_[(y0 + s) * nodes + x0 + s]};
+                found = std::all_of(corner.begin(), corner.end(), [](const auto& e) { return e != nullptr; });
+                f[0] = (u[0] - static_cast<float>(x0)) / static_cast<float>(s);
+                f[1] = (u[1] - static_cast<float>(y0)) / static_cast<float>(s);
+            }
+            if (!found) return false;
+        }
+
+        const float w[4] = {(1.0f - f[0]) * (1.0f - f[1]), f[0] * (1.0f - f[1]), (1.0f - f[0]) * f[1], f[0] * f[1]};
+        const auto nearest = static_cast<std::size_t>(std::max_element(w, w + 4) - w);
+
+        // entry texel of every pane column and row, size for none
+        const auto size = opt_.size;
+        const auto view = julia_pane_view(width, height);
+        const auto m = std::min(width, height);
+        const auto texel = [&](std::size_t len, float center) {
+            const auto axis = escape_axis(len, m, view.scale, center);
+            std::vector<std::size_t> ret(len);
+            for (std::size_t i = 0; i < len; i++) {
+                const float t = (axis[i] + julia_default_view.scale) / (2.0f * julia_default_view.scale);
+                ret[i] = t >= 0.0f && t < 1.0f ? std::min(static_cast<std::size_t>(t * static_cast<float>(size)),
+                                                          size - 1)
+                                               : size;
+            }
+            return ret;
+        };
+        const auto xs = texel(width, view.center[0]);
+        const auto ys = texel(height, view.center[1]);
+
+        out.resize(width * height);
+        for (std::size_t row = 0; row < height; row++) {
+            for (std::size_t col = 0; col < width; col++) {
+                auto& o = out[row * width + col];
+                if (xs[col] == size || ys[row] == size) {
+                    o = {0.0f, 0.0f};
+                    continue;
+                }
+                const auto idx = ys[row] * size + xs[col];
+                const std::array<float, 2> v[4] = {(*corner[0])[idx], (*corner[1])[idx], (*corner[2])[idx],
+                                                   (*corner[3])[idx]};
+                if (!blend || v[0][1] < 0.0f || v[1][1] < 0.0f || v[2][1] < 0.0f || v[3][1] < 0.0f) {
+                    o = v[nearest];
+                    continue;
+                }
+                o = {0.0f, 0.0f};
+                for (std::size_t k = 0; k < 4; k++) {
+                    o[0] += w[k] * v[k][0];
+                    o[1] += w[k] * v[k][1];
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief fill out with the exact width x height julia pane of param.c if it is done, else ask for it
+     * A request replaces one still waiting, so only the newest c is rendered once the cursor moves on.
+     */
+    bool exact(const escape_params& param, std::size_t width, std::size_t height, texels& out) {
+        auto p = param;
+        p.kind = fractal_kind::julia;
+        const exact_request req = {p, width, height};
+
+        std::lock_guard lock(mtx_);
+        if (exact_ && exact_key_ == req) {
+            out = *exact_;
+            return true;
+        }
+        if (exact_running_ != req) {
+            exact_pending_ = req;
+            cv_.notify_one();
+        }
+        return false;
+    }
+};
+
+#endif  // PRACC_GL_JULIA_ATLAS_H
@@ -0,0 +1,315 @@
+/**
+ * @file mapped_image.h
+ * @brief RGB8 image file written tile by tile through a memory map, resumable, with bounded resident memory
+ */
+
+#ifndef PRACC_GL_MAPPED_IMAGE_H
+#define PRACC_GL_MAPPED_IMAGE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief ppm: binary P6, rows top-down; tiff: BigTIFF with uncompressed tiles, each one contiguous in the file
+ */
+enum class mapped_layout { ppm, tiff };
+
+inline mapped_layout mapped_layout_for(std::string_view path) {
+    return path.ends_with(".tif") || path.ends_with(".tiff") ? mapped_layout::tiff : mapped_layout::ppm;
+}
+
+/**
+ * @brief x0, y0, width, height of tile index of a width x height image
+ * Tiles are numbered row by row from the top left like TIFF tiles; y0 counts from the bottom like the pixels.
+ */
+inline std::array<std::size_t, 4> image_tile_rect(std::size_t width, std::size_t height, std::size_t tile,
+                                                  std::size_t index) {
+    const auto tiles_x = (width + tile - 1) / tile;
+    const auto x0 = index % tiles_x * tile;
+    const auto top = index / tiles_x * tile;
+    const auto h = std::min(tile, height - top);
+    return {x0, height - top - h, std::min(tile, width - x0), h};
+}
+
+/**
+ * @class mapped_image
+ * @brief the output file itself, mapped; renderers write every tile straight into its final place
+ * Resident memory stays at the tiles being written: a finished BigTIFF tile, or a finished row of PPM tiles,
+ * is dropped from the mapping and handed to the kernel for writeback. Finished tiles are recorded in
+ * PATH.done after the image has been synced, every commit_every tiles. If the process dies, the partial
+ * image and PATH.done stay behind. open() with the same identity then resumes with the tiles still
+ * missing, and PATH.done goes away once every tile is there.
+ */
+class mapped_image {
+private:
+    int fd_ = -1;
+    int done_fd_ = -1;
+    std::uint8_t* map_ = nullptr;
+    std::size_t bytes_ = 0;
+    std::size_t width_ = 0;
+    std::size_t height_ = 0;
+    std::size_t tile_ = 0;
+    mapped_layout layout_ = mapped_layout::ppm;
+    std::size_t data_ = 0;  // offset of the pixels
+    std::size_t identity_bytes_ = 0;
+    std::vector<std::uint8_t> done_;
+    std::size_t done_count_ = 0;
+    std::vector<std::size_t> band_done_;
+    std::vector<std::size_t> uncommitted_;
+    std::size_t commit_every_ = 64;
+    std::string path_;
+
+    std::size_t tiles_x() const { return (width_ + tile_ - 1) / tile_; }
+    std::size_t tiles_y() const { return (height_ + tile_ - 1) / tile_; }
+    std::size_t tile_bytes() const { return tile_ * tile_ * 3; }
+
+    static bool write_all(int fd, const void* data, std::size_t size, std::size_t offset) {
+        const auto* p = static_cast<const char*>(data);
+        for (std::size_t done = 0; done < size;) {
+            const auto n = ::pwrite(fd, p + done, size - done, static_cast<off_t>(offset + done));
+            if (n <= 0) return false;
+            done += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    /**
+     * @brief file header: the PPM one, or BigTIFF header, IFD and tile offset / byte count arrays
+     */
+    std::vector<std::uint8_t> header() const {
+        if (layout_ == mapped_layout::ppm) {
+            const auto h = "P6\n" + std::to_string(width_) + ' ' + std::to_string(height_) + "\n255\n";
+            return {h.begin(), h.end()};
+        }
+
+        std::vector<std::uint8_t> out;
+        const auto put = [&](std::uint64_t v, int bytes) {
+            for (int i = 0; i < bytes; i++) out.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+        };
+        const auto count = tiles_x() * tiles_y();
+        constexpr std::uint64_t short_type = 3;
+        constexpr std::uint64_t long_type = 4;
+        constexpr std::uint64_t long8_type = 16;
+        constexpr std::size_t entries = 11;
+        const std::size_t offsets_at = 16 + 8 + entries * 20 + 8;
+        const std::size_t counts_at = offsets_at + count * 8;
+
+        put('I' | 'I' << 8, 2);  // little endian
+        put(43, 2);
+        put(8, 2);
+        put(0, 2);
+        put(16, 8);
+        put(entries, 8);
+        const auto entry = [&](std::uint64_t tag, std::uint64_t type, std::uint64_t n, std::uint64_t value) {
+            put(tag, 2);
+            put(type, 2);
+            put(n, 8);
+            put(value, 8);
+        };
+        entry(256, long_type, 1, width_);
+        entry(257, long_type, 1, height_);
+        entry(258, short_type, 3, 8 | 8ull << 16 | 8ull << 32);
+        entry(259, short_type, 1, 1);  // no compression
+        entry(262, short_type, 1, 2);  // RGB
+        entry(277, short_type, 1, 3);
+        entry(284, short_type, 1, 1);  // chunky
+        entry(322, long_type, 1, tile_);
+        entry(323, long_type, 1, tile_);
+        // one LONG8 fits into the entry itself
+        entry(324, long8_type, count, count == 1 ? data_ : offsets_at);
+        entry(325, long8_type, count, count == 1 ? tile_bytes() : counts_at);
+        put(0, 8);
+        for (std::size_t i = 0; i < count; i++) put(data_ + i * tile_bytes(), 8);
+        for (std::size_t i = 0; i < count; i++) put(tile_bytes(), 8);
+        return out;
+    }
+
+    void drop(std::size_t offset, std::size_t size) {
+        const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const auto begin = offset / page * page;
+        const auto end = std::min((offset + size + page - 1) / page * page, bytes_);
+        // other tiles sharing the edge pages simply fault them back in
+        ::madvise(map_ + begin, end - begin, MADV_DONTNEED);
+        ::posix_fadvise(fd_, static_cast<off_t>(begin), static_cast<off_t>(end - begin), POSIX_FADV_DONTNEED);
+    }
+
+    bool resume(const std::vector<std::uint8_t>& head, std::string_view identity) {
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0 || static_cast<std::size_t>(st.st_size) != bytes_) return false;
+        std::vector<std::uint8_t> old(head.size());
+        if (::pread(fd_, old.data(), old.size(), 0) != static_cast<ssize_t>(old.size()) || old != head) return false;
+
+        std::string text(identity.size() + 1 + done_.size(), '\0');
+        if (::pread(done_fd_, text.data(), text.size(), 0) != static_cast<ssize_t>(text.size()) ||
+            text.compare(0, identity.size(), identity) != 0 || text[identity.size()] != '\n') {
+            return false;
+        }
+        for (std::size_t i = 0; i < done_.size(); i++) {
+            done_[i] = text[identity_bytes_ + i] ? 1 : 0;
+            done_count_ += done_[i];
+            if (done_[i]) band_done_[i / tiles_x()]++;
+        }
+        return true;
+    }
+
+public:
+    mapped_image() = default;
+    mapped_image(const mapped_image&) = delete;
+    mapped_image& operator=(const mapped_image&) = delete;
+    ~mapped_image() { close(); }
+
+    /**
+     * @brief create path, or resume it if PATH.done was left by a run with the same identity and size
+     * @param tile multiple of 16 for BigTIFF
+     * @param identity one line describing what is rendered, e.g. the view
+     */
+    bool open(const std::string& path, std::size_t width, std::size_t height, std::size_t tile, mapped_layout layout,
+              std::string_view identity) {
+        close();
+        if (!width || !height || !tile) {
+            std::cerr << "image and tile sizes must not be zero: " << width << " x " << height << ", tile " << tile
+                      << std::endl;
+            return false;
+        }
+        if (layout == mapped_layout::tiff && tile % 16) {
+            std::cerr << "BigTIFF tiles must be a multiple of 16 pixels" << std::endl;
+            return false;
+        }
+        path_ = path;
+        width_ = width;
+        height_ = height;
+        tile_ = tile;
+        layout_ = layout;
+        const auto count = tiles_x() * tiles_y();
+        done_.assign(count, 0);
+        band_done_.assign(tiles_y(), 0);
+        done_count_ = 0;
+        identity_bytes_ = identity.size() + 1;
+
+        const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        if (layout_ == mapped_layout::ppm) {
+            data_ = header().size();
+            bytes_ = data_ + width_ * height_ * 3;
+        } else {
+            // page aligned, so that the tiles of the usual sizes start on a page of their own
+            data_ = (16 + 8 + 11 * 20 + 8 + count * 16 + page - 1) / page * page;
+            bytes_ = data_ + count * tile_bytes();
+        }
+        const auto head = header();
+
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        done_fd_ = ::open((path + ".done").c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0 || done_fd_ < 0) {
+            std::cerr << "failed to open " << path << std::endl;
+            close();
+            return false;
+        }
+
+        if (resume(head, identity)) {
+            uncommitted_.clear();
+        } else {
+            std::fill(done_.begin(), done_.end(), 0);
+            std::fill(band_done_.begin(), band_done_.end(), 0);
+            done_count_ = 0;
+            const auto text = std::string(identity) + '\n' + std::string(count, '\0');
+            // truncating first leaves a sparse file, pixels only take disk space once written
+            if (::ftruncate(fd_, 0) != 0 || ::ftruncate(fd_, static_cast<off_t>(bytes_)) != 0 ||
+                !write_all(fd_, head.data(), head.size(), 0) || ::ftruncate(done_fd_, 0) != 0 ||
+                !write_all(done_fd_, text.data(), text.size(), 0)) {
+                std::cerr << "failed to create " << path << std::endl;
+                close();
+                return false;
+            }
+        }
+
+        void* map = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (map == MAP_FAILED) {
+            std::cerr << "failed to map " << path << std::endl;
+            close();
+            return false;
+        }
+        map_ = static_cast<std::uint8_t*>(map);
+        return true;
+    }
+
+    /**
+     * @brief write finished tiles to PATH.done, sync the image and unmap it; PATH.done goes once it is complete
+     * @return false if anything could not be written
+     */
+    bool close() {
+        bool ok = commit();
+        if (map_) ::munmap(map_, bytes_);
+        if (fd_ >= 0 && done_count_ == done_.size() && !done_.empty()) {
+            ok = ::fdatasync(fd_) == 0 && ok;
+            if (ok) ::unlink((path_ + ".done").c_str());
+        }
+        if (fd_ >= 0) ::close(fd_);
+        if (done_fd_ >= 0) ::close(done_fd_);
+        map_ = nullptr;
+        fd_ = done_fd_ = -1;
+        done_.clear();
+        return ok;
+    }
+
+    bool is_open() const { return map_ != nullptr; }
+    std::size_t tile_count() const { return done_.size(); }
+    std::size_t done() const { return done_count_; }
+    bool done(std::size_t index) const { return done_[index] != 0; }
+    std::array<std::size_t, 4> tile_rect(std::size_t index) const {
+        return image_tile_rect(width_, height_, tile_, index);
+    }
+
+    /**
+     * @brief where the 3 * width bytes of row row (from the bottom) of tile index go
+     */
+    std::uint8_t* row(std::size_t index, std::size_t row) {
+        const auto [x0, y0, w, h] = tile_rect(index);
+        if (layout_ == mapped_layout::ppm) return map_ + data_ + ((height_ - 1 - y0 - row) * width_ + x0) * 3;
+        return map_ + data_ + index * tile_bytes() + (h - 1 - row) * tile_ * 3;
+    }
+
+    /**
+     * @brief tile index is complete: drop its pages, and mark it done with the next commit
+     */
+    void finish(std::size_t index) {
+        if (layout_ == mapped_layout::tiff) {
+            drop(data_ + index * tile_bytes(), tile_bytes());
+        } else if (++band_done_[index / tiles_x()] == tiles_x()) {
+            const auto [x0, y0, w, h] = tile_rect(index);
+            drop(data_ + (height_ - y0 - h) * width_ * 3, h * width_ * 3);
+        }
+        uncommitted_.push_back(index);
+        if (uncommitted_.size() >= commit_every_) commit();
+    }
+
+    /**
+     * @brief sync the image, then record the tiles finished since the last commit in PATH.done
+     */
+    bool commit() {
+        if (uncommitted_.empty() || fd_ < 0) return true;
+        if (::fdatasync(fd_) != 0) return false;
+        bool ok = true;
+        constexpr std::uint8_t one = 1;
+        for (const auto i : uncommitted_) {
+            ok = write_all(done_fd_, &one, 1, identity_bytes_ + i) && ok;
+            if (!done_[i]) done_count_++;
+            done_[i] = 1;
+        }
+        uncommitted_.clear();
+        return ok;
+    }
+};
+
+#endif  // PRACC_GL_MAPPED_IMAGE_H
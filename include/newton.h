@@ -0,0 +1,574 @@
+/**
+ * @file newton.h
+ * @brief CPU newton fractal renderer mirroring newton_fractal.frag, built on dual_num<std::complex<T>>
+ */
+
+#ifndef PRACC_GL_NEWTON_H
+#define PRACC_GL_NEWTON_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "include/double_double.h"
+#include "include/dual_number.h"
+#include "include/escape_time.h"
+#include "include/simd_batch.h"
+#include "include/thread_pool.h"
+
+/**
+ * @brief pan is in whole pixels and added to the pixel position like escape_view::pan
+ * The iteration evaluates coefficients a_0 + a_1 z + ... + a_n z^n; left empty they are expanded from roots.
+ * roots are what pixels are colored by, so a coefficient-form polynomial needs them too, see
+ * newton_params_from_coefficients().
+ * A pixel stops once a newton step is shorter than tolerance; 0 always runs max_iter steps. It has to stay well
+ * below the distance between roots, or a pixel may stop next to the wrong one.
+ */
+template <typename T>
+struct newton_params {
+    std::vector<std::complex<T>> roots;
+    T scale = 1;
+    std::uint32_t max_iter = 100;
+    std::array<T, 2> pan = {};
+    std::vector<std::complex<T>> coefficients = {};
+    T tolerance = T(1e-6);
+};
+
+/**
+ * @brief roots and colors the newton_fractal executable starts with
+ */
+template <typename T>
+newton_params<T> newton_default_params() {
+    return {{{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}}, 1, 100};
+}
+
+/**
+ * @brief the same params in another scalar type, e.g. double_double<double> for a zoom past double
+ */
+template <typename U, typename T>
+newton_params<U> newton_params_cast(const newton_params<T>& param) {
+    newton_params<U> ret;
+    for (const auto& r : param.roots) ret.roots.emplace_back(U{r.real()}, U{r.imag()});
+    ret.scale = U{param.scale};
+    ret.max_iter = param.max_iter;
+    ret.pan = {U{param.pan[0]}, U{param.pan[1]}};
+    for (const auto& a : param.coefficients) ret.coefficients.emplace_back(U{a.real()}, U{a.imag()});
+    ret.tolerance = U{param.tolerance};
+    return ret;
+}
+
+inline std::vector<std::array<float, 3>> newton_default_colors() {
+    constexpr float hi = 255 / 255.0f;
+    constexpr float lo = 173 / 255.0f;
+    return {{hi, lo, lo}, {hi, lo, hi}, {lo, lo, hi}, {lo, hi, hi}, {lo, hi, lo}};
+}
+
+/**
+ * @brief f(z) = prod (z - root_i) with its derivative in the dual part
+ * Z is std::complex<T> or complex_batch<T, N>; the batch evaluates N pixels with the same operator templates.
+ * Product form, 22 flops per root; the renderers use newton_horner() and keep this as its reference.
+ */
+template <typename Z, typename T>
+constexpr dual_num<Z> newton_polynomial(const Z& z, const std::vector<std::complex<T>>& roots) {
+    const dual_num<Z> x{z, Z{1}};
+    dual_num<Z> ret{Z{1}};
+    for (const auto& r : roots) ret *= x - r;
+    return ret;
+}
+
+template <typename Z, typename T>
+constexpr Z newton_iterate(Z z, const std::vector<std::complex<T>>& roots, std::uint32_t n) {
+    for (std::uint32_t i = 0; i < n; i++) {
+        const auto f = newton_polynomial(z, roots);
+        z -= f.real() / f.imag();
+    }
+    return z;
+}
+
+/**
+ * @brief coefficients a_0 .. a_n of prod (z - root_i); a_n = 1
+ */
+template <typename T>
+std::vector<std::complex<T>> newton_coefficients(const std::vector<std::complex<T>>& roots) {
+    std::vector<std::complex<T>> a = {std::complex<T>{T{1}}};
+    for (const auto& r : roots) {
+        // multiply by (z - r): every coefficient moves up one degree, minus r times itself
+        a.insert(a.begin(), std::complex<T>{});
+        for (std::size_t k = 0; k + 1 < a.size(); k++) a[k] -= r * a[k + 1];
+    }
+    return a;
+}
+
+/**
+ * @brief roots of a_0 + a_1 z + ... + a_n z^n by Durand-Kerner iteration
+ */
+template <typename T>
+std::vector<std::complex<T>> newton_roots(const std::vector<std::complex<T>>& coefficients,
+                                          std::uint32_t max_iter = 500) {
+    auto a = coefficients;
+    while (a.size() > 1 && a.back() == std::complex<T>{}) a.pop_back();
+    const auto n = a.size() - 1;
+    if (n == 0) return {};
+    for (auto& c : a) c /= coefficients[n];
+
+    // start on a circle that is neither real nor symmetric, so no two guesses chase the same root
+    std::vector<std::complex<T>> z(n);
+    for (std::size_t i = 0; i < n; i++) z[i] = std::pow(std::complex<T>{T(0.4), T(0.9)}, static_cast<int>(i));
+
+    for (std::uint32_t it = 0; it < max_iter; it++) {
+        T moved{};
+        for (std::size_t i = 0; i < n; i++) {
+            std::complex<T> f = a[n];
+            for (auto k = n; k-- > 0;) f = f * z[i] + a[k];
+            std::complex<T> d{T{1}};
+            for (std::size_t j = 0; j < n; j++) {
+                if (j != i) d *= z[i] - z[j];
+            }
+            const auto step = f / d;
+            z[i] -= step;
+            moved = std::max(moved, std::abs(step));
+        }
+        if (moved <= std::numeric_limits<T>::epsilon() * 4) break;
+    }
+    return z;
+}
+
+/**
+ * @brief params for a coefficient-form polynomial; its roots are solved for once to color the basins
+ */
+template <typename T>
+newton_params<T> newton_params_from_coefficients(const std::vector<std::complex<T>>& coefficients, T scale = 1,
+                                                 std::uint32_t max_iter = 100) {
+    return {newton_roots(coefficients), scale, max_iter, {}, coefficients};
+}
+
+/**
+ * @brief the coefficients the iteration evaluates: param.coefficients, or the expanded roots
+ */
+template <typename T>
+std::vector<std::complex<T>> newton_polynomial_coefficients(const newton_params<T>& param) {
+    return param.coefficients.empty() ? newton_coefficients(param.roots) : param.coefficients;
+}
+
+template <typename T>
+std::size_t newton_degree(const newton_params<T>& param) {
+    return param.coefficients.empty() ? param.roots.size() : param.coefficients.size() - 1;
+}
+
+/**
+ * @brief one Horner step of f and f' together: (p, p') -> (p z + a, p' z + p)
+ * It is dual_num multiplication by (z + e) with the e^2 term dropped and the known 1 not multiplied:
+ * 16 flops per degree against the 22 of a product-form factor.
+ */
+template <typename Z>
+constexpr dual_num<Z> horner_step(const dual_num<Z>& f, const Z& z, const Z& a) {
+    return {f.real() * z + a, f.imag() * z + f.real()};
+}
+
+/**
+ * @brief f(z) with f'(z) in the dual part; a[Degree] is the leading coefficient
+ * The fold unrolls the whole evaluation for a fixed degree.
+ */
+template <std::size_t Degree, typename Z>
+constexpr dual_num<Z> newton_horner(const Z& z, const std::array<Z, Degree + 1>& a) {
+    if constexpr (Degree == 0) {
+        return {a[0], Z{}};
+    } else {
+        dual_num<Z> ret{a[Degree] * z + a[Degree - 1], a[Degree]};
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((ret = horner_step(ret, z, a[Degree - 2 - I])), ...);
+        }(std::make_index_sequence<Degree - 1>{});
+        return ret;
+    }
+}
+
+/**
+ * @brief newton_horner for a degree only known at run time
+ */
+template <typename Z>
+constexpr dual_num<Z> newton_horner(const Z& z, const std::vector<Z>& a) {
+    const auto n = a.size() - 1;
+    if (n == 0) return {a[0], Z{}};
+    dual_num<Z> ret{a[n] * z + a[n - 1], a[n]};
+    for (auto k = n - 1; k-- > 0;) ret = horner_step(ret, z, a[k]);
+    return ret;
+}
+
+/**
+ * @brief highest degree with its own unrolled kernels; anything above runs the run-time degree loop
+ */
+constexpr std::size_t newton_unrolled_degree = 12;
+
+/**
+ * @brief coefficients as Z: a std::array for a fixed Degree, a std::vector for Degree == 0 (run time)
+ */
+template <typename Z, std::size_t Degree, typename T>
+auto newton_coefficients_as(const std::vector<std::complex<T>>& a) {
+    if constexpr (Degree == 0) {
+        return std::vector<Z>(a.begin(), a.end());
+    } else {
+        std::array<Z, Degree + 1> ret;
+        for (std::size_t k = 0; k <= Degree; k++) ret[k] = Z{a[k]};
+        return ret;
+    }
+}
+
+/**
+ * @brief newton_horner on the coefficients newton_coefficients_as() made
+ */
+template <typename Z, typename A>
+constexpr dual_num<Z> newton_evaluate(const Z& z, const A& a) {
+    if constexpr (std::is_same_v<A, std::vector<Z>>) {
+        return newton_horner(z, a);
+    } else {
+        return newton_horner<std::tuple_size_v<A> - 1>(z, a);
+    }
+}
+
+template <typename Z, typename A>
+constexpr Z newton_iterate_horner(Z z, const A& a, std::uint32_t n) {
+    for (std::uint32_t i = 0; i < n; i++) {
+        const auto f = newton_evaluate(z, a);
+        z -= f.real() / f.imag();
+    }
+    return z;
+}
+
+/**
+ * @brief |z|^2 without the square root std::norm may take for double_double / quad_double
+ */
+template <typename Z>
+constexpr auto newton_norm(const Z& z) {
+    return z.real() * z.real() + z.imag() * z.imag();
+}
+
+/**
+ * @brief fractional step count of a pixel whose last step had squared length last2 below tol2
+ * Near a simple root every step squares the distance, so log(last2) / log(tol2) runs from 1 (just crossed) to
+ * 2 (crossed with a full step to spare); its log2 is how much of the last step was left over. Subtracting it
+ * from steps makes the result continuous across the bands that whole step counts leave.
+ */
+inline float newton_smooth_count(std::uint32_t steps, double last2, double tol2) {
+    if (!(last2 > 0.0)) return static_cast<float>(steps) - 1.0f;
+    const double over = std::log2(std::log(last2) / std::log(tol2));
+    return static_cast<float>(static_cast<double>(steps) - std::clamp(over, 0.0, 1.0));
+}
+
+/**
+ * @brief newton_iterate_horner that stops once a step is shorter than tolerance
+ * @return the steps taken, max_iter if z never converged
+ */
+template <typename T, typename A>
+std::uint32_t newton_converge(std::complex<T>& z, const A& a, std::uint32_t n, const T& tolerance,
+                              float* smooth = nullptr) {
+    const T tol2 = tolerance * tolerance;
+    for (std::uint32_t i = 0; i < n; i++) {
+        const auto f = newton_evaluate(z, a);
+        const auto step = f.real() / f.imag();
+        z -= step;
+        const T d2 = newton_norm(step);
+        if (d2 < tol2) {
+            if (smooth) *smooth = newton_smooth_count(i + 1, leading(d2), leading(tol2));
+            return i + 1;
+        }
+    }
+    if (smooth) *smooth = static_cast<float>(n);
+    return n;
+}
+
+/**
+ * @brief index of the root nearest to z; ties and NaN keep the earlier root like the shader
+ */
+template <typename T>
+std::uint32_t nearest_root(const std::complex<T>& z, const std::vector<std::complex<T>>& roots) {
+    std::uint32_t idx = 0;
+    T d = std::abs(z - roots[0]);
+    for (std::uint32_t i = 1; i < roots.size(); i++) {
+        const T di = std::abs(z - roots[i]);
+        if (d > di) {
+            idx = i;
+            d = di;
+        }
+    }
+    return idx;
+}
+
+/**
+ * @brief root index reached by every pixel, row 0 at the bottom like gl_FragCoord
+ * iter holds the newton steps each pixel took and smooth the fractional count newton_smooth_count() makes of it,
+ * both max_iter where a pixel did not converge.
+ */
+struct newton_buffer {
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::vector<std::uint32_t> root;
+    std::vector<std::uint32_t> iter;
+    std::vector<float> smooth;
+
+    newton_buffer() = default;
+    newton_buffer(std::size_t w, std::size_t h) { resize(w, h); }
+
+    void resize(std::size_t w, std::size_t h) {
+        width = w;
+        height = h;
+        root.assign(w * h, 0);
+        iter.assign(w * h, 0);
+        smooth.assign(w * h, 0.0f);
+    }
+};
+
+template <typename T>
+constexpr std::complex<T> newton_pixel_to_plane(std::size_t col, std::size_t row, std::size_t width,
+                                                std::size_t height, T scale, const std::array<T, 2>& pan = {}) {
+    const T m = static_cast<T>(std::min(width, height));
+    const T x = ((static_cast<T>(col) + pan[0] + T(0.5)) * 2 - static_cast<T>(width)) / m;
+    const T y = ((static_cast<T>(row) + pan[1] + T(0.5)) * 2 - static_cast<T>(height)) / m;
+    return {x * scale, y * scale};
+}
+
+/**
+ * @brief render [x0, x1) x [y0, y1) of out; Degree is the polynomial's degree, or 0 to take it at run time
+ */
+template <typename T, std::size_t Degree = 0>
+void render_newton_tile(const newton_params<T>& param, newton_buffer& out, std::size_t x0, std::size_t y0,
+                        std::size_t x1, std::size_t y1) {
+    const auto a = newton_coefficients_as<std::complex<T>, Degree>(newton_polynomial_coefficients(param));
+    for (auto row = y0; row < y1; row++) {
+        for (auto col = x0; col < x1; col++) {
+            const auto idx = row * out.width + col;
+            auto z = newton_pixel_to_plane(col, row, out.width, out.height, param.scale, param.pan);
+            out.iter[idx] = newton_converge(z, a, param.max_iter, param.tolerance, &out.smooth[idx]);
+            out.root[idx] = nearest_root(z, param.roots);
+        }
+    }
+}
+
+/**
+ * @brief render_newton_tile with N horizontally adjacent pixels per dual_num<complex_batch<T, N>>
+ * The last batch of a row repeats its final pixel to fill the unused lanes. Converged lanes are frozen with
+ * where() and the batch stops once all of them have, so one slow pixel costs its batch, not its row.
+ * Division is the shader's c_div instead of std::complex's scaled one, so a few basin boundary pixels
+ * may land on a different root than render_newton_tile.
+ */
+template <typename T, std::size_t N, std::size_t Degree = 0>
+[[gnu::always_inline]] inline void render_newton_tile_batch(const newton_params<T>& param, newton_buffer& out,
+                                                            std::size_t x0, std::size_t y0, std::size_t x1,
+                                                            std::size_t y1) {
+    const auto a = newton_coefficients_as<complex_batch<T, N>, Degree>(newton_polynomial_coefficients(param));
+    const auto n = param.max_iter;
+    const T tol2 = param.tolerance * param.tolerance;
+    const simd<T, N> tol2s{tol2};
+
+    for (auto row = y0; row < y1; row++) {
+        for (auto col = x0; col < x1; col += N) {
+            complex_batch<T, N> z;
+            for (std::size_t i = 0; i < N; i++) {
+                z.set(i, newton_pixel_to_plane(std::min(col + i, x1 - 1), row, out.width, out.height, param.scale,
+                                               param.pan));
+            }
+
+            std::array<std::uint32_t, N> iter;
+            std::array<float, N> smooth;
+            iter.fill(n);
+            smooth.fill(static_cast<float>(n));
+            auto active = simd_mask<T, N>::all_true();
+            for (std::uint32_t i = 0; i < n && any(active); i++) {
+                const auto f = newton_evaluate(z, a);
+                const auto step = f.real() / f.imag();
+                z = where(active, z - step, z);
+
+                const auto d2 = newton_norm(step);
+                const auto converged = active & (d2 < tol2s);
+                if (any(converged)) {
+                    for (std::size_t k = 0; k < N; k++) {
+                        if (!converged[k]) continue;
+                        iter[k] = i + 1;
+                        smooth[k] = newton_smooth_count(i + 1, d2[k], tol2);
+                    }
+                    active = active & !converged;
+                }
+            }
+
+            for (std::size_t i = 0; i < N && col + i < x1; i++) {
+                const auto idx = row * out.width + col + i;
+                out.root[idx] = nearest_root(z[i], param.roots);
+                out.iter[idx] = iter[i];
+                out.smooth[idx] = smooth[i];
+            }
+        }
+    }
+}
+
+template <typename T>
+using newton_tile_kernel = void (*)(const newton_params<T>&, newton_buffer&, std::size_t, std::size_t, std::size_t,
+                                    std::size_t);
+
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+
+// Two registers of lanes per batch so that the dependent multiplies of one hide behind the other.
+// flatten pulls every dual_num / complex_batch operator into the target region, where they become packed FMA.
+template <typename T, std::size_t Degree = 0>
+__attribute__((target("avx2,fma"), flatten)) void render_newton_tile_avx2(const newton_params<T>& param,
+                                                                         newton_buffer& out, std::size_t x0,
+                                                                         std::size_t y0, std::size_t x1,
+                                                                         std::size_t y1) {
+    render_newton_tile_batch<T, 2 * 32 / sizeof(T), Degree>(param, out, x0, y0, x1, y1);
+}
+
+template <typename T, std::size_t Degree = 0>
+__attribute__((target("avx512f,fma"), flatten)) void render_newton_tile_avx512(const newton_params<T>& param,
+                                                                              newton_buffer& out, std::size_t x0,
+                                                                              std::size_t y0, std::size_t x1,
+                                                                              std::size_t y1) {
+    render_newton_tile_batch<T, 2 * 64 / sizeof(T), Degree>(param, out, x0, y0, x1, y1);
+}
+
+// double_double / quad_double have no complex_batch form; the FMA target still makes their two_prod one instruction
+template <typename T, std::size_t Degree = 0>
+__attribute__((target("avx2,fma"), flatten)) void render_newton_tile_fma(const newton_params<T>& param,
+                                                                        newton_buffer& out, std::size_t x0,
+                                                                        std::size_t y0, std::size_t x1,
+                                                                        std::size_t y1) {
+    render_newton_tile<T, Degree>(param, out, x0, y0, x1, y1);
+}
+
+#endif  // PRACC_GL_ESCAPE_TIME_X86
+
+template <typename T, std::size_t Degree>
+newton_tile_kernel<T> select_newton_kernel_for(escape_isa isa) {
+#ifdef PRACC_GL_ESCAPE_TIME_X86
+    if constexpr (std::is_floating_point_v<T>) {
+        if (isa == escape_isa::avx512) return render_newton_tile_avx512<T, Degree>;
+        if (isa == escape_isa::avx2) return render_newton_tile_avx2<T, Degree>;
+    } else {
+        if (isa != escape_isa::scalar) return render_newton_tile_fma<T, Degree>;
+    }
+#endif
+    return render_newton_tile<T, Degree>;
+}
+
+/**
+ * @brief tile kernel for a polynomial of degree and isa; scalar is the std::complex reference the golden image
+ * is taken from. Degrees up to newton_unrolled_degree get a fully unrolled Horner evaluation, except for
+ * double_double / quad_double, whose arithmetic outweighs any loop overhead.
+ */
+template <typename T>
+newton_tile_kernel<T> select_newton_kernel(std::size_t degree, escape_isa isa = detect_escape_isa()) {
+    isa = std::min(isa, detect_escape_isa());
+    if constexpr (!std::is_floating_point_v<T>) {
+        return select_newton_kernel_for<T, 0>(isa);
+    } else {
+        return [&]<std::size_t... D>(std::index_sequence<D...>) {
+            auto ret = select_newton_kernel_for<T, 0>(isa);
+            ((degree == D + 1 ? void(ret = select_newton_kernel_for<T, D + 1>(isa)) : void()), ...);
+            return ret;
+        }(std::make_index_sequence<newton_unrolled_degree>{});
+    }
+}
+
+/**
+ * @brief render out on pool
+ * Cost per pixel varies a lot near basin boundaries, so the image is cut into small tiles and
+ * left to the pool's work stealing rather than split into one row band per thread.
+ */
+template <typename T>
+void render_newton(const newton_params<T>& param, newton_buffer& out, work_stealing_pool& pool,
+                   std::size_t tile = 32, escape_isa isa = detect_escape_isa()) {
+    const auto kernel = select_newton_kernel<T>(newton_degree(param), isa);
+    parallel_tiles(pool, out.width, out.height, tile, [&](std::size_t x0, std::size_t y0, std::size_t x1,
+                                                           std::size_t y1) {
+        kernel(param, out, x0, y0, x1, y1);
+    });
+}
+
+/**
+ * @brief precision a newton view of width x height needs, at least double
+ * Pixels span |pan| + size pixels around the origin and converge onto the roots, so both have to be resolved
+ * down to one pixel.
+ */
+inline precision_level newton_precision(const newton_params<double>& param, std::size_t width, std::size_t height) {
+    const auto m = static_cast<double>(std::max<std::size_t>(std::min(width, height), 1));
+    const double spacing = 2.0 * param.scale / m;
+    const double pan = std::max(std::abs(param.pan[0]), std::abs(param.pan[1]));
+    double magnitude = (pan + static_cast<double>(std::max(width, height))) * spacing;
+    for (const auto& r : param.roots) magnitude = std::max(magnitude, std::abs(r));
+    return std::max(required_precision(magnitude, spacing), precision_level::float64);
+}
+
+/**
+ * @brief render_newton in double, or in double_double / quad_double once double cannot tell pixels apart
+ * @return the precision used
+ */
+inline precision_level render_newton_auto(const newton_params<double>& param, newton_buffer& out,
+                                          work_stealing_pool& pool, std::size_t tile = 32,
+                                          escape_isa isa = detect_escape_isa()) {
+    const auto precision = newton_precision(param, out.width, out.height);
+    if (precision == precision_level::float64) {
+        render_newton(param, out, pool, tile, isa);
+    } else if (precision == precision_level::double_double) {
+        render_newton(newton_params_cast<double_double<double>>(param), out, pool, tile, isa);
+    } else {
+        render_newton(newton_params_cast<quad_double>(param), out, pool, tile, isa);
+    }
+    return precision;
+}
+
+/**
+ * @brief average, 99th percentile and largest of per-pixel iteration counts
+ */
+struct iteration_stats {
+    double mean = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+template <typename T>
+iteration_stats make_iteration_stats(std::vector<T> counts) {
+    if (counts.empty()) return {};
+    iteration_stats ret;
+    for (const auto& c : counts) ret.mean += static_cast<double>(c);
+    ret.mean /= static_cast<double>(counts.size());
+    const auto p99 = counts.begin() + static_cast<std::ptrdiff_t>((counts.size() - 1) * 99 / 100);
+    std::nth_element(counts.begin(), p99, counts.end());
+    ret.p99 = static_cast<double>(*p99);
+    ret.max = static_cast<double>(*std::max_element(p99, counts.end()));
+    return ret;
+}
+
+/**
+ * @brief brightness palette.frag's shaded mode gives a smooth count: 1 for an immediate hit, darker the slower
+ */
+inline float newton_shade(float smooth, std::uint32_t max_iter) {
+    const float t = std::log2(1.0f + std::max(smooth, 0.0f)) / std::log2(1.0f + static_cast<float>(max_iter));
+    return std::clamp(1.0f - t, 0.15f, 1.0f);
+}
+
+inline std::vector<std::array<float, 3>> colorize_newton(const newton_buffer& buf,
+                                                         const std::vector<std::array<float, 3>>& colors) {
+    std::vector<std::array<float, 3>> rgb(buf.width * buf.height);
+    for (std::size_t i = 0; i < rgb.size(); i++) rgb[i] = colors[buf.root[i] % colors.size()];
+    return rgb;
+}
+
+/**
+ * @brief colorize_newton darkened by how many steps each pixel took to converge
+ */
+inline std::vector<std::array<float, 3>> colorize_newton(const newton_buffer& buf,
+                                                         const std::vector<std::array<float, 3>>& colors,
+                                                         std::uint32_t max_iter) {
+    auto rgb = colorize_newton(buf, colors);
+    for (std::size_t i = 0; i < rgb.size(); i++) {
+        const float s = newton_shade(buf.smooth[i], max_iter);
+        for (auto& c : rgb[i]) c *= s;
+    }
+    return rgb;
+}
+
+#endif  // PRACC_GL_NEWTON_H
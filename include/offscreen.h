@@ -0,0 +1,333 @@
+/**
+ * @file offscreen.h
+ * @brief headless rendering: surfaceless EGL context, FBO target, pipelined PBO readback, I/O thread
+ */
+
+#ifndef PRACC_GL_OFFSCREEN_H
+#define PRACC_GL_OFFSCREEN_H
+
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "include/adaptive_aa.h"
+#include "include/frame_encoder.h"
+#include "include/frame_profiler.h"
+
+struct headless_options {
+    bool enabled = false;
+    int width = 1920;
+    int height = 1080;
+    std::size_t frames = 0;  // 0: the length of path, or 1 frame without one
+    std::string out = "frame_";
+    frame_format format = frame_format::ppm;
+    std::size_t encoders = 2;
+    int fps = 60;
+    std::string path;   // animation keyframes, see animation_path.h
+    std::string trace;  // Chrome trace of the draw and readback of every frame
+    std::uint32_t aa = 0;  // most samples of an edge pixel in the adaptive antialiasing pass, 0 for none
+};
+
+/**
+ * @brief --headless W H [--frames N] [--out PREFIX|FILE] [--format ppm|png|y4m|raw] [--encoders N] [--fps N]
+ * [--path KEYFRAMES] [--trace FILE] [--aa N]; anything else leaves the windowed path alone
+ */
+inline headless_options parse_headless_options(int argc, char** argv) {
+    headless_options opt;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (arg == "--headless" && i + 2 < argc) {
+            opt.enabled = true;
+            opt.width = std::stoi(argv[++i]);
+            opt.height = std::stoi(argv[++i]);
+        } else if (arg == "--frames" && i + 1 < argc) {
+            opt.frames = std::stoul(argv[++i]);
+        } else if (arg == "--out" && i + 1 < argc) {
+            opt.out = argv[++i];
+        } else if (arg == "--format" && i + 1 < argc) {
+            opt.format = frame_format_from_string(argv[++i]);
+        } else if (arg == "--encoders" && i + 1 < argc) {
+            opt.encoders = std::stoul(argv[++i]);
+        } else if (arg == "--fps" && i + 1 < argc) {
+            opt.fps = std::stoi(argv[++i]);
+        } else if (arg == "--path" && i + 1 < argc) {
+            opt.path = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            opt.trace = argv[++i];
+        } else if (arg == "--aa" && i + 1 < argc) {
+            const auto n = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            opt.aa = n ? std::clamp(n, aa_min_samples, aa_max_samples) : 0;
+        }
+    }
+    return opt;
+}
+
+/**
+ * @class egl_headless_context
+ * @brief OpenGL 4.6 (or 4.5) core context without any window system (EGL_MESA_platform_surfaceless, e.g. llvmpipe)
+ */
+class egl_headless_context {
+private:
+    EGLDisplay dpy_ = EGL_NO_DISPLAY;
+    EGLContext ctx_ = EGL_NO_CONTEXT;
+
+    egl_headless_context(EGLDisplay dpy, EGLContext ctx) : dpy_{dpy}, ctx_{ctx} {}
+
+public:
+    egl_headless_context(const egl_headless_context&) = delete;
+    egl_headless_context& operator=(const egl_headless_context&) = delete;
+
+    egl_headless_context(egl_headless_context&& x) noexcept
+        : dpy_{std::exchange(x.dpy_, EGL_NO_DISPLAY)}, ctx_{std::exchange(x.ctx_, EGL_NO_CONTEXT)} {}
+
+    ~egl_headless_context() {
+        if (dpy_ == EGL_NO_DISPLAY) return;
+        eglMakeCurrent(dpy_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (ctx_ != EGL_NO_CONTEXT) eglDestroyContext(dpy_, ctx_);
+        eglTerminate(dpy_);
+    }
+
+    /**
+     * @brief create the context and make it current on the calling thread
+     */
+    static std::optional<egl_headless_context> create() {
+        EGLDisplay dpy = EGL_NO_DISPLAY;
+        const auto get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display) dpy = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (dpy == EGL_NO_DISPLAY) dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, nullptr, nullptr)) {
+            std::cerr << "eglInitialize failed: " << std::hex << eglGetError() << std::dec << std::endl;
+            return std::nullopt;
+        }
+
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            std::cerr << "eglBindAPI failed" << std::endl;
+            eglTerminate(dpy);
+            return std::nullopt;
+        }
+
+        // clang-format off
+        const EGLint config_attribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLint context_attribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 4,
+            EGL_CONTEXT_MINOR_VERSION, 6,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        // clang-format on
+
+        EGLConfig config = nullptr;
+        EGLint num_config = 0;
+        eglChooseConfig(dpy, config_attribs, &config, 1, &num_config);
+
+        // surfaceless displays may expose no config at all, EGL_KHR_no_config_context covers that.
+        // llvmpipe stops at 4.5, which is all the shaders need.
+        auto ctx = eglCreateContext(dpy, num_config ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+        if (ctx == EGL_NO_CONTEXT) {
+            context_attribs[3] = 5;
+            ctx = eglCreateContext(dpy, num_config ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+        }
+        if (ctx == EGL_NO_CONTEXT || !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+            std::cerr << "eglCreateContext failed: " << std::hex << eglGetError() << std::dec << std::endl;
+            if (ctx != EGL_NO_CONTEXT) eglDestroyContext(dpy, ctx);
+            eglTerminate(dpy);
+            return std::nullopt;
+        }
+
+        return egl_headless_context{dpy, ctx};
+    }
+};
+
+/**
+ * @brief load GL entry points for a context GLFW did not create
+ * glewInit() would also try GLX and fail without an X display, the core part is all that is needed.
+ */
+inline bool init_glew_headless() {
+    glewExperimental = GL_TRUE;
+    return glewContextInit() == GLEW_OK;
+}
+
+/**
+ * @class offscreen_target
+ * @brief framebuffer object of arbitrary size with one color texture, RGBA8 unless told otherwise
+ */
+class offscreen_target {
+private:
+    GLuint fbo_ = 0;
+    GLuint tex_ = 0;
+    int width_;
+    int height_;
+
+public:
+    offscreen_target(int width, int height, GLenum format = GL_RGBA8) : width_{width}, height_{height} {
+        glCreateTextures(GL_TEXTURE_2D, 1, &tex_);
+        glTextureStorage2D(tex_, 1, format, width, height);
+        glCreateFramebuffers(1, &fbo_);
+        glNamedFramebufferTexture(fbo_, GL_COLOR_ATTACHMENT0, tex_, 0);
+        glNamedFramebufferDrawBuffer(fbo_, GL_COLOR_ATTACHMENT0);
+        glNamedFramebufferReadBuffer(fbo_, GL_COLOR_ATTACHMENT0);
+
+        if (glCheckNamedFramebufferStatus(fbo_, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "offscreen framebuffer incomplete" << std::endl;
+        }
+    }
+
+    offscreen_target(const offscreen_target&) = delete;
+    offscreen_target& operator=(const offscreen_target&) = delete;
+
+    ~offscreen_target() {
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteTextures(1, &tex_);
+    }
+
+    GLuint framebuffer() const { return fbo_; }
+    GLuint texture() const { return tex_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    void bind() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glViewport(0, 0, width_, height_);
+    }
+};
+
+/**
+ * @class pbo_readback_ring
+ * @brief asynchronous glReadPixels through a ring of pixel pack buffers guarded by fences
+ * push() queues the copy of frame N and returns at once; only when the ring is full does it wait
+ * for the oldest copy, so frames N+1.. keep rendering while N is in flight.
+ */
+class pbo_readback_ring {
+private:
+    struct slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        std::size_t index = 0;
+    };
+
+    std::vector<slot> slots_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+    int width_;
+    int height_;
+
+    readback_frame retire() {
+        auto& s = slots_[(head_ + slots_.size() - count_) % slots_.size()];
+        count_--;
+
+        while (glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100'000'000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(s.fence);
+        s.fence = nullptr;
+
+        readback_frame frame{s.index, width_, height_, std::vector<std::uint8_t>(bytes())};
+        const auto* src = glMapNamedBufferRange(s.pbo, 0, bytes(), GL_MAP_READ_BIT);
+        std::memcpy(frame.rgba.data(), src, bytes());
+        glUnmapNamedBuffer(s.pbo);
+        return frame;
+    }
+
+public:
+    pbo_readback_ring(int width, int height, std::size_t depth = 3)
+        : slots_(depth ? depth : 1), width_{width}, height_{height} {
+        for (auto& s : slots_) {
+            glCreateBuffers(1, &s.pbo);
+            glNamedBufferStorage(s.pbo, bytes(), nullptr, GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT);
+        }
+    }
+
+    pbo_readback_ring(const pbo_readback_ring&) = delete;
+    pbo_readback_ring& operator=(const pbo_readback_ring&) = delete;
+
+    ~pbo_readback_ring() {
+        for (auto& s : slots_) {
+            if (s.fence) glDeleteSync(s.fence);
+            glDeleteBuffers(1, &s.pbo);
+        }
+    }
+
+    std::size_t bytes() const { return static_cast<std::size_t>(width_) * height_ * 4; }
+
+    /**
+     * @brief start reading the current read framebuffer; on_frame gets the frame retired to make room, if any
+     */
+    template <typename F>
+    void push(std::size_t index, F&& on_frame) {
+        if (count_ == slots_.size()) on_frame(retire());
+
+        auto& s = slots_[head_];
+        s.index = index;
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        head_ = (head_ + 1) % slots_.size();
+        count_++;
+    }
+
+    template <typename F>
+    void drain(F&& on_frame) {
+        while (count_) on_frame(retire());
+    }
+};
+
+/**
+ * @brief render frames frames on the current context; draw(index, width, height) draws into the bound target
+ * draw may render into framebuffers of its own first as long as the last pass goes to the bound one.
+ * Frames stream through the PBO ring into opt.encoders encoder threads, so memory stays the same for any length.
+ */
+template <typename Draw>
+int run_headless(const headless_options& opt, std::size_t frames, Draw&& draw) {
+    offscreen_target target(opt.width, opt.height);
+    pbo_readback_ring ring(opt.width, opt.height);
+    frame_encoder encoder(opt.out, opt.format, opt.encoders, opt.fps);
+    frame_profiler profiler(opt.trace.empty() ? 1 : frames + 1);
+
+    const auto on_frame = [&](readback_frame frame) { encoder.push(std::move(frame)); };
+
+    for (std::size_t i = 0; i < frames; i++) {
+        profiler.begin_frame();
+        target.bind();
+        {
+            const auto timer = profiler.pass("draw");
+            draw(i, opt.width, opt.height);
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer());
+        {
+            // includes waiting for the oldest frame and handing it to the encoders once the ring is full
+            const auto timer = profiler.pass("readback", false);
+            ring.push(i, on_frame);
+        }
+        profiler.end_frame();
+    }
+    ring.drain(on_frame);
+
+    if (!opt.trace.empty()) {
+        profiler.begin_frame();  // picks up the GPU times of the last frames
+        if (!profiler.write_chrome_trace(opt.trace)) std::cerr << "failed to write " << opt.trace << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return 0;
+}
+
+#endif  // PRACC_GL_OFFSCREEN_H
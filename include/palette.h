@@ -0,0 +1,122 @@
+/**
+ * @file palette.h
+ * @brief gradient palettes sampled into a 1D lookup table, shared by the palette shader pass and cpu_render
+ */
+
+#ifndef PRACC_GL_PALETTE_H
+#define PRACC_GL_PALETTE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "include/escape_time.h"
+
+/**
+ * @brief colors evenly spaced over [0, 1], linearly interpolated in between
+ */
+using palette_stops = std::vector<std::array<float, 3>>;
+
+enum class palette_preset { classic, fire, ice, grayscale };
+
+inline constexpr const char* palette_preset_names[] = {"classic", "fire", "ice", "grayscale"};
+
+/**
+ * @brief classic is (t, t, 1 - t / 2), the gradient the shaders always used
+ */
+inline palette_stops palette_preset_stops(palette_preset preset) {
+    switch (preset) {
+        case palette_preset::fire:
+            return {{0.0f, 0.0f, 0.0f}, {0.8f, 0.1f, 0.0f}, {1.0f, 0.7f, 0.0f}, {1.0f, 1.0f, 0.9f}};
+        case palette_preset::ice:
+            return {{0.0f, 0.0f, 0.1f}, {0.0f, 0.4f, 0.8f}, {0.6f, 0.9f, 1.0f}, {1.0f, 1.0f, 1.0f}};
+        case palette_preset::grayscale:
+            return {{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+        case palette_preset::classic:
+        default:
+            return {{0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 0.5f}};
+    }
+}
+
+inline palette_preset palette_preset_from_string(std::string_view name) {
+    for (std::size_t i = 0; i < std::size(palette_preset_names); i++) {
+        if (name == palette_preset_names[i]) return static_cast<palette_preset>(i);
+    }
+    return palette_preset::classic;
+}
+
+/**
+ * @class palette_lut
+ * @brief size colors sampled from a gradient; entry i is the color at t = i / (size - 1)
+ */
+class palette_lut {
+private:
+    std::vector<std::array<float, 3>> colors_;
+
+public:
+    palette_lut(const palette_stops& stops, std::size_t size = 256) : colors_(std::max<std::size_t>(size, 2)) {
+        const auto n = colors_.size();
+        for (std::size_t i = 0; i < n; i++) {
+            const float t = static_cast<float>(i) / static_cast<float>(n - 1);
+            if (stops.size() < 2) {
+                colors_[i] = stops.empty() ? std::array<float, 3>{} : stops.front();
+                continue;
+            }
+
+            const float x = t * static_cast<float>(stops.size() - 1);
+            const auto k = std::min(static_cast<std::size_t>(x), stops.size() - 2);
+            const float f = x - static_cast<float>(k);
+            for (std::size_t c = 0; c < 3; c++) colors_[i][c] = stops[k][c] + (stops[k + 1][c] - stops[k][c]) * f;
+        }
+    }
+
+    const std::vector<std::array<float, 3>>& colors() const { return colors_; }
+
+    /**
+     * @brief linear interpolation between entries like a GL_LINEAR sampler with clamp to edge
+     */
+    std::array<float, 3> sample(float t) const {
+        const auto n = colors_.size();
+        const float x = std::clamp(t, 0.0f, 1.0f) * static_cast<float>(n - 1);
+        const auto k = std::min(static_cast<std::size_t>(x), n - 2);
+        const float f = x - static_cast<float>(k);
+        std::array<float, 3> ret;
+        for (std::size_t c = 0; c < 3; c++) ret[c] = colors_[k][c] + (colors_[k + 1][c] - colors_[k][c]) * f;
+        return ret;
+    }
+};
+
+/**
+ * @brief continuous iteration count iter + 1 - log2(log|z|), -1 for pixels that did not escape
+ * Same formula as the first pass of the shaders writes into the second channel of the iteration texture.
+ */
+inline float smooth_iteration(float re, float im, std::uint32_t iter) {
+    const float norm = re * re + im * im;
+    if (!(norm > 4.0f)) return -1.0f;
+    return std::max(0.0f, static_cast<float>(iter) + 1.0f - std::log2(0.5f * std::log(norm)));
+}
+
+/**
+ * @brief second pass on the CPU: raw escape-time results through a palette, interior stays black
+ * @param smooth color by smooth_iteration() instead of the integer count
+ */
+inline std::vector<std::array<float, 3>> colorize_escape_time(const escape_buffer& buf, std::uint32_t max_iter,
+                                                              const palette_lut& lut, bool smooth = false) {
+    std::vector<std::array<float, 3>> rgb(buf.width * buf.height);
+    for (std::size_t i = 0; i < rgb.size(); i++) {
+        const float mu = smooth_iteration(buf.re[i], buf.im[i], buf.iter[i]);
+        if (mu < 0.0f) {
+            rgb[i] = {};
+            continue;
+        }
+        const float n = smooth ? mu : static_cast<float>(buf.iter[i]);
+        rgb[i] = lut.sample(n / static_cast<float>(max_iter));
+    }
+    return rgb;
+}
+
+#endif  // PRACC_GL_PALETTE_H
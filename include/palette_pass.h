@@ -0,0 +1,99 @@
+/**
+ * @file palette_pass.h
+ * @brief GL side of the two pass pipeline: palette LUT texture and the pass that colors an iteration texture
+ */
+
+#ifndef PRACC_GL_PALETTE_PASS_H
+#define PRACC_GL_PALETTE_PASS_H
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "include/adaptive_aa.h"
+
+/**
+ * @brief what palette.frag does with the iteration texture
+ */
+enum class palette_mode : GLuint {
+    iteration = 0,  // gradient over iteration count / max_iter
+    smooth = 1,     // gradient over smooth iteration count / max_iter
+    indexed = 2,    // palette entry r, e.g. the newton root index
+    shaded = 3,     // palette entry r darkened by the smooth count in g, e.g. newton convergence speed
+};
+
+/**
+ * @class palette_texture
+ * @brief RGB32F 1D texture holding a palette_lut or a list of indexed colors
+ */
+class palette_texture {
+private:
+    GLuint tex_ = 0;
+    std::size_t size_ = 0;
+
+public:
+    palette_texture() = default;
+    palette_texture(const palette_texture&) = delete;
+    palette_texture& operator=(const palette_texture&) = delete;
+
+    ~palette_texture() { glDeleteTextures(1, &tex_); }
+
+    GLuint texture() const { return tex_; }
+
+    /**
+     * @brief replace the colors; the texture is only reallocated when their count changes
+     */
+    void upload(const std::vector<std::array<float, 3>>& colors) {
+        if (colors.size() != size_) {
+            glDeleteTextures(1, &tex_);
+            glCreateTextures(GL_TEXTURE_1D, 1, &tex_);
+            glTextureStorage1D(tex_, 1, GL_RGB32F, colors.size());
+            glTextureParameteri(tex_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTextureParameteri(tex_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(tex_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            size_ = colors.size();
+        }
+        glTextureSubImage1D(tex_, 0, 0, colors.size(), GL_RGB, GL_FLOAT, colors.data());
+    }
+};
+
+/**
+ * @brief second pass over the current viewport: iterations (the RG32F first pass output) through palette
+ * iterations must not be attached to the bound framebuffer.
+ */
+inline void draw_palette_pass(GLuint program, GLuint vao, std::size_t vao_len, GLuint iterations,
+                              const palette_texture& palette, palette_mode mode, float max_iter) {
+    glUseProgram(program);
+    glUniform1ui(glGetUniformLocation(program, "mode"), static_cast<GLuint>(mode));
+    glUniform1f(glGetUniformLocation(program, "max_iter"), max_iter);
+    glBindTextureUnit(0, iterations);
+    glBindTextureUnit(1, palette.texture());
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, vao_len);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+/**
+ * @brief adaptive antialiasing over the current viewport, drawn after draw_palette_pass into the same target
+ * program is an AA_SAMPLES variant of the fractal shader that wrote iterations (antialias.glsl), bound with its
+ * view uniforms already set as for its first pass. Pixels whose neighbours are all in their band / basin are
+ * discarded, the others get the mean color of their jittered samples.
+ */
+inline void draw_antialias_pass(GLuint program, GLuint vao, std::size_t vao_len, GLuint iterations,
+                                const palette_texture& palette, palette_mode mode, float max_iter,
+                                float tolerance = aa_default_tolerance) {
+    glUniform1ui(glGetUniformLocation(program, "mode"), static_cast<GLuint>(mode));
+    glUniform1f(glGetUniformLocation(program, "max_iter"), max_iter);
+    glUniform1f(glGetUniformLocation(program, "aa_tolerance"), tolerance);
+    glBindTextureUnit(0, iterations);
+    glBindTextureUnit(1, palette.texture());
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, vao_len);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+#endif  // PRACC_GL_PALETTE_PASS_H
@@ -0,0 +1,194 @@
+/**
+ * @file perturbation.h
+ * @brief deep zoom mandelbrot: one big_fixed reference orbit, every pixel as a double delta from it
+ */
+
+#ifndef PRACC_GL_PERTURBATION_H
+#define PRACC_GL_PERTURBATION_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "include/big_fixed.h"
+#include "include/escape_time.h"
+
+/**
+ * @brief view centered on an arbitrary precision point
+ * scale has the meaning of escape_view::scale, so 1.5 is the default view and 1e-100 is very deep.
+ * Deltas are doubles, which limits scale to roughly 1e-300.
+ */
+struct deep_view {
+    big_fixed center[2] = {big_fixed(-0.5, 2), big_fixed(0.0, 2)};
+    double scale = 1.5;
+};
+
+/**
+ * @brief big_fixed limb count able to resolve one pixel of a view, with 64 guard bits
+ */
+inline std::size_t deep_limbs(double scale, std::size_t min_len) {
+    const double pixel = 2.0 * scale / static_cast<double>(std::max<std::size_t>(min_len, 1));
+    const double bits = std::max(0.0, -std::log2(pixel)) + 64.0;
+    return 1 + static_cast<std::size_t>(std::ceil(bits / 32.0));
+}
+
+/**
+ * @brief reference orbit W_0 = 0, W_{j+1} = W_j^2 + C, plus the series skip chosen for a view
+ * W_1 = C is the shader's initial z, so pixel iteration i goes from W_{i+1} to W_{i+2}.
+ * Starting from 0 lets a pixel rebase onto the reference with delta = z exactly.
+ */
+struct reference_orbit {
+    std::vector<std::complex<double>> z;
+    std::uint32_t skip = 1;
+    std::array<std::complex<double>, 3> series = {std::complex<double>{1.0}, {}, {}};
+};
+
+/**
+ * @brief iterate the center in big_fixed until it escapes or max_iter
+ * The escaping element is kept; a pixel that reaches it rebases instead of stepping past it.
+ */
+inline std::vector<std::complex<double>> compute_reference_z(const big_fixed& cr, const big_fixed& ci,
+                                                             std::uint32_t max_iter) {
+    std::vector<std::complex<double>> z;
+    z.reserve(max_iter + 2);
+    z.emplace_back(0.0, 0.0);
+
+    auto zr = cr;
+    auto zi = ci;
+    z.emplace_back(zr.to_double(), zi.to_double());
+
+    for (std::uint32_t i = 0; i < max_iter; i++) {
+        const auto rr = zr * zr;
+        const auto ii = zi * zi;
+        auto ri = zr * zi;
+        ri += ri;
+        zr = rr - ii + cr;
+        zi = ri + ci;
+
+        const std::complex<double> w{zr.to_double(), zi.to_double()};
+        z.push_back(w);
+        if (std::norm(w) > 4.0) break;
+    }
+
+    return z;
+}
+
+/**
+ * @brief delta after the series skip: A dc + B dc^2 + C dc^3
+ */
+inline std::complex<double> series_delta(const std::array<std::complex<double>, 3>& s, std::complex<double> dc) {
+    return ((s[2] * dc + s[1]) * dc + s[0]) * dc;
+}
+
+/**
+ * @brief choose how many iterations the series approximation may skip
+ * Probe deltas (corners and edge midpoints of the view) are iterated exactly next to the series;
+ * the skip is the last step where every probe still agrees within tolerance, has not escaped and
+ * has not needed a rebase.
+ */
+inline void compute_series_skip(reference_orbit& ref, const std::vector<std::complex<double>>& probes,
+                                double tolerance = 1e-13) {
+    const auto& w = ref.z;
+    std::array<std::complex<double>, 3> s = {std::complex<double>{1.0}, {}, {}};  // coefficients of W_1
+    std::vector<std::complex<double>> delta = probes;                            // exact deltas at W_1
+
+    ref.skip = 1;
+    ref.series = s;
+
+    for (std::size_t j = 1; j + 1 < w.size(); j++) {
+        const auto two_w = 2.0 * w[j];
+        const std::array<std::complex<double>, 3> next = {two_w * s[0] + 1.0, two_w * s[1] + s[0] * s[0],
+                                                          two_w * s[2] + 2.0 * s[0] * s[1]};
+        bool valid = std::isfinite(std::norm(next[0])) && std::isfinite(std::norm(next[1])) &&
+                     std::isfinite(std::norm(next[2]));
+
+        for (std::size_t p = 0; valid && p < probes.size(); p++) {
+            delta[p] = (two_w + delta[p]) * delta[p] + probes[p];
+            const auto z = w[j + 1] + delta[p];
+            const auto err = std::abs(series_delta(next, probes[p]) - delta[p]);
+            valid = std::norm(z) <= 4.0 && std::norm(z) >= std::norm(delta[p]) && err <= tolerance * std::abs(delta[p]);
+        }
+
+        if (!valid) break;
+        s = next;
+        ref.skip = static_cast<std::uint32_t>(j + 1);
+        ref.series = s;
+    }
+}
+
+/**
+ * @brief reference orbit and series skip for view rendered at width x height
+ */
+inline reference_orbit compute_reference_orbit(const deep_view& view, std::size_t width, std::size_t height,
+                                               std::uint32_t max_iter) {
+    reference_orbit ref;
+    const auto limbs = deep_limbs(view.scale, std::min(width, height));
+    ref.z = compute_reference_z(view.center[0].with_limbs(limbs), view.center[1].with_limbs(limbs), max_iter);
+
+    const auto m = static_cast<double>(std::min(width, height));
+    const double hx = static_cast<double>(width) / m * view.scale;
+    const double hy = static_cast<double>(height) / m * view.scale;
+    compute_series_skip(ref, {{-hx, -hy}, {hx, -hy}, {-hx, hy}, {hx, hy}, {0.0, -hy}, {0.0, hy}, {-hx, 0.0}, {hx, 0.0}});
+    ref.skip = std::min(ref.skip, std::max<std::uint32_t>(max_iter, 1));
+
+    return ref;
+}
+
+/**
+ * @brief perturbation iteration of one pixel, same (z, iter) contract as the escape-time kernels
+ */
+inline void perturbation_pixel(const reference_orbit& ref, std::complex<double> dc, std::uint32_t max_iter,
+                               float& out_re, float& out_im, std::uint32_t& out_iter) {
+    const auto& w = ref.z;
+    const std::size_t last = w.size() - 1;
+
+    std::size_t m = ref.skip;
+    auto delta = series_delta(ref.series, dc);
+    auto z = w[m] + delta;
+    if (m == last) {
+        delta = z;
+        m = 0;
+    }
+
+    std::uint32_t i = ref.skip - 1;
+    for (; i < max_iter; i++) {
+        delta = (2.0 * w[m] + delta) * delta + dc;
+        m++;
+        z = w[m] + delta;
+
+        if (std::norm(z) > 4.0) break;
+
+        // glitch: the pixel left the reference's neighbourhood, continue from the start of the orbit
+        if (std::norm(z) < std::norm(delta) || m == last) {
+            delta = z;
+            m = 0;
+        }
+    }
+
+    out_re = static_cast<float>(z.real());
+    out_im = static_cast<float>(z.imag());
+    out_iter = i;
+}
+
+inline void render_perturbation_rows(const reference_orbit& ref, const deep_view& view, std::uint32_t max_iter,
+                                     escape_buffer& out, std::size_t row_begin, std::size_t row_end) {
+    const auto w = static_cast<double>(out.width);
+    const auto h = static_cast<double>(out.height);
+    const auto m = static_cast<double>(std::min(out.width, out.height));
+
+    for (auto row = row_begin; row < row_end; row++) {
+        const double y = ((static_cast<double>(row) + 0.5) * 2.0 - h) / m * view.scale;
+        for (std::size_t col = 0; col < out.width; col++) {
+            const double x = ((static_cast<double>(col) + 0.5) * 2.0 - w) / m * view.scale;
+            const auto idx = row * out.width + col;
+            perturbation_pixel(ref, {x, y}, max_iter, out.re[idx], out.im[idx], out.iter[idx]);
+            out.interior[idx] = static_cast<std::uint8_t>(interior_test::none);
+        }
+    }
+}
+
+#endif  // PRACC_GL_PERTURBATION_H
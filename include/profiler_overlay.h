@@ -0,0 +1,55 @@
+/**
+ * @file profiler_overlay.h
+ * @brief ImGui window graphing the per-pass frame times a frame_profiler collected
+ */
+
+#ifndef PRACC_GL_PROFILER_OVERLAY_H
+#define PRACC_GL_PROFILER_OVERLAY_H
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "include/frame_profiler.h"
+
+/**
+ * @brief one graph per pass (GPU time where it has a query, CPU time otherwise) and a "save trace" button
+ * The graphs show the frames the profiler keeps; idle frames the redraw scheduler skipped are not in them.
+ */
+inline void draw_profiler_overlay(const frame_profiler& profiler, const char* trace_path = "frame_trace.json") {
+    ImGui::Begin("frame times", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+    const auto plot = [](const std::string& label, const std::vector<float>& ms) {
+        if (ms.empty()) return;
+        const float avg = std::accumulate(ms.begin(), ms.end(), 0.0f) / static_cast<float>(ms.size());
+        const float max = *std::max_element(ms.begin(), ms.end());
+        char overlay[64];
+        std::snprintf(overlay, sizeof(overlay), "avg %.2f ms, max %.2f ms", avg, max);
+        ImGui::PlotLines(label.c_str(), ms.data(), static_cast<int>(ms.size()), 0, overlay, 0.0f,
+                         std::max(max, 1.0f), ImVec2(240.0f, 40.0f));
+    };
+
+    plot("frame (cpu)", profiler.frame_series());
+    for (std::size_t i = 0; i < profiler.pass_count(); i++) {
+        const bool gpu = profiler.pass_gpu(i);
+        plot(profiler.pass_name(i) + (gpu ? " (gpu)" : " (cpu)"), profiler.series(i, gpu));
+    }
+
+    if (ImGui::Button("save trace")) {
+        if (profiler.write_chrome_trace(trace_path)) {
+            std::cout << "trace: " << trace_path << std::endl;
+        } else {
+            std::cerr << "failed to write " << trace_path << std::endl;
+        }
+    }
+
+    ImGui::End();
+}
+
+#endif  // PRACC_GL_PROFILER_OVERLAY_H
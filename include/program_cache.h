@@ -0,0 +1,225 @@
+/**
+ * @file program_cache.h
+ * @brief on-disk cache of linked GL programs through glGetProgramBinary / glProgramBinary
+ */
+
+#ifndef PRACC_GL_PROGRAM_CACHE_H
+#define PRACC_GL_PROGRAM_CACHE_H
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "include/utils.h"
+
+/**
+ * @brief $PRACC_GL_PROGRAM_CACHE, else $XDG_CACHE_HOME/pracc_gl, else ~/.cache/pracc_gl
+ * An empty PRACC_GL_PROGRAM_CACHE (or no HOME) disables the cache.
+ */
+inline std::filesystem::path default_program_cache_dir() {
+    if (const auto* dir = std::getenv("PRACC_GL_PROGRAM_CACHE")) return dir;
+    if (const auto* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) return std::filesystem::path(xdg) / "pracc_gl";
+    if (const auto* home = std::getenv("HOME"); home && *home) {
+        return std::filesystem::path(home) / ".cache" / "pracc_gl";
+    }
+    return {};
+}
+
+struct program_cache_stats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t rejected = 0;  // binaries the driver refused, counted in misses as well
+    double hit_seconds = 0.0;
+    double miss_seconds = 0.0;
+};
+
+/**
+ * @class program_cache
+ * @brief links a program from its binary when an earlier run stored one, otherwise compiles and stores it
+ * The key hashes both sources, the defines they were specialized with and the driver's vendor, renderer,
+ * version and GLSL version, so a driver update or a shader edit simply misses. A binary the driver
+ * rejects anyway falls back to compilation and is overwritten.
+ */
+class program_cache {
+private:
+    static constexpr char magic_[4] = {'P', 'G', 'L', 'B'};
+
+    struct file_header {
+        char magic[4];
+        std::uint32_t format;
+        std::uint64_t key;
+        std::uint64_t length;
+    };
+
+    std::filesystem::path dir_;
+    std::vector<GLint> formats_;
+    program_cache_stats stats_;
+
+    static std::uint64_t fnv1a(std::uint64_t hash, std::string_view str) {
+        for (const auto ch : str) {
+            hash ^= static_cast<unsigned char>(ch);
+            hash *= 0x100000001b3ull;
+        }
+        // separator, so that ("ab", "c") and ("a", "bc") differ
+        hash ^= 0xff;
+        hash *= 0x100000001b3ull;
+        return hash;
+    }
+
+    static std::string_view gl_string(GLenum name) {
+        const auto* str = reinterpret_cast<const char*>(glGetString(name));
+        return str ? str : "";
+    }
+
+    std::filesystem::path path_of(std::uint64_t key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return dir_ / name;
+    }
+
+    std::optional<GLuint> load(std::uint64_t key) {
+        const auto path = path_of(key);
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return std::nullopt;
+
+        file_header header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return std::nullopt;
+        if (!std::equal(std::begin(magic_), std::end(magic_), header.magic) || header.key != key) return std::nullopt;
+        if (std::find(formats_.begin(), formats_.end(), static_cast<GLint>(header.format)) == formats_.end()) {
+            return std::nullopt;
+        }
+
+        // a truncated or corrupted entry is a miss, not an allocation of whatever its length says
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        if (ec || size < sizeof(header) || header.length != size - sizeof(header) ||
+            header.length > static_cast<std::uint64_t>(std::numeric_limits<GLsizei>::max())) {
+            return std::nullopt;
+        }
+
+        std::vector<char> binary(header.length);
+        if (!in.read(binary.data(), static_cast<std::streamsize>(binary.size()))) return std::nullopt;
+
+        const auto program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        GLint status;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (status) return program;
+
+        glDeleteProgram(program);
+        stats_.rejected++;
+        return std::nullopt;
+    }
+
+    void store(std::uint64_t key, GLuint program) const {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+
+        std::vector<char> binary(length);
+        GLenum format;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        std::error_code ec;
+        std::filesystem::create_directories(dir_, ec);
+
+        // written next to the final name and renamed, so a concurrent launch never reads half a file
+        const auto path = path_of(key);
+        auto tmp = path;
+        tmp += ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            file_header header = {{magic_[0], magic_[1], magic_[2], magic_[3]},
+                                  static_cast<std::uint32_t>(format),
+                                  key,
+                                  static_cast<std::uint64_t>(length)};
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(binary.data(), length);
+            if (!out) {
+                std::cerr << "program cache: failed to write " << tmp << std::endl;
+                return;
+            }
+        }
+        std::filesystem::rename(tmp, path, ec);
+    }
+
+public:
+    /**
+     * @param dir cache directory, created on the first store; empty disables the cache
+     */
+    explicit program_cache(std::filesystem::path dir = default_program_cache_dir()) : dir_{std::move(dir)} {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+        formats_.resize(count);
+        if (count) glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats_.data());
+    }
+
+    /**
+     * @brief caching is off without a directory or when the driver has no binary format
+     */
+    bool enabled() const { return !dir_.empty() && !formats_.empty(); }
+
+    const program_cache_stats& stats() const { return stats_; }
+
+    std::uint64_t key(std::string_view vsrc, std::string_view fsrc, std::string_view defines = {}) const {
+        auto hash = 0xcbf29ce484222325ull;
+        for (const auto str : {vsrc, fsrc, defines, gl_string(GL_VENDOR), gl_string(GL_RENDERER),
+                               gl_string(GL_VERSION), gl_string(GL_SHADING_LANGUAGE_VERSION)}) {
+            hash = fnv1a(hash, str);
+        }
+        return hash;
+    }
+
+    /**
+     * @brief create_program() through the cache
+     * @param defines whatever the sources were specialized with; only part of the key
+     */
+    std::optional<GLuint> create_program(const std::string& vsrc, const std::string& fsrc,
+                                         std::string_view defines = {}) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto elapsed = [&] {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        const auto k = key(vsrc, fsrc, defines);
+        if (enabled()) {
+            if (const auto program = load(k)) {
+                stats_.hits++;
+                stats_.hit_seconds += elapsed();
+                return program;
+            }
+        }
+
+        const auto program = ::create_program(vsrc.data(), fsrc.data(), enabled());
+        if (program && enabled()) store(k, *program);
+        stats_.misses++;
+        stats_.miss_seconds += elapsed();
+        return program;
+    }
+
+    void print_stats() const {
+        std::cout << "program cache: " << stats_.hits << " hit (" << stats_.hit_seconds * 1e3 << " ms), "
+                  << stats_.misses << " miss (" << stats_.miss_seconds * 1e3 << " ms)";
+        if (stats_.rejected) std::cout << ", " << stats_.rejected << " rejected";
+        if (!enabled()) std::cout << ", disabled";
+        std::cout << std::endl;
+    }
+};
+
+#endif  // PRACC_GL_PROGRAM_CACHE_H
@@ -0,0 +1,138 @@
+/**
+ * @file redraw.h
+ * @brief event driven redraw: dirty tracking per pass, cached last frame, blocking while idle
+ */
+
+#ifndef PRACC_GL_REDRAW_H
+#define PRACC_GL_REDRAW_H
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <tuple>
+
+#include "include/offscreen.h"
+#include "include/scroll_cache.h"
+
+/**
+ * @class dirty_state
+ * @brief remembers the inputs a pass was last drawn with
+ * update() stores the new inputs and returns true when they differ, i.e. when the pass has to be drawn again.
+ */
+template <typename... Ts>
+class dirty_state {
+private:
+    std::optional<std::tuple<Ts...>> last_;
+
+public:
+    bool update(const Ts&... now) {
+        if (last_ && *last_ == std::tie(now...)) return false;
+        last_.emplace(now...);
+        return true;
+    }
+
+    void invalidate() { last_.reset(); }
+};
+
+/**
+ * @class frame_cache
+ * @brief the last rendered fractal passes, kept in a texture and blitted to the window every frame
+ * Passes whose inputs did not change are not drawn again; ImGui is drawn on top of the blit.
+ * With a float format it holds the raw first pass output (iteration counts) instead of colors.
+ */
+class frame_cache {
+private:
+    std::optional<offscreen_target> target_;
+    std::optional<offscreen_target> scratch_;
+    GLenum format_;
+
+public:
+    explicit frame_cache(GLenum format = GL_RGBA8) : format_{format} {}
+
+    /**
+     * @return true if the cache was reallocated, which loses its content
+     */
+    bool resize(int width, int height) {
+        if (target_ && target_->width() == width && target_->height() == height) return false;
+
+        target_.reset();
+        scratch_.reset();
+        target_.emplace(std::max(width, 1), std::max(height, 1), format_);
+        constexpr GLfloat black[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        glClearNamedFramebufferfv(target_->framebuffer(), GL_COLOR, 0, black);
+        return true;
+    }
+
+    /**
+     * @brief make the cache the draw target; the caller sets the viewport of its pass
+     */
+    void bind() const { glBindFramebuffer(GL_FRAMEBUFFER, target_->framebuffer()); }
+
+    GLuint texture() const { return target_->texture(); }
+
+    /**
+     * @brief move the content inside area by (dx, dy) pixels, clipped to area
+     * exposed_strips(area, dx, dy) keep stale content and have to be drawn again. glCopyImageSubData is
+     * undefined for overlapping regions of one texture, so the still valid part goes through a scratch texture.
+     */
+    void scroll(const pixel_rect& area, int dx, int dy) {
+        const int w = area.width - std::abs(dx);
+        const int h = area.height - std::abs(dy);
+        if (w <= 0 || h <= 0 || (!dx && !dy)) return;
+
+        if (!scratch_) scratch_.emplace(target_->width(), target_->height(), format_);
+        const int x = area.x + std::max(-dx, 0);
+        const int y = area.y + std::max(-dy, 0);
+        glCopyImageSubData(target_->texture(), GL_TEXTURE_2D, 0, x, y, 0, scratch_->texture(), GL_TEXTURE_2D, 0, 0,
+                           0, 0, w, h, 1);
+        glCopyImageSubData(scratch_->texture(), GL_TEXTURE_2D, 0, 0, 0, 0, target_->texture(), GL_TEXTURE_2D, 0,
+                           x + dx, y + dy, 0, w, h, 1);
+    }
+
+    /**
+     * @brief copy the cache to the default framebuffer and leave that bound
+     */
+    void present() const {
+        const auto w = target_->width();
+        const auto h = target_->height();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBlitNamedFramebuffer(target_->framebuffer(), 0, 0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glViewport(0, 0, w, h);
+    }
+};
+
+/**
+ * @class redraw_scheduler
+ * @brief polls events while something changes and blocks in glfwWaitEvents once idle
+ * ImGui needs a few frames after an input to settle hover and active states, so settle_frames frames
+ * without changes are drawn before blocking. continuous keeps the old render-every-frame behaviour.
+ */
+class redraw_scheduler {
+private:
+    int settle_frames_;
+    int idle_ = 0;
+
+public:
+    bool continuous = false;
+
+    explicit redraw_scheduler(int settle_frames = 3) : settle_frames_{settle_frames} {}
+
+    /**
+     * @param changed whether any pass was drawn this frame
+     */
+    void next(bool changed) {
+        idle_ = continuous || changed ? 0 : idle_ + 1;
+
+        if (idle_ < settle_frames_) {
+            glfwPollEvents();
+        } else {
+            glfwWaitEvents();
+            idle_ = 0;
+        }
+    }
+};
+
+#endif  // PRACC_GL_REDRAW_H
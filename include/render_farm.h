@@ -0,0 +1,635 @@
+/**
+ * @file render_farm.h
+ * @brief multi-process tiled escape-time rendering: a coordinator hands tiles to worker processes and writes them out
+ */
+
+#ifndef PRACC_GL_RENDER_FARM_H
+#define PRACC_GL_RENDER_FARM_H
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "include/double_double.h"
+#include "include/escape_precise.h"
+#include "include/escape_time.h"
+#include "include/image_io.h"
+#include "include/mapped_image.h"
+#include "include/palette.h"
+#include "include/thread_pool.h"
+
+/**
+ * @brief what every worker needs to render any tile of one image
+ * Tiles are those of image_tile_rect(), so they line up with the tiles of the mapped_image they go into.
+ */
+struct farm_view {
+    fractal_kind kind = fractal_kind::mandelbrot;
+    std::size_t width = 1000;
+    std::size_t height = 1000;
+    std::size_t tile = 256;
+    std::string center[2] = {"-0.5", "0"};
+    double scale = 1.5;
+    std::uint32_t max_iter = 50;
+    float c[2] = {-0.5f, 0.0f};
+    precision_level precision = precision_level::float32;
+    bool smooth = false;
+
+    std::size_t tiles_x() const { return (width + tile - 1) / tile; }
+    std::size_t tiles_y() const { return (height + tile - 1) / tile; }
+    std::size_t tile_count() const { return tiles_x() * tiles_y(); }
+
+    std::array<std::size_t, 4> tile_rect(std::size_t index) const {
+        return image_tile_rect(width, height, tile, index);
+    }
+
+    /**
+     * @brief tile codes are 1 + iteration * resolution, 0 for the interior
+     */
+    std::uint32_t resolution() const { return smooth ? 256 : 1; }
+
+    /**
+     * @brief bound on compress_farm_tile() of any tile; a result announcing more is a broken worker
+     */
+    std::size_t max_tile_bytes() const { return tile * tile * 10; }
+};
+
+/**
+ * @brief the view as one line of text, sent to the workers and kept as the identity of a resumable output
+ */
+inline std::string farm_view_to_string(const farm_view& view) {
+    std::ostringstream ss;
+    ss.precision(17);
+    ss << "view " << (view.kind == fractal_kind::julia ? "julia" : "mandelbrot") << ' ' << view.width << ' '
+       << view.height << ' ' << view.tile << ' ' << view.center[0] << ' ' << view.center[1] << ' ' << view.scale
+       << ' ' << view.max_iter << ' ' << view.c[0] << ' ' << view.c[1] << ' '
+       << static_cast<int>(view.precision) << ' ' << (view.smooth ? 1 : 0);
+    return ss.str();
+}
+
+inline std::optional<farm_view> farm_view_from_string(std::string_view line) {
+    std::istringstream ss{std::string(line)};
+    farm_view view;
+    std::string word;
+    std::string kind;
+    int precision = 0;
+    int smooth = 0;
+    if (!(ss >> word >> kind >> view.width >> view.height >> view.tile >> view.center[0] >> view.center[1] >>
+          view.scale >> view.max_iter >> view.c[0] >> view.c[1] >> precision >> smooth) ||
+        word != "view" || !view.width || !view.height || !view.tile || precision < 0 ||
+        precision > static_cast<int>(precision_level::quad_double)) {
+        return std::nullopt;
+    }
+    view.kind = kind == "julia" ? fractal_kind::julia : fractal_kind::mandelbrot;
+    view.precision = static_cast<precision_level>(precision);
+    view.smooth = smooth != 0;
+    return view;
+}
+
+/**
+ * @brief render tile index and turn it into codes, rows bottom-up
+ * The buffer only holds the tile; the view's frame makes it map the pixels the whole image would.
+ */
+inline std::vector<std::uint32_t> render_farm_tile(const farm_view& view, std::size_t index, work_stealing_pool& pool,
+                                                   escape_isa isa = detect_escape_isa()) {
+    const auto [x0, y0, w, h] = view.tile_rect(index);
+    escape_params param;
+    param.kind = view.kind;
+    param.c[0] = view.c[0];
+    param.c[1] = view.c[1];
+    param.max_iter = view.max_iter;
+
+    auto precise = precise_view_from_strings(view.center[0], view.center[1], view.scale);
+    precise.pan[0] = static_cast<double>(x0);
+    precise.pan[1] = static_cast<double>(y0);
+    precise.frame[0] = view.width;
+    precise.frame[1] = view.height;
+    escape_view fast;
+    fast.scale = static_cast<float>(precise.scale);
+    fast.center[0] = static_cast<float>(precise.center[0][0]);
+    fast.center[1] = static_cast<float>(precise.center[1][0]);
+    fast.pan[0] = static_cast<float>(x0);
+    fast.pan[1] = static_cast<float>(y0);
+    fast.frame[0] = view.width;
+    fast.frame[1] = view.height;
+
+    const auto kernel = select_escape_kernel(isa);
+    const auto wide_kernel = select_precise_kernel(view.precision, isa);
+    escape_buffer buf(w, h);
+    constexpr std::size_t band = 16;
+    pool.parallel_for((h + band - 1) / band, [&](std::size_t i) {
+        const auto end = std::min((i + 1) * band, h);
+        if (view.precision == precision_level::float32) {
+            render_escape_time_rows(param, fast, buf, i * band, end, kernel);
+        } else {
+            render_precise_rows(param, precise, buf, i * band, end, wide_kernel);
+        }
+    });
+
+    std::vector<std::uint32_t> codes(w * h);
+    const double res = view.resolution();
+    constexpr double max_code = std::numeric_limits<std::uint32_t>::max();
+    for (std::size_t i = 0; i < codes.size(); i++) {
+        const float mu = smooth_iteration(buf.re[i], buf.im[i], buf.iter[i]);
+        if (mu < 0.0f) continue;
+        const double n = view.smooth ? mu : buf.iter[i];
+        codes[i] = static_cast<std::uint32_t>(std::min(1.0 + std::round(n * res), max_code));
+    }
+    return codes;
+}
+
+/**
+ * @brief palette color of one code, interior black, like colorize_escape_time()
+ */
+inline std::array<float, 3> farm_color(std::uint32_t code, const farm_view& view, const palette_lut& lut) {
+    if (!code) return {};
+    const float n = static_cast<float>(code - 1) / static_cast<float>(view.resolution());
+    return lut.sample(n / static_cast<float>(view.max_iter));
+}
+
+/**
+ * @brief color the codes of tile index straight into image and finish the tile there
+ */
+inline void write_farm_tile(mapped_image& image, const farm_view& view, std::size_t index,
+                            const std::vector<std::uint32_t>& codes, const palette_lut& lut) {
+    const auto [x0, y0, w, h] = view.tile_rect(index);
+    for (std::size_t row = 0; row < h; row++) {
+        auto* dst = image.row(index, row);
+        for (std::size_t col = 0; col < w; col++) {
+            const auto rgb = farm_color(codes[row * w + col], view, lut);
+            for (int c = 0; c < 3; c++) *dst++ = to_u8(rgb[c]);
+        }
+    }
+    image.finish(index);
+}
+
+namespace farm_detail {
+
+inline void put_varint(std::vector<std::uint8_t>& out, std::uint64_t v) {
+    for (; v >= 0x80; v >>= 7) out.push_back(static_cast<std::uint8_t>(v | 0x80));
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+inline std::optional<std::uint64_t> get_varint(const std::uint8_t*& p, const std::uint8_t* end) {
+    std::uint64_t v = 0;
+    for (int shift = 0; p != end && shift < 64; shift += 7) {
+        const auto b = *p++;
+        v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    return std::nullopt;
+}
+
+/**
+ * @brief the N space-separated numbers that make up all of fields, std::nullopt if any is missing or malformed
+ */
+template <std::size_t N>
+std::optional<std::array<std::size_t, N>> parse_fields(std::string_view fields) {
+    std::array<std::size_t, N> out{};
+    const auto* p = fields.data();
+    const auto* end = p + fields.size();
+    for (std::size_t i = 0; i < N; i++) {
+        if (i && (p == end || *p++ != ' ')) return std::nullopt;
+        const auto [next, ec] = std::from_chars(p, end, out[i]);
+        if (ec != std::errc{}) return std::nullopt;
+        p = next;
+    }
+    if (p != end) return std::nullopt;
+    return out;
+}
+
+// the pixel to the left, or the first one of the row below at the start of a row
+inline std::uint32_t predict(const std::vector<std::uint32_t>& codes, std::size_t i, std::size_t width) {
+    if (i == 0) return 0;
+    return codes[i % width ? i - 1 : i - width];
+}
+
+}  // namespace farm_detail
+
+/**
+ * @brief codes as (run of correctly predicted pixels, zigzag delta of the next one) varint pairs
+ * Iteration counts mostly match or differ by a little from their neighbour, so flat regions cost a few
+ * bytes and gradients one or two bytes per pixel.
+ */
+inline std::vector<std::uint8_t> compress_farm_tile(const std::vector<std::uint32_t>& codes, std::size_t width) {
+    std::vector<std::uint8_t> out;
+    std::uint64_t run = 0;
+    for (std::size_t i = 0; i < codes.size(); i++) {
+        const auto d = static_cast<std::int64_t>(codes[i]) - farm_detail::predict(codes, i, width);
+        if (d == 0) {
+            run++;
+            continue;
+        }
+        farm_detail::put_varint(out, run);
+        farm_detail::put_varint(out, (static_cast<std::uint64_t>(d) << 1) ^ static_cast<std::uint64_t>(d >> 63));
+        run = 0;
+    }
+    farm_detail::put_varint(out, run);
+    return out;
+}
+
+/**
+ * @return std::nullopt if bytes are not count codes of a tile width wide
+ */
+inline std::optional<std::vector<std::uint32_t>> decompress_farm_tile(const std::vector<std::uint8_t>& bytes,
+                                                                      std::size_t count, std::size_t width) {
+    std::vector<std::uint32_t> codes(count);
+    const auto* p = bytes.data();
+    const auto* end = p + bytes.size();
+    std::size_t i = 0;
+    while (true) {
+        const auto run = farm_detail::get_varint(p, end);
+        if (!run || *run > count - i) return std::nullopt;
+        for (const auto stop = i + *run; i < stop; i++) codes[i] = farm_detail::predict(codes, i, width);
+        if (i == count) break;
+        const auto z = farm_detail::get_varint(p, end);
+        if (!z) return std::nullopt;
+        const auto d = static_cast<std::int64_t>(*z >> 1) ^ -static_cast<std::int64_t>(*z & 1);
+        codes[i] = static_cast<std::uint32_t>(farm_detail::predict(codes, i, width) + d);
+        i++;
+    }
+    if (p != end) return std::nullopt;
+    return codes;
+}
+
+/**
+ * @brief one protocol message: a header line and, for "result INDEX BYTES", BYTES of compressed tile
+ */
+struct farm_message {
+    std::string line;
+    std::vector<std::uint8_t> payload;
+};
+
+/**
+ * @class farm_channel
+ * @brief framing of the coordinator <-> worker protocol on a pair of file descriptors
+ * The protocol is plain lines, so a worker can sit behind anything that forwards a byte stream: a socketpair
+ * for local workers, ssh for remote ones.
+ *     coordinator: view ... | tile INDEX | quit
+ *     worker:      ready DEPTH | result INDEX BYTES + BYTES of compress_farm_tile()
+ * A worker answers view with ready and then gets up to DEPTH tiles in flight, so the next one is
+ * already queued when it finishes a tile.
+ */
+class farm_channel {
+private:
+    int in_;
+    int out_;
+    std::size_t max_payload_;
+    std::string buf_;
+    bool broken_ = false;
+
+public:
+    /**
+     * @param max_payload largest result payload accepted, so a bad header cannot make next() wait for gigabytes
+     */
+    farm_channel(int in, int out, std::size_t max_payload = 0) : in_{in}, out_{out}, max_payload_{max_payload} {}
+
+    int fd() const { return in_; }
+
+    /**
+     * @brief the other side sent a result header that does not parse or announces too big a payload
+     */
+    bool broken() const { return broken_; }
+
+    bool send(std::string_view line, const std::vector<std::uint8_t>& payload = {}) {
+        std::string msg(line);
+        msg += '\n';
+        msg.append(payload.begin(), payload.end());
+        for (std::size_t done = 0; done < msg.size();) {
+            const auto n = ::write(out_, msg.data() + done, msg.size() - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    /**
+     * @brief one read of whatever has arrived; false once the other side is gone
+     */
+    bool fill() {
+        char chunk[1 << 16];
+        while (true) {
+            const auto n = ::read(in_, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buf_.append(chunk, static_cast<std::size_t>(n));
+            return true;
+        }
+    }
+
+    /**
+     * @brief the next complete message if it has fully arrived; std::nullopt for good once broken()
+     */
+    std::optional<farm_message> next() {
+        if (broken_) return std::nullopt;
+        const auto eol = buf_.find('\n');
+        if (eol == std::string::npos) return std::nullopt;
+        const auto line = std::string_view(buf_).substr(0, eol);
+        std::size_t bytes = 0;
+        if (line.starts_with("result ")) {
+            const auto fields = farm_detail::parse_fields<2>(line.substr(7));
+            if (!fields || (*fields)[1] > max_payload_) {
+                broken_ = true;
+                return std::nullopt;
+            }
+            bytes = (*fields)[1];
+        }
+        if (buf_.size() < eol + 1 + bytes) return std::nullopt;
+        farm_message msg{buf_.substr(0, eol), {buf_.begin() + eol + 1, buf_.begin() + eol + 1 + bytes}};
+        buf_.erase(0, eol + 1 + bytes);
+        return msg;
+    }
+
+    /**
+     * @brief block until the next message; std::nullopt once the other side is gone
+     */
+    std::optional<farm_message> receive() {
+        while (true) {
+            if (auto msg = next()) return msg;
+            if (broken_ || !fill()) return std::nullopt;
+        }
+    }
+};
+
+/**
+ * @brief worker side: answer view, render every tile asked for until quit or the coordinator is gone
+ */
+inline int run_farm_worker(int in, int out, work_stealing_pool& pool, escape_isa isa = detect_escape_isa(),
+                           std::size_t depth = 2) {
+    farm_channel channel(in, out);
+    std::optional<farm_view> view;
+    while (auto msg = channel.receive()) {
+        if (msg->line.starts_with("view ")) {
+            view = farm_view_from_string(msg->line);
+            if (!view) {
+                std::cerr << "farm worker: bad view: " << msg->line << std::endl;
+                return 1;
+            }
+            if (!channel.send("ready " + std::to_string(depth))) return 1;
+        } else if (msg->line.starts_with("tile ") && view) {
+            const auto fields = farm_detail::parse_fields<1>(std::string_view(msg->line).substr(5));
+            if (!fields || (*fields)[0] >= view->tile_count()) return 1;
+            const auto index = (*fields)[0];
+            const auto width = view->tile_rect(index)[2];
+            const auto bytes = compress_farm_tile(render_farm_tile(*view, index, pool, isa), width);
+            if (!channel.send("result " + std::to_string(index) + " " + std::to_string(bytes.size()), bytes)) {
+                return 1;
+            }
+        } else if (msg->line == "quit") {
+            return 0;
+        }
+    }
+    return channel.broken() ? 1 : 0;
+}
+
+struct farm_options {
+    std::size_t workers = 0;             // local worker processes running self farm-worker
+    std::vector<std::string> commands;   // more workers, each a shell command like "ssh node cpu_render farm-worker"
+    std::size_t threads_per_worker = 1;  // of the local workers
+    std::string self = "/proc/self/exe";
+    std::size_t max_restarts = 3;       // deaths in a row without a result before a worker is given up
+    std::chrono::seconds timeout{600};  // silence from a busy worker after which it counts as dead
+};
+
+namespace farm_detail {
+
+struct worker {
+    std::vector<std::string> argv;  // empty: run command through /bin/sh
+    std::string command;
+    pid_t pid = -1;
+    std::optional<farm_channel> channel;
+    std::size_t depth = 0;
+    std::vector<std::size_t> assigned;
+    std::size_t failures = 0;
+    bool busy = false;  // between view and quit
+    std::chrono::steady_clock::time_point heard;  // spawn or the last bytes it sent
+};
+
+/**
+ * @brief fork the worker with one end of a socketpair as its stdin and stdout
+ */
+inline bool spawn(worker& w, std::size_t max_payload) {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0) return false;
+    const auto pid = ::fork();
+    if (pid < 0) {
+        ::close(sv[0]);
+        ::close(sv[1]);
+        return false;
+    }
+    if (pid == 0) {
+        // its own process group, so terminating it also reaches what a shell command started
+        ::setpgid(0, 0);
+        ::dup2(sv[1], 0);
+        ::dup2(sv[1], 1);
+        if (w.argv.empty()) {
+            ::execl("/bin/sh", "sh", "-c", w.command.c_str(), static_cast<char*>(nullptr));
+        } else {
+            std::vector<char*> args;
+            for (auto& a : w.argv) args.push_back(a.data());
+            args.push_back(nullptr);
+            ::execv(args[0], args.data());
+        }
+        ::_exit(127);
+    }
+    ::setpgid(pid, pid);
+    ::close(sv[1]);
+    w.pid = pid;
+    w.channel.emplace(sv[0], sv[0], max_payload);
+    w.heard = std::chrono::steady_clock::now();
+    w.depth = 0;
+    w.busy = true;
+    return true;
+}
+
+/**
+ * @brief close the channel and terminate the worker
+ * Whatever it had in flight is done or taken back by then. A worker that failed may be stuck in a tile that
+ * never ends or ignore quit, so it is not waited for without SIGTERM.
+ */
+inline void reap(worker& w) {
+    if (w.channel) ::close(w.channel->fd());
+    w.channel.reset();
+    if (w.pid > 0) ::kill(-w.pid, SIGTERM);
+    if (w.pid > 0) ::waitpid(w.pid, nullptr, 0);
+    w.pid = -1;
+    w.busy = false;
+}
+
+}  // namespace farm_detail
+
+/**
+ * @brief render every tile of view that image does not have yet on the workers and write them into it
+ * A worker that dies, breaks the protocol or stays silent for timeout is terminated, gets its tiles taken
+ * back and is started again, until it fails max_restarts times in a row. Tiles go out in index order to
+ * whoever asks first, so faster workers simply take more of them.
+ */
+inline bool run_farm_tiles(const farm_view& view, const farm_options& opt, mapped_image& image,
+                           const palette_lut& lut) {
+    using namespace farm_detail;
+
+    std::deque<std::size_t> pending;
+    for (std::size_t i = 0; i < view.tile_count(); i++) {
+        if (!image.done(i)) pending.push_back(i);
+    }
+    std::size_t finished = view.tile_count() - pending.size();
+    if (pending.empty()) return true;
+
+    std::vector<worker> workers;
+    for (std::size_t i = 0; i < opt.workers; i++) {
+        worker w;
+        w.argv = {opt.self, "farm-worker", "--threads", std::to_string(opt.threads_per_worker)};
+        workers.push_back(std::move(w));
+    }
+    for (const auto& cmd : opt.commands) {
+        worker w;
+        w.command = cmd;
+        workers.push_back(std::move(w));
+    }
+    if (workers.empty()) {
+        std::cerr << "no farm workers" << std::endl;
+        return false;
+    }
+
+    // a worker dying mid-write must not take the coordinator with it
+    ::signal(SIGPIPE, SIG_IGN);
+
+    const auto view_line = farm_view_to_string(view);
+    const auto start = [&](worker& w) {
+        while (w.failures <= opt.max_restarts) {
+            if (spawn(w, view.max_tile_bytes()) && w.channel->send(view_line)) return;
+            reap(w);
+            w.failures++;
+        }
+        std::cerr << "giving up on farm worker " << (w.argv.empty() ? w.command : w.argv[0]) << std::endl;
+    };
+    const auto fail = [&](worker& w) {
+        pending.insert(pending.begin(), w.assigned.begin(), w.assigned.end());
+        w.assigned.clear();
+        reap(w);
+        w.failures++;
+        // the tiles it had may also need workers that already quit
+        for (auto& o : workers) {
+            if (!o.busy && !pending.empty() && o.failures <= opt.max_restarts) start(o);
+        }
+    };
+    const auto assign = [&](worker& w) {
+        while (w.assigned.size() < w.depth && !pending.empty()) {
+            const auto index = pending.front();
+            pending.pop_front();
+            w.assigned.push_back(index);
+            if (!w.channel->send("tile " + std::to_string(index))) return fail(w);
+        }
+        if (w.assigned.empty() && pending.empty()) {
+            w.channel->send("quit");
+            reap(w);
+        }
+    };
+
+    for (auto& w : workers) start(w);
+
+    const auto total = view.tile_count();
+    const auto begin = std::chrono::steady_clock::now();
+    auto report = begin;
+    while (finished < total) {
+        std::vector<pollfd> fds;
+        std::vector<worker*> owners;
+        for (auto& w : workers) {
+            if (!w.busy) continue;
+            fds.push_back({w.channel->fd(), POLLIN, 0});
+            owners.push_back(&w);
+        }
+        if (fds.empty()) {
+            std::cerr << "all farm workers failed after " << finished << " of " << total << " tiles" << std::endl;
+            return false;
+        }
+        if (::poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) return false;
+
+        for (std::size_t k = 0; k < fds.size(); k++) {
+            if (!fds[k].revents) continue;
+            auto& w = *owners[k];
+            if (!w.channel->fill()) {
+                fail(w);
+                continue;
+            }
+            w.heard = std::chrono::steady_clock::now();
+            while (w.busy) {
+                auto msg = w.channel->next();
+                if (!msg) {
+                    if (w.channel->broken()) {
+                        std::cerr << "farm worker sent a bad result header" << std::endl;
+                        fail(w);
+                    }
+                    break;
+                }
+                const std::string_view line = msg->line;
+                if (line.starts_with("ready ")) {
+                    const auto depth = parse_fields<1>(line.substr(6));
+                    if (!depth) {
+                        std::cerr << "farm worker sent a bad ready: " << line << std::endl;
+                        fail(w);
+                        break;
+                    }
+                    w.depth = std::max<std::size_t>((*depth)[0], 1);
+                } else if (line.starts_with("result ")) {
+                    // next() only hands out result lines that parse
+                    const auto a = (*parse_fields<2>(line.substr(7)))[0];
+                    const auto it = std::find(w.assigned.begin(), w.assigned.end(), a);
+                    const auto [x0, y0, tw, th] = view.tile_rect(std::min(a, total - 1));
+                    const auto codes = it == w.assigned.end() ? std::nullopt
+                                                              : decompress_farm_tile(msg->payload, tw * th, tw);
+                    if (!codes) {
+                        std::cerr << "farm worker sent a bad tile" << std::endl;
+                        fail(w);
+                        break;
+                    }
+                    w.assigned.erase(it);
+                    w.failures = 0;
+                    write_farm_tile(image, view, a, *codes, lut);
+                    finished++;
+                }
+                assign(w);
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        for (auto& w : workers) {
+            if (!w.busy || now - w.heard <= opt.timeout) continue;
+            std::cerr << "farm worker " << (w.argv.empty() ? w.command : w.argv[0]) << " silent for "
+                      << opt.timeout.count() << " s" << std::endl;
+            fail(w);
+        }
+        if (now - report > std::chrono::seconds(5)) {
+            report = now;
+            std::cout << "tiles: " << finished << " / " << total << std::endl;
+        }
+    }
+
+    for (auto& w : workers) {
+        if (!w.busy) continue;
+        w.channel->send("quit");
+        reap(w);
+    }
+    return true;
+}
+
+#endif  // PRACC_GL_RENDER_FARM_H
@@ -0,0 +1,171 @@
+/**
+ * @file scroll_cache.h
+ * @brief pan reuse: shift a cached frame by whole pixels and compute only the strips the shift exposes
+ */
+
+#ifndef PRACC_GL_SCROLL_CACHE_H
+#define PRACC_GL_SCROLL_CACHE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+#include "include/escape_time.h"
+#include "include/newton.h"
+#include "include/thread_pool.h"
+
+/**
+ * @brief x, y, width, height in pixels, y up like glViewport / glScissor
+ */
+struct pixel_rect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool empty() const { return width <= 0 || height <= 0; }
+    std::size_t area() const { return empty() ? 0 : static_cast<std::size_t>(width) * height; }
+};
+
+/**
+ * @brief the parts of area left without valid content when its content moves by (dx, dy)
+ * At most two rects: a full height column strip and a row strip over the remaining columns, i.e. the L shape.
+ * A shift of the whole width or height exposes all of area.
+ */
+inline std::vector<pixel_rect> exposed_strips(const pixel_rect& area, int dx, int dy) {
+    if (area.empty()) return {};
+    if (std::abs(dx) >= area.width || std::abs(dy) >= area.height) return {area};
+
+    std::vector<pixel_rect> ret;
+    const int cols = std::abs(dx);
+    const int rows = std::abs(dy);
+    if (cols) ret.push_back({dx > 0 ? area.x : area.x + area.width - cols, area.y, cols, area.height});
+    if (rows) {
+        ret.push_back({dx > 0 ? area.x + cols : area.x, dy > 0 ? area.y : area.y + area.height - rows,
+                       area.width - cols, rows});
+    }
+    return ret;
+}
+
+/**
+ * @brief move the pixels of a row major width x height image by (dx, dy) in place
+ * Pixels shifted out are dropped; the exposed_strips() of the image keep their old values.
+ */
+template <typename T>
+void shift_pixels(std::vector<T>& px, std::size_t width, std::size_t height, int dx, int dy) {
+    const auto w = static_cast<int>(width);
+    const auto h = static_cast<int>(height);
+    if (std::abs(dx) >= w || std::abs(dy) >= h || (!dx && !dy)) return;
+
+    const auto cols = static_cast<std::size_t>(w - std::abs(dx));
+    const auto src_x = static_cast<std::size_t>(std::max(-dx, 0));
+    const auto dst_x = static_cast<std::size_t>(std::max(dx, 0));
+
+    // walk rows against the direction of the shift so that no source row is overwritten before it is read
+    const auto move_row = [&](int row) {
+        const auto src = px.begin() + static_cast<std::ptrdiff_t>(row * width + src_x);
+        const auto dst = px.begin() + static_cast<std::ptrdiff_t>((row + dy) * width + dst_x);
+        if (dy == 0 && dx > 0) {
+            std::copy_backward(src, src + cols, dst + cols);
+        } else {
+            std::copy(src, src + cols, dst);
+        }
+    };
+    if (dy > 0) {
+        for (int row = h - 1 - dy; row >= 0; row--) move_row(row);
+    } else {
+        for (int row = -dy; row < h; row++) move_row(row);
+    }
+}
+
+/**
+ * @class drag_pan
+ * @brief whole pixel pan offset driven by a mouse drag; the view follows the cursor
+ * Fractions of a pixel are carried over to the next update, so slow drags still move.
+ */
+class drag_pan {
+private:
+    std::optional<std::array<double, 2>> from_;
+
+public:
+    std::array<int, 2> pan{};
+
+    /**
+     * @param held whether the drag button is down over the pane
+     * @param x, y cursor in window coordinates, y down
+     */
+    void update(bool held, double x, double y) {
+        if (!held) {
+            from_.reset();
+            return;
+        }
+        if (!from_) {
+            from_ = {x, y};
+            return;
+        }
+
+        const auto dx = static_cast<int>(std::trunc(x - (*from_)[0]));
+        const auto dy = static_cast<int>(std::trunc(y - (*from_)[1]));
+        pan[0] -= dx;
+        pan[1] += dy;
+        (*from_)[0] += dx;
+        (*from_)[1] += dy;
+    }
+
+    void reset() {
+        pan = {};
+        from_.reset();
+    }
+};
+
+/**
+ * @brief move the content of out by (dx, dy) and render only the strips that exposes
+ * view.pan must already hold the new pan, i.e. the old one minus (dx, dy). Because the pan is a whole
+ * number of pixels the result is bit-identical to render_escape_time() at the new view.
+ */
+inline void scroll_escape_time(const escape_params& param, const escape_view& view, escape_buffer& out, int dx,
+                               int dy, work_stealing_pool& pool, escape_kernel kernel = select_escape_kernel()) {
+    shift_pixels(out.re, out.width, out.height, dx, dy);
+    shift_pixels(out.im, out.width, out.height, dx, dy);
+    shift_pixels(out.iter, out.width, out.height, dx, dy);
+    shift_pixels(out.interior, out.width, out.height, dx, dy);
+
+    constexpr std::size_t band = 16;
+    const pixel_rect area = {0, 0, static_cast<int>(out.width), static_cast<int>(out.height)};
+    for (const auto& r : exposed_strips(area, dx, dy)) {
+        const auto rows = static_cast<std::size_t>(r.height);
+        pool.parallel_for((rows + band - 1) / band, [&](std::size_t i) {
+            const auto y0 = r.y + i * band;
+            render_escape_time_rect(param, view, out, r.x, y0, r.x + r.width, std::min(y0 + band, r.y + rows), kernel);
+        });
+    }
+}
+
+/**
+ * @brief scroll_escape_time for newton: shift out and render the exposed strips with render_newton()'s tiles
+ * param.pan must already hold the new pan.
+ */
+template <typename T>
+void scroll_newton(const newton_params<T>& param, newton_buffer& out, int dx, int dy, work_stealing_pool& pool,
+                   std::size_t tile = 32, escape_isa isa = detect_escape_isa()) {
+    shift_pixels(out.root, out.width, out.height, dx, dy);
+    shift_pixels(out.iter, out.width, out.height, dx, dy);
+    shift_pixels(out.smooth, out.width, out.height, dx, dy);
+
+    const auto kernel = select_newton_kernel<T>(newton_degree(param), isa);
+    const pixel_rect area = {0, 0, static_cast<int>(out.width), static_cast<int>(out.height)};
+    for (const auto& r : exposed_strips(area, dx, dy)) {
+        const auto x = static_cast<std::size_t>(r.x);
+        const auto y = static_cast<std::size_t>(r.y);
+        parallel_tiles(pool, r.width, r.height, tile, [&](std::size_t x0, std::size_t y0, std::size_t x1,
+                                                          std::size_t y1) {
+            kernel(param, out, x + x0, y + y0, x + x1, y + y1);
+        });
+    }
+}
+
+#endif  // PRACC_GL_SCROLL_CACHE_H
@@ -0,0 +1,140 @@
+/**
+ * @file shader_variants.h
+ * @brief shaders embedded at build time, specialized by #define injection and built on demand
+ */
+
+#ifndef PRACC_GL_SHADER_VARIANTS_H
+#define PRACC_GL_SHADER_VARIANTS_H
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "embedded_shaders.h"  // generated by scripts/embed_shaders.py
+#include "include/program_cache.h"
+
+/**
+ * @brief NAME VALUE pairs injected as #define lines, e.g. {{"MAX_ITER", "200"}, {"USE_DOUBLE", "1"}}
+ */
+using shader_defines = std::vector<std::pair<std::string, std::string>>;
+
+inline std::string define_lines(const shader_defines& defines) {
+    std::string ret;
+    for (const auto& [name, value] : defines) ret += "#define " + name + ' ' + value + '\n';
+    return ret;
+}
+
+/**
+ * @brief source with defines inserted after its #version line, the only line allowed to precede them
+ * A #line directive keeps compiler messages pointing at the lines of the original file.
+ */
+inline std::string specialize_shader(std::string_view source, const shader_defines& defines) {
+    std::size_t split = 0;
+    if (source.starts_with("#version")) {
+        split = source.find('\n');
+        split = split == std::string_view::npos ? source.size() : split + 1;
+    }
+
+    std::string ret{source.substr(0, split)};
+    if (!defines.empty()) {
+        ret += define_lines(defines);
+        ret += "#line " + std::to_string(split ? 2 : 1) + '\n';
+    }
+    ret += source.substr(split);
+    return ret;
+}
+
+/**
+ * @brief libraries appended to a specialized source, each after a #line directive giving it its own source
+ * string number (1, 2, ...), so compiler messages say which file and line they are about
+ * The source declares the library functions it calls; a library sees the source's defines.
+ */
+inline std::string append_shader_libraries(std::string source, const std::vector<std::string_view>& libraries) {
+    for (std::size_t i = 0; i < libraries.size(); i++) {
+        source += "\n#line 1 " + std::to_string(i + 1) + '\n';
+        source += libraries[i];
+    }
+    return source;
+}
+
+/**
+ * @brief value of caps closest to n from above (the largest cap if n exceeds all of them)
+ */
+inline std::uint32_t pick_variant(const std::vector<std::uint32_t>& caps, std::uint32_t n) {
+    for (const auto cap : caps) {
+        if (cap >= n) return cap;
+    }
+    return caps.back();
+}
+
+/**
+ * @class program_variants
+ * @brief every specialization of one vertex / fragment shader pair, linked on first use and kept
+ * Fixed values let the compiler unroll and fold what would otherwise be uniform driven loops;
+ * the program cache makes the extra variants cheap after the first launch.
+ */
+class program_variants {
+private:
+    program_cache& cache_;
+    std::string_view vsrc_;
+    std::string_view fsrc_;
+    std::vector<std::string_view> libraries_;
+    std::map<std::string, GLuint> programs_;
+
+public:
+    /**
+     * @param libraries shared GLSL appended to every variant of fsrc, e.g. embedded_palette_color_glsl
+     */
+    program_variants(program_cache& cache, std::string_view vsrc, std::string_view fsrc,
+                     std::vector<std::string_view> libraries = {})
+        : cache_{cache}, vsrc_{vsrc}, fsrc_{fsrc}, libraries_{std::move(libraries)} {}
+
+    program_variants(const program_variants&) = delete;
+    program_variants& operator=(const program_variants&) = delete;
+
+    ~program_variants() { clear(); }
+
+    /**
+     * @brief delete every linked variant; needed before the GL context goes away
+     */
+    void clear() {
+        for (const auto& [key, program] : programs_) glDeleteProgram(program);
+        programs_.clear();
+    }
+
+    /**
+     * @brief the variant for defines, built on first use; exits if it does not compile or link
+     * The compiler log is printed by create_program(), followed here by the defines it was built with.
+     */
+    GLuint get(const shader_defines& defines = {}) {
+        auto key = define_lines(defines);
+        if (const auto it = programs_.find(key); it != programs_.end()) return it->second;
+
+        const auto fsrc = append_shader_libraries(specialize_shader(fsrc_, defines), libraries_);
+        const auto program = cache_.create_program(std::string{vsrc_}, fsrc, key);
+        if (!program) {
+            std::cerr << "failed to build shader variant" << (key.empty() ? " without defines" : ":\n" + key)
+                      << std::endl;
+            std::exit(1);
+        }
+        programs_.emplace(std::move(key), *program);
+        return *program;
+    }
+
+    /**
+     * @brief link the variants a UI can switch between up front, so switching never stalls
+     */
+    void prebuild(const std::vector<shader_defines>& variants) {
+        for (const auto& defines : variants) get(defines);
+    }
+};
+
+#endif  // PRACC_GL_SHADER_VARIANTS_H
@@ -0,0 +1,290 @@
+/**
+ * @file simd_batch.h
+ * @brief fixed-width SIMD value types that plug into dual_num: simd<T, N> and complex_batch<T, N>
+ */
+
+#ifndef PRACC_GL_SIMD_BATCH_H
+#define PRACC_GL_SIMD_BATCH_H
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "include/dual_number.h"
+
+/**
+ * @brief GCC/Clang vector extension type of Bytes bytes; the attribute needs a typedef to apply to a dependent T
+ */
+template <typename T, std::size_t Bytes>
+struct simd_vector {
+    typedef T type __attribute__((vector_size(Bytes)));
+};
+
+/**
+ * @class simd
+ * @brief N lanes of T in one GCC/Clang vector register (or several, if the target is narrower)
+ * Lane-wise arithmetic only, so dual_num<simd<T, N>> reuses the scalar operator templates as they are.
+ * Built with FMA enabled the compiler contracts a * b + c of these into packed FMA.
+ */
+template <typename T, std::size_t N>
+class simd {
+public:
+    using value_type = T;
+    using vector_type = typename simd_vector<T, N * sizeof(T)>::type;
+    using mask_type = decltype(vector_type{} < vector_type{});
+
+    static constexpr std::size_t size() { return N; }
+
+    vector_type v;
+
+    constexpr simd() : v{} {}
+    constexpr simd(T x) : v{} { v += x; }
+    constexpr simd(vector_type x) : v{x} {}
+
+    static simd load(const T* p) {
+        simd ret;
+        __builtin_memcpy(&ret.v, p, sizeof(vector_type));
+        return ret;
+    }
+
+    void store(T* p) const { __builtin_memcpy(p, &v, sizeof(vector_type)); }
+
+    constexpr T operator[](std::size_t i) const { return v[i]; }
+    constexpr void set(std::size_t i, T x) { v[i] = x; }
+
+    constexpr simd& operator+=(const simd& x) {
+        v += x.v;
+        return *this;
+    }
+
+    constexpr simd& operator-=(const simd& x) {
+        v -= x.v;
+        return *this;
+    }
+
+    constexpr simd& operator*=(const simd& x) {
+        v *= x.v;
+        return *this;
+    }
+
+    constexpr simd& operator/=(const simd& x) {
+        v /= x.v;
+        return *this;
+    }
+};
+
+/**
+ * @class simd_mask
+ * @brief result of a lane-wise comparison, all bits set in true lanes
+ */
+template <typename T, std::size_t N>
+struct simd_mask {
+    typename simd<T, N>::mask_type m;
+
+    /**
+     * @brief every lane true, e.g. the lanes still iterating before the first step
+     */
+    static constexpr simd_mask all_true() { return {~typename simd<T, N>::mask_type{}}; }
+
+    constexpr bool operator[](std::size_t i) const { return m[i] != 0; }
+
+    constexpr simd_mask operator&(const simd_mask& x) const { return {m & x.m}; }
+    constexpr simd_mask operator|(const simd_mask& x) const { return {m | x.m}; }
+    constexpr simd_mask operator!() const { return {~m}; }
+};
+
+template <typename T, std::size_t N>
+constexpr bool any(const simd_mask<T, N>& x) {
+    for (std::size_t i = 0; i < N; i++) {
+        if (x[i]) return true;
+    }
+    return false;
+}
+
+template <typename T, std::size_t N>
+constexpr bool all(const simd_mask<T, N>& x) {
+    for (std::size_t i = 0; i < N; i++) {
+        if (!x[i]) return false;
+    }
+    return true;
+}
+
+template <typename T, std::size_t N>
+constexpr simd<T, N> operator+(simd<T, N> x, const simd<T, N>& y) {
+    return x += y;
+}
+
+template <typename T, std::size_t N>
+constexpr simd<T, N> operator-(simd<T, N> x, const simd<T, N>& y) {
+    return x -= y;
+}
+
+template <typename T, std::size_t N>
+constexpr simd<T, N> operator*(simd<T, N> x, const simd<T, N>& y) {
+    return x *= y;
+}
+
+template <typename T, std::size_t N>
+constexpr simd<T, N> operator/(simd<T, N> x, const simd<T, N>& y) {
+    return x /= y;
+}
+
+template <typename T, std::size_t N>
+constexpr simd<T, N> operator-(const simd<T, N>& x) {
+    return {-x.v};
+}
+
+template <typename T, std::size_t N>
+constexpr simd_mask<T, N> operator<(const simd<T, N>& x, const simd<T, N>& y) {
+    return {x.v < y.v};
+}
+
+template <typename T, std::size_t N>
+constexpr simd_mask<T, N> operator<=(const simd<T, N>& x, const simd<T, N>& y) {
+    return {x.v <= y.v};
+}
+
+template <typename T, std::size_t N>
+constexpr simd_mask<T, N> operator>(const simd<T, N>& x, const simd<T, N>& y) {
+    return {x.v > y.v};
+}
+
+/**
+ * @brief lane-wise a * b + c with a single rounding, found by ADL where generic code calls fma
+ * Unlike a contracted a * b + c it is fused even where FMA code generation is off, which the error-free
+ * products of double_double.h depend on. Inside an FMA target each lane compiles to vfmadd.
+ */
+template <typename T, std::size_t N>
+inline simd<T, N> fma(const simd<T, N>& a, const simd<T, N>& b, const simd<T, N>& c) {
+    simd<T, N> ret;
+    for (std::size_t i = 0; i < N; i++) ret.v[i] = std::fma(a.v[i], b.v[i], c.v[i]);
+    return ret;
+}
+
+/**
+ * @brief lane-wise mask ? x : y
+ */
+template <typename T, std::size_t N>
+constexpr simd<T, N> where(const simd_mask<T, N>& mask, const simd<T, N>& x, const simd<T, N>& y) {
+    return {mask.m ? x.v : y.v};
+}
+
+/**
+ * @class complex_batch
+ * @brief N complex numbers with real and imaginary parts in separate simd registers
+ * Arithmetic follows c_mul / c_div of the shaders (no scaling in division), which is also what lets
+ * it vectorize where std::complex<T>::operator/ does not.
+ */
+template <typename T, std::size_t N>
+class complex_batch {
+private:
+    simd<T, N> re_;
+    simd<T, N> im_;
+
+public:
+    using value_type = simd<T, N>;
+
+    static constexpr std::size_t size() { return N; }
+
+    constexpr complex_batch(simd<T, N> re = {}, simd<T, N> im = {}) : re_{re}, im_{im} {}
+    constexpr complex_batch(T re) : re_{re}, im_{} {}
+    constexpr complex_batch(const std::complex<T>& z) : re_{z.real()}, im_{z.imag()} {}
+
+    static complex_batch load(const std::complex<T>* p) {
+        complex_batch ret;
+        for (std::size_t i = 0; i < N; i++) ret.set(i, p[i]);
+        return ret;
+    }
+
+    void store(std::complex<T>* p) const {
+        for (std::size_t i = 0; i < N; i++) p[i] = (*this)[i];
+    }
+
+    constexpr simd<T, N> real() const { return re_; }
+    constexpr simd<T, N> imag() const { return im_; }
+
+    constexpr std::complex<T> operator[](std::size_t i) const { return {re_[i], im_[i]}; }
+
+    constexpr void set(std::size_t i, const std::complex<T>& z) {
+        re_.set(i, z.real());
+        im_.set(i, z.imag());
+    }
+
+    constexpr complex_batch& operator+=(const complex_batch& z) {
+        re_ += z.re_;
+        im_ += z.im_;
+        return *this;
+    }
+
+    constexpr complex_batch& operator-=(const complex_batch& z) {
+        re_ -= z.re_;
+        im_ -= z.im_;
+        return *this;
+    }
+
+    constexpr complex_batch& operator*=(const complex_batch& z) {
+        const auto r = re_ * z.re_ - im_ * z.im_;
+        im_ = re_ * z.im_ + im_ * z.re_;
+        re_ = r;
+        return *this;
+    }
+
+    constexpr complex_batch& operator/=(const complex_batch& z) {
+        const auto n = z.re_ * z.re_ + z.im_ * z.im_;
+        const auto r = (re_ * z.re_ + im_ * z.im_) / n;
+        im_ = (im_ * z.re_ - re_ * z.im_) / n;
+        re_ = r;
+        return *this;
+    }
+};
+
+template <typename T, std::size_t N>
+constexpr complex_batch<T, N> operator+(complex_batch<T, N> x, const complex_batch<T, N>& y) {
+    return x += y;
+}
+
+template <typename T, std::size_t N>
+constexpr complex_batch<T, N> operator-(complex_batch<T, N> x, const complex_batch<T, N>& y) {
+    return x -= y;
+}
+
+template <typename T, std::size_t N>
+constexpr complex_batch<T, N> operator*(complex_batch<T, N> x, const complex_batch<T, N>& y) {
+    return x *= y;
+}
+
+template <typename T, std::size_t N>
+constexpr complex_batch<T, N> operator/(complex_batch<T, N> x, const complex_batch<T, N>& y) {
+    return x /= y;
+}
+
+template <typename T, std::size_t N>
+constexpr complex_batch<T, N> operator-(const complex_batch<T, N>& x) {
+    return {-x.real(), -x.imag()};
+}
+
+/**
+ * @brief |z|^2 per lane
+ */
+template <typename T, std::size_t N>
+constexpr simd<T, N> norm(const complex_batch<T, N>& z) {
+    return z.real() * z.real() + z.imag() * z.imag();
+}
+
+template <typename T, std::size_t N>
+constexpr complex_batch<T, N> where(const simd_mask<T, N>& mask, const complex_batch<T, N>& x,
+                                    const complex_batch<T, N>& y) {
+    return {where(mask, x.real(), y.real()), where(mask, x.imag(), y.imag())};
+}
+
+/**
+ * @brief masked dual_num: lanes where mask is set come from x, the rest from y
+ */
+template <typename Tp, typename Mask>
+constexpr dual_num<Tp> where(const Mask& mask, const dual_num<Tp>& x, const dual_num<Tp>& y) {
+    return {where(mask, x.real(), y.real()), where(mask, x.imag(), y.imag())};
+}
+
+#endif  // PRACC_GL_SIMD_BATCH_H
@@ -0,0 +1,209 @@
+/**
+ * @file subdivision.h
+ * @brief Mariani-Silver rectangle subdivision for the escape-time CPU renderers
+ */
+
+#ifndef PRACC_GL_SUBDIVISION_H
+#define PRACC_GL_SUBDIVISION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "include/escape_precise.h"
+#include "include/escape_time.h"
+#include "include/thread_pool.h"
+
+/**
+ * @brief how render_subdivided() splits the image
+ * tile is the block each pool task subdivides on its own; a rectangle no wider or taller than min_size is
+ * computed in full instead of split again. interior_only fills only rectangles whose border did not escape:
+ * a filled pixel takes its count from the border but not a z of its own, which smooth coloring needs.
+ */
+struct subdivision_options {
+    std::size_t tile = 64;
+    std::size_t min_size = 6;
+    bool interior_only = false;
+};
+
+/**
+ * @brief pixels computed by the kernel and pixels filled from a uniform border
+ */
+struct subdivision_stats {
+    std::size_t computed = 0;
+    std::size_t filled = 0;
+
+    double filled_fraction() const {
+        const auto total = computed + filled;
+        return total ? static_cast<double>(filled) / static_cast<double>(total) : 0.0;
+    }
+
+    subdivision_stats& operator+=(const subdivision_stats& x) {
+        computed += x.computed;
+        filled += x.filled;
+        return *this;
+    }
+};
+
+namespace subdivision_detail {
+
+struct rect {
+    std::size_t x0, y0, x1, y1;
+};
+
+// One level of the subdivision of rects, whose borders have been rendered: a rectangle with a uniform border
+// is filled, a small one has its inside appended to pixels, any other one its middle row and column, and its
+// four quarters go to next.
+inline void subdivide_level(escape_buffer& out, std::uint32_t max_iter, const subdivision_options& opt,
+                            const std::vector<rect>& rects, std::vector<rect>& next, std::vector<std::size_t>& pixels,
+                            subdivision_stats& stats) {
+    const auto at = [&](std::size_t x, std::size_t y) { return y * out.width + x; };
+    for (const auto [x0, y0, x1, y1] : rects) {
+        if (x1 - x0 <= 2 || y1 - y0 <= 2) continue;
+
+        const auto first = at(x0, y0);
+        const auto count = out.iter[first];
+        bool uniform = !opt.interior_only || count == max_iter;
+        for (auto x = x0; x < x1 && uniform; x++) {
+            uniform = out.iter[at(x, y0)] == count && out.iter[at(x, y1 - 1)] == count;
+        }
+        for (auto y = y0 + 1; y + 1 < y1 && uniform; y++) {
+            uniform = out.iter[at(x0, y)] == count && out.iter[at(x1 - 1, y)] == count;
+        }
+
+        if (uniform) {
+            for (auto y = y0 + 1; y + 1 < y1; y++) {
+                const auto row = at(x0 + 1, y);
+                const auto len = x1 - x0 - 2;
+                std::fill_n(out.iter.begin() + row, len, count);
+                std::fill_n(out.re.begin() + row, len, out.re[first]);
+                std::fill_n(out.im.begin() + row, len, out.im[first]);
+                std::fill_n(out.interior.begin() + row, len, static_cast<std::uint8_t>(interior_test::none));
+            }
+            stats.filled += (x1 - x0 - 2) * (y1 - y0 - 2);
+        } else if (x1 - x0 <= opt.min_size || y1 - y0 <= opt.min_size) {
+            for (auto y = y0 + 1; y + 1 < y1; y++) {
+                for (auto x = x0 + 1; x + 1 < x1; x++) pixels.push_back(at(x, y));
+            }
+        } else {
+            const auto mx = (x0 + x1) / 2;
+            const auto my = (y0 + y1) / 2;
+            for (auto x = x0 + 1; x + 1 < x1; x++) pixels.push_back(at(x, my));
+            for (auto y = y0 + 1; y + 1 < y1; y++) {
+                if (y != my) pixels.push_back(at(mx, y));
+            }
+            next.push_back({x0, y0, mx + 1, my + 1});
+            next.push_back({mx, y0, x1, my + 1});
+            next.push_back({x0, my, mx + 1, y1});
+            next.push_back({mx, my, x1, y1});
+        }
+    }
+}
+
+}  // namespace subdivision_detail
+
+/**
+ * @brief render out by Mariani-Silver subdivision, one tile per pool task
+ * Every tile renders its border and is split in four while its border mixes counts; a rectangle whose whole
+ * border has one count is filled with it. The set and, for mandelbrot, every {c : count >= k} is connected and
+ * has no holes, so such a rectangle cannot hold another count, except for detail that falls between pixels
+ * and is lost. Filled julia sets only have this property for c in the mandelbrot set; a disconnected one can
+ * lose whole islands. Filled pixels copy z of the rectangle's corner and report interior_test::none.
+ * The tile is split breadth first: the middle rows and columns of all rectangles of one level go to render as
+ * a single list of pixels, so that the kernel's lanes stay full however small the rectangles get.
+ * @param render render(pixels, count) computes the pixels row * width + column of out listed in pixels;
+ * called from the pool's threads with disjoint lists
+ */
+template <typename Render>
+subdivision_stats render_subdivided(escape_buffer& out, std::uint32_t max_iter, Render&& render,
+                                    work_stealing_pool& pool, const subdivision_options& opt = {}) {
+    const auto tile = std::max<std::size_t>(opt.tile, 3);
+    const auto tiles_x = (out.width + tile - 1) / tile;
+    std::vector<subdivision_stats> tile_stats(tiles_x * ((out.height + tile - 1) / tile));
+
+    parallel_tiles(pool, out.width, out.height, tile, [&](std::size_t x0, std::size_t y0, std::size_t x1,
+                                                          std::size_t y1) {
+        auto& stats = tile_stats[y0 / tile * tiles_x + x0 / tile];
+        std::vector<std::size_t> pixels;
+        for (auto y = y0; y < y1; y++) {
+            for (auto x = x0; x < x1; x++) {
+                if (y == y0 || y + 1 == y1 || x == x0 || x + 1 == x1) pixels.push_back(y * out.width + x);
+            }
+        }
+        std::vector<subdivision_detail::rect> rects = {{x0, y0, x1, y1}};
+        std::vector<subdivision_detail::rect> next;
+        while (!pixels.empty()) {
+            render(pixels.data(), pixels.size());
+            stats.computed += pixels.size();
+            pixels.clear();
+            next.clear();
+            subdivision_detail::subdivide_level(out, max_iter, opt, rects, next, pixels, stats);
+            std::swap(rects, next);
+        }
+    });
+
+    subdivision_stats ret;
+    for (const auto& s : tile_stats) ret += s;
+    return ret;
+}
+
+/**
+ * @brief render_subdivided() with a float escape_kernel, the listed pixels gathered into escape_span::ys spans
+ */
+inline subdivision_stats render_escape_subdivided(const escape_params& param, const escape_view& view,
+                                                  escape_buffer& out, work_stealing_pool& pool,
+                                                  escape_kernel kernel = select_escape_kernel(),
+                                                  const subdivision_options& opt = {}) {
+    const auto frame = view_frame(view, out);
+    const auto m = std::min(frame[0], frame[1]);
+    const auto xs = escape_axis(out.width, m, view.scale, view.center[0], view.pan[0], frame[0]);
+    const auto ys = escape_axis(out.height, m, view.scale, view.center[1], view.pan[1], frame[1]);
+    const auto render = [&](const std::size_t* pixels, std::size_t count) {
+        constexpr std::size_t chunk = 256;
+        float px[chunk], py[chunk], re[chunk], im[chunk];
+        std::uint32_t iter[chunk];
+        std::uint8_t interior[chunk];
+        for (std::size_t j = 0; j < count; j += chunk) {
+            const auto len = std::min(chunk, count - j);
+            for (std::size_t k = 0; k < len; k++) {
+                const auto row = pixels[j + k] / out.width;
+                px[k] = xs[pixels[j + k] - row * out.width];
+                py[k] = ys[row];
+            }
+            kernel(param, {px, 0.0f, len, re, im, iter, interior, py});
+            for (std::size_t k = 0; k < len; k++) {
+                const auto idx = pixels[j + k];
+                out.re[idx] = re[k];
+                out.im[idx] = im[k];
+                out.iter[idx] = iter[k];
+                out.interior[idx] = interior[k];
+            }
+        }
+    };
+    return render_subdivided(out, param.max_iter, render, pool, opt);
+}
+
+/**
+ * @brief render_subdivided() with a precise_points_kernel
+ */
+inline subdivision_stats render_precise_subdivided(const escape_params& param, const precise_view& view,
+                                                   escape_buffer& out, work_stealing_pool& pool,
+                                                   precise_points_kernel kernel,
+                                                   const subdivision_options& opt = {}) {
+    const auto render = [&](const std::size_t* pixels, std::size_t count) {
+        kernel(param, view, out, pixels, count);
+    };
+    return render_subdivided(out, param.max_iter, render, pool, opt);
+}
+
+/**
+ * @brief pixels whose count differs between a subdivided render and a full one of the same view
+ */
+inline std::size_t subdivision_mismatches(const escape_buffer& subdivided, const escape_buffer& full) {
+    std::size_t ret = 0;
+    for (std::size_t i = 0; i < full.iter.size(); i++) ret += subdivided.iter[i] != full.iter[i];
+    return ret;
+}
+
+#endif  // PRACC_GL_SUBDIVISION_H
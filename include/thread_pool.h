@@ -0,0 +1,178 @@
+/**
+ * @file thread_pool.h
+ * @brief work-stealing thread pool used by the CPU renderers
+ */
+
+#ifndef PRACC_GL_THREAD_POOL_H
+#define PRACC_GL_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * @class work_stealing_pool
+ * @brief every worker owns a deque, pops its own work LIFO and steals FIFO from the others
+ * Tasks are pushed in contiguous blocks so neighbouring tiles stay on one worker until someone runs dry.
+ */
+class work_stealing_pool {
+private:
+    using task = std::function<void()>;
+
+    struct worker_queue {
+        std::mutex mtx;
+        std::deque<task> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex sleep_mtx_;
+    std::condition_variable sleep_cv_;
+    std::atomic<std::size_t> pending_{0};
+    bool stop_ = false;
+
+    std::optional<task> pop(std::size_t self) {
+        {
+            auto& q = *queues_[self];
+            std::lock_guard lock(q.mtx);
+            if (!q.tasks.empty()) {
+                auto t = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                pending_.fetch_sub(1);
+                return t;
+            }
+        }
+
+        for (std::size_t k = 1; k < queues_.size(); k++) {
+            auto& q = *queues_[(self + k) % queues_.size()];
+            std::lock_guard lock(q.mtx);
+            if (!q.tasks.empty()) {
+                auto t = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                pending_.fetch_sub(1);
+                return t;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    void run(std::size_t self) {
+        while (true) {
+            if (auto t = pop(self)) {
+                (*t)();
+                continue;
+            }
+
+            std::unique_lock lock(sleep_mtx_);
+            sleep_cv_.wait(lock, [this] { return stop_ || pending_.load() != 0; });
+            if (stop_) return;
+        }
+    }
+
+public:
+    /**
+     * @param threads number of workers; the thread calling parallel_for works too, so 1 means no extra thread
+     */
+    explicit work_stealing_pool(std::size_t threads = std::thread::hardware_concurrency()) {
+        threads = std::max<std::size_t>(threads, 1);
+        for (std::size_t i = 0; i < threads; i++) queues_.push_back(std::make_unique<worker_queue>());
+        for (std::size_t i = 1; i < threads; i++) threads_.emplace_back([this, i] { run(i); });
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    ~work_stealing_pool() {
+        {
+            std::lock_guard lock(sleep_mtx_);
+            stop_ = true;
+        }
+        sleep_cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    std::size_t size() const { return queues_.size(); }
+
+    /**
+     * @brief call f(i) for every i in [0, n) and block until all of them returned
+     * If any call throws, the remaining ones are skipped and the first exception is rethrown here once every
+     * queued task has finished, since they all reference this frame.
+     */
+    template <typename F>
+    void parallel_for(std::size_t n, F&& f) {
+        if (n == 0) return;
+
+        std::size_t remaining = n;
+        std::exception_ptr error;
+        std::mutex done_mtx;
+        std::condition_variable done_cv;
+        std::atomic<bool> failed{false};
+
+        // counted before pushing so a fast thief never sees it wrap below zero
+        {
+            std::lock_guard lock(sleep_mtx_);
+            pending_.fetch_add(n);
+        }
+
+        const auto workers = queues_.size();
+        for (std::size_t w = 0; w < workers; w++) {
+            const auto begin = n * w / workers;
+            const auto end = n * (w + 1) / workers;
+            auto& q = *queues_[w];
+            std::lock_guard lock(q.mtx);
+            // pushed in reverse so the owner pops them front to back
+            for (auto i = end; i-- > begin;) {
+                q.tasks.emplace_back([&, i] {
+                    std::exception_ptr e;
+                    if (!failed.load(std::memory_order_relaxed)) {
+                        try {
+                            f(i);
+                        } catch (...) {
+                            e = std::current_exception();
+                            failed.store(true, std::memory_order_relaxed);
+                        }
+                    }
+                    std::lock_guard done_lock(done_mtx);
+                    if (e && !error) error = std::move(e);
+                    if (--remaining == 0) done_cv.notify_all();
+                });
+            }
+        }
+
+        sleep_cv_.notify_all();
+
+        while (auto t = pop(0)) (*t)();
+
+        // also taken when everything is already done: the last task may still hold done_mtx
+        std::unique_lock lock(done_mtx);
+        done_cv.wait(lock, [&] { return remaining == 0; });
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+/**
+ * @brief split a width x height image into tile x tile blocks and run f(x0, y0, x1, y1) for each on the pool
+ */
+template <typename F>
+void parallel_tiles(work_stealing_pool& pool, std::size_t width, std::size_t height, std::size_t tile, F&& f) {
+    const auto tiles_x = (width + tile - 1) / tile;
+    const auto tiles_y = (height + tile - 1) / tile;
+
+    pool.parallel_for(tiles_x * tiles_y, [&](std::size_t i) {
+        const auto x0 = (i % tiles_x) * tile;
+        const auto y0 = (i / tiles_x) * tile;
+        f(x0, y0, std::min(x0 + tile, width), std::min(y0 + tile, height));
+    });
+}
+
+#endif  // PRACC_GL_THREAD_POOL_H
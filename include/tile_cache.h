@@ -0,0 +1,694 @@
+/**
+ * @file tile_cache.h
+ * @brief quadtree of escape-time tiles: compact storage, LRU memory budget, optional mmap spill, coarse fallback
+ */
+
+#ifndef PRACC_GL_TILE_CACHE_H
+#define PRACC_GL_TILE_CACHE_H
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "include/escape_time.h"
+#include "include/palette.h"
+
+/**
+ * @brief what a tile keeps per pixel, 16 bits either way
+ * iteration16: the integer count, interior_iter16 for points that did not escape
+ * smooth_half: smooth_iteration() as an IEEE half, -1 for the interior; exact to 1/1024 below 1024 iterations
+ */
+enum class tile_format : std::uint32_t { iteration16, smooth_half };
+
+inline constexpr std::size_t tile_size = 64;
+inline constexpr std::uint16_t interior_iter16 = 0xffff;
+
+/**
+ * @brief plane extent of one level 0 tile; tile (x, y) of level l covers [x, x + 1) * e x [y, y + 1) * e
+ * with e = tile_root_extent / 2^l, so its four children are (2x + i, 2y + j) of level l + 1.
+ */
+inline constexpr double tile_root_extent = 4.0;
+
+/**
+ * @brief deepest level; the float kernels run out of precision a few levels further down
+ */
+inline constexpr int tile_max_level = 14;
+
+inline double tile_extent(int level) {
+    return std::ldexp(tile_root_extent, -level);
+}
+
+struct tile_key {
+    fractal_kind kind = fractal_kind::mandelbrot;
+    std::uint64_t params = 0;
+    int level = 0;
+    std::int64_t x = 0;
+    std::int64_t y = 0;
+
+    bool operator==(const tile_key&) const = default;
+
+    /**
+     * @brief the tile k levels up that contains this one
+     */
+    tile_key ancestor(int k) const { return {kind, params, level - k, x >> k, y >> k}; }
+};
+
+struct tile_key_hash {
+    std::size_t operator()(const tile_key& key) const {
+        std::uint64_t h = key.params ^ (static_cast<std::uint64_t>(key.kind) << 56);
+        for (const auto v : {static_cast<std::uint64_t>(key.level), static_cast<std::uint64_t>(key.x),
+                             static_cast<std::uint64_t>(key.y)}) {
+            h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        }
+        return static_cast<std::size_t>(h);
+    }
+};
+
+/**
+ * @brief FNV-1a over everything but the pixel mapping of escape_params; the part of a tile_key that changes
+ * when the fractal itself does
+ */
+inline std::uint64_t tile_params_hash(const escape_params& param, tile_format format) {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    const auto mix = [&](std::uint64_t v) {
+        for (int i = 0; i < 8; i++) {
+            hash ^= (v >> (8 * i)) & 0xff;
+            hash *= 0x100000001b3ull;
+        }
+    };
+    mix(static_cast<std::uint64_t>(param.kind));
+    mix(std::bit_cast<std::uint32_t>(param.kind == fractal_kind::julia ? param.c[0] : 0.0f));
+    mix(std::bit_cast<std::uint32_t>(param.kind == fractal_kind::julia ? param.c[1] : 0.0f));
+    mix(param.max_iter);
+    mix(static_cast<std::uint64_t>(format));
+    return hash;
+}
+
+/**
+ * @brief float -> IEEE 754 binary16, round to nearest even, overflow to infinity
+ */
+inline std::uint16_t float_to_half(float f) {
+    const auto x = std::bit_cast<std::uint32_t>(f);
+    const auto sign = static_cast<std::uint16_t>((x >> 16) & 0x8000);
+    const auto exp = static_cast<int>((x >> 23) & 0xff);
+    auto mant = x & 0x7fffff;
+
+    if (exp == 0xff) return sign | 0x7c00 | (mant ? 0x200 : 0);
+    const int e = exp - 127 + 15;
+    if (e >= 0x1f) return sign | 0x7c00;
+    if (e <= 0) {
+        if (e < -10) return sign;
+        mant |= 0x800000;
+        const auto shift = static_cast<std::uint32_t>(14 - e);
+        auto h = mant >> shift;
+        const auto rest = mant & ((1u << shift) - 1);
+        const auto half = 1u << (shift - 1);
+        if (rest > half || (rest == half && (h & 1))) h++;
+        return sign | static_cast<std::uint16_t>(h);
+    }
+
+    auto h = static_cast<std::uint32_t>(e << 10) | (mant >> 13);
+    const auto rest = mant & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1))) h++;
+    return sign | static_cast<std::uint16_t>(h);
+}
+
+inline float half_to_float(std::uint16_t h) {
+    const std::uint32_t sign = static_cast<std::uint32_t>(h & 0x8000) << 16;
+    const int exp = (h >> 10) & 0x1f;
+    const std::uint32_t mant = h & 0x3ff;
+
+    if (exp == 0x1f) return std::bit_cast<float>(sign | 0x7f800000 | (mant << 13));
+    if (exp == 0) {
+        const float v = std::ldexp(static_cast<float>(mant), -24);
+        return sign ? -v : v;
+    }
+    return std::bit_cast<float>(sign | static_cast<std::uint32_t>(exp - 15 + 127) << 23 | (mant << 13));
+}
+
+/**
+ * @brief tile_size x tile_size pixels, row 0 at the bottom like gl_FragCoord
+ */
+struct tile {
+    tile_format format = tile_format::iteration16;
+    std::vector<std::uint16_t> data = std::vector<std::uint16_t>(tile_size * tile_size);
+
+    std::size_t bytes() const { return sizeof(tile) + data.size() * sizeof(std::uint16_t); }
+
+    /**
+     * @brief pixel i as the (iteration count, smooth count) pair of the RG32F iteration texture
+     * iteration16 repeats the count as the smooth value; smooth_half truncates it for the count.
+     */
+    std::array<float, 2> texel(std::size_t i) const {
+        if (format == tile_format::iteration16) {
+            if (data[i] == interior_iter16) return {0.0f, -1.0f};
+            const auto n = static_cast<float>(data[i]);
+            return {n, n};
+        }
+        const float mu = half_to_float(data[i]);
+        return {mu < 0.0f ? 0.0f : std::floor(mu), mu};
+    }
+};
+
+/**
+ * @brief compute one tile with an escape-time kernel
+ */
+inline tile render_escape_tile(const escape_params& param, const tile_key& key, tile_format format,
+                               escape_kernel kernel = select_escape_kernel()) {
+    const double e = tile_extent(key.level);
+    std::array<float, tile_size> xs;
+    for (std::size_t i = 0; i < tile_size; i++) {
+        xs[i] = static_cast<float>((static_cast<double>(key.x) + (static_cast<double>(i) + 0.5) / tile_size) * e);
+    }
+
+    std::array<float, tile_size> re;
+    std::array<float, tile_size> im;
+    std::array<std::uint32_t, tile_size> iter;
+    tile ret;
+    ret.format = format;
+    for (std::size_t row = 0; row < tile_size; row++) {
+        const auto y =
+            static_cast<float>((static_cast<double>(key.y) + (static_cast<double>(row) + 0.5) / tile_size) * e);
+        kernel(param, {xs.data(), y, tile_size, re.data(), im.data(), iter.data()});
+
+        for (std::size_t i = 0; i < tile_size; i++) {
+            const float mu = smooth_iteration(re[i], im[i], iter[i]);
+            auto& px = ret.data[row * tile_size + i];
+            if (format == tile_format::smooth_half) {
+                px = float_to_half(mu);
+            } else {
+                px = mu < 0.0f ? interior_iter16 : static_cast<std::uint16_t>(std::min(iter[i], 0xfffeu));
+            }
+        }
+    }
+    return ret;
+}
+
+/**
+ * @class tile_spill
+ * @brief memory-mapped ring of fixed size tile slots in a file
+ * Tiles evicted from memory are written here and read back on a later miss. A directory at the start of the
+ * file holds the key and write generation of every slot, so reopening reads only the directory to restore
+ * the index, and the ring resumes after the newest slot. A file of another format or size is started over.
+ * The file is locked for as long as it is open; a second process gets no spill rather than a shared one.
+ */
+class tile_spill {
+private:
+    // the last character is the format version
+    static constexpr char magic_[8] = {'P', 'G', 'L', 'T', 'I', 'L', 'E', '2'};
+
+    struct file_header {
+        char magic[8];
+        std::uint64_t slots;
+        std::uint64_t slot_bytes;
+    };
+
+    // generation 0 marks an empty slot
+    struct directory_entry {
+        std::uint64_t generation;
+        tile_key key;
+    };
+
+    struct slot_header {
+        char magic[8];
+        std::uint64_t generation;
+        tile_format format;
+        tile_key key;
+    };
+
+    static constexpr std::size_t slot_bytes_ = sizeof(slot_header) + tile_size * tile_size * sizeof(std::uint16_t);
+    static constexpr std::size_t page_ = 4096;
+
+    int fd_ = -1;
+    std::byte* map_ = nullptr;
+    std::size_t bytes_ = 0;
+    std::size_t data_ = 0;
+    std::size_t slots_ = 0;
+    std::size_t next_ = 0;
+    std::uint64_t generation_ = 0;
+    std::unordered_map<tile_key, std::size_t, tile_key_hash> index_;
+
+    std::byte* slot(std::size_t i) const { return map_ + data_ + i * slot_bytes_; }
+    std::byte* entry(std::size_t i) const { return map_ + sizeof(file_header) + i * sizeof(directory_entry); }
+
+    directory_entry read_entry(std::size_t i) const {
+        directory_entry ret;
+        std::memcpy(&ret, entry(i), sizeof(ret));
+        return ret;
+    }
+
+    void write_entry(std::size_t i, const directory_entry& e) { std::memcpy(entry(i), &e, sizeof(e)); }
+
+public:
+    tile_spill() = default;
+    tile_spill(const tile_spill&) = delete;
+    tile_spill& operator=(const tile_spill&) = delete;
+
+    ~tile_spill() { close(); }
+
+    /**
+     * @param capacity_bytes size of the file, rounded down to whole slots and their directory entries
+     */
+    bool open(const std::string& path, std::size_t capacity_bytes) {
+        close();
+        const auto slots = capacity_bytes / (slot_bytes_ + sizeof(directory_entry));
+        if (!slots) return false;
+
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) return false;
+        if (::flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+            close();
+            return false;
+        }
+        slots_ = slots;
+        data_ = (sizeof(file_header) + slots_ * sizeof(directory_entry) + page_ - 1) / page_ * page_;
+        bytes_ = data_ + slots_ * slot_bytes_;
+
+        file_header header{};
+        const bool valid = ::pread(fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                           std::equal(std::begin(magic_), std::end(magic_), header.magic) &&
+                           header.slots == slots_ && header.slot_bytes == slot_bytes_;
+        // a sparse file, only the slots actually written take disk space; truncating first drops a stale one
+        if ((!valid && ::ftruncate(fd_, 0) != 0) || ::ftruncate(fd_, static_cast<off_t>(bytes_)) != 0) {
+            close();
+            return false;
+        }
+        void* map = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (map == MAP_FAILED) {
+            close();
+            return false;
+        }
+        map_ = static_cast<std::byte*>(map);
+
+        if (!valid) {
+            std::copy(std::begin(magic_), std::end(magic_), header.magic);
+            header.slots = slots_;
+            header.slot_bytes = slot_bytes_;
+            std::memcpy(map_, &header, sizeof(header));
+            return true;
+        }
+        for (std::size_t i = 0; i < slots_; i++) {
+            const auto e = read_entry(i);
+            if (!e.generation) continue;
+            index_[e.key] = i;
+            if (e.generation > generation_) {
+                generation_ = e.generation;
+                next_ = (i + 1) % slots_;
+            }
+        }
+        return true;
+    }
+
+    void close() {
+        if (map_) ::munmap(map_, bytes_);
+        if (fd_ >= 0) ::close(fd_);
+        map_ = nullptr;
+        fd_ = -1;
+        index_.clear();
+        next_ = 0;
+        generation_ = 0;
+    }
+
+    bool is_open() const { return map_ != nullptr; }
+    std::size_t size() const { return index_.size(); }
+
+    /**
+     * @brief store t in the next slot, overwriting the oldest spilled tile once the ring is full
+     * The directory entry is cleared while the slot is rewritten, so a crash in between leaves an empty slot.
+     */
+    void store(const tile_key& key, const tile& t) {
+        if (!map_ || index_.contains(key)) return;
+
+        if (const auto old = read_entry(next_); old.generation) index_.erase(old.key);
+        write_entry(next_, {});
+
+        slot_header header{};
+        std::copy(std::begin(magic_), std::end(magic_), header.magic);
+        header.generation = ++generation_;
+        header.format = t.format;
+        header.key = key;
+        std::memcpy(slot(next_) + sizeof(header), t.data.data(), t.data.size() * sizeof(std::uint16_t));
+        std::memcpy(slot(next_), &header, sizeof(header));
+        write_entry(next_, {header.generation, key});
+        index_[key] = next_;
+        next_ = (next_ + 1) % slots_;
+    }
+
+    /**
+     * @brief the tile stored for key, if its slot still holds it
+     */
+    std::optional<tile> load(const tile_key& key) {
+        const auto it = index_.find(key);
+        if (it == index_.end()) return std::nullopt;
+
+        slot_header header;
+        std::memcpy(&header, slot(it->second), sizeof(header));
+        if (!std::equal(std::begin(magic_), std::end(magic_), header.magic) || !(header.key == key)) {
+            index_.erase(it);
+            return std::nullopt;
+        }
+        tile ret;
+        ret.format = header.format;
+        std::memcpy(ret.data.data(), slot(it->second) + sizeof(header), ret.data.size() * sizeof(std::uint16_t));
+        return ret;
+    }
+};
+
+struct tile_cache_stats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+    std::size_t spill_hits = 0;
+};
+
+/**
+ * @class tile_cache
+ * @brief tiles by key, least recently used first out once their bytes exceed the budget
+ * Thread safe; tiles are shared_ptr so an evicted tile stays valid for whoever is still reading it.
+ */
+class tile_cache {
+private:
+    using entry = std::pair<tile_key, std::shared_ptr<const tile>>;
+
+    std::list<entry> lru_;
+    std::unordered_map<tile_key, std::list<entry>::iterator, tile_key_hash> index_;
+    std::size_t budget_;
+    std::size_t bytes_ = 0;
+    tile_spill spill_;
+    tile_cache_stats stats_;
+    mutable std::mutex mtx_;
+
+    void evict() {
+        while (bytes_ > budget_ && !lru_.empty()) {
+            auto& [key, t] = lru_.back();
+            spill_.store(key, *t);
+            bytes_ -= t->bytes();
+            index_.erase(key);
+            lru_.pop_back();
+            stats_.evictions++;
+        }
+    }
+
+    void insert_locked(const tile_key& key, std::shared_ptr<const tile> t) {
+        if (const auto it = index_.find(key); it != index_.end()) {
+            bytes_ -= it->second->second->bytes();
+            lru_.erase(it->second);
+        }
+        bytes_ += t->bytes();
+        lru_.emplace_front(key, std::move(t));
+        index_[key] = lru_.begin();
+        evict();
+    }
+
+public:
+    explicit tile_cache(std::size_t budget_bytes) : budget_{budget_bytes} {}
+
+    /**
+     * @brief keep evicted tiles in a memory-mapped file of capacity_bytes at path
+     */
+    bool enable_spill(const std::string& path, std::size_t capacity_bytes) {
+        std::lock_guard lock(mtx_);
+        return spill_.open(path, capacity_bytes);
+    }
+
+    void set_budget(std::size_t budget_bytes) {
+        std::lock_guard lock(mtx_);
+        budget_ = budget_bytes;
+        evict();
+    }
+
+    /**
+     * @brief the tile for key, from memory or the spill file; a hit becomes the most recently used tile
+     * @param record count the lookup in stats(); fallback probes for ancestors are not
+     */
+    std::shared_ptr<const tile> find(const tile_key& key, bool record = true) {
+        std::lock_guard lock(mtx_);
+        if (const auto it = index_.find(key); it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            stats_.hits += record;
+            return it->second->second;
+        }
+        if (auto t = spill_.load(key)) {
+            auto ret = std::make_shared<const tile>(std::move(*t));
+            insert_locked(key, ret);
+            stats_.spill_hits += record;
+            return ret;
+        }
+        stats_.misses += record;
+        return nullptr;
+    }
+
+    void insert(const tile_key& key, std::shared_ptr<const tile> t) {
+        std::lock_guard lock(mtx_);
+        insert_locked(key, std::move(t));
+    }
+
+    std::size_t bytes() const {
+        std::lock_guard lock(mtx_);
+        return bytes_;
+    }
+
+    std::size_t size() const {
+        std::lock_guard lock(mtx_);
+        return lru_.size();
+    }
+
+    std::size_t spilled() const {
+        std::lock_guard lock(mtx_);
+        return spill_.size();
+    }
+
+    tile_cache_stats stats() const {
+        std::lock_guard lock(mtx_);
+        return stats_;
+    }
+};
+
+/**
+ * @brief plane view like escape_view but in double, so tile levels past float's pixel mapping still line up
+ */
+struct tile_view {
+    double scale = 1.5;
+    double center[2] = {-0.5, 0.0};
+};
+
+/**
+ * @class tile_browser
+ * @brief draws views out of a tile_cache and computes the missing tiles on its own background threads
+ * Requests are served newest first, so the tiles of the current view come before those of views already
+ * scrolled past; a missing tile is drawn from its nearest cached ancestor, upsampled, until it arrives.
+ */
+class tile_browser {
+private:
+    tile_cache& cache_;
+    tile_format format_;
+    std::deque<std::pair<tile_key, escape_params>> jobs_;
+    std::unordered_set<tile_key, tile_key_hash> queued_;
+    std::vector<std::thread> threads_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::condition_variable idle_cv_;
+    std::size_t running_ = 0;
+    std::size_t generation_ = 0;
+    bool stop_ = false;
+
+    void run() {
+        const auto kernel = select_escape_kernel();
+        while (true) {
+            std::unique_lock lock(mtx_);
+            cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (stop_) return;
+            const auto [key, param] = jobs_.back();
+            jobs_.pop_back();
+            running_++;
+            lock.unlock();
+
+            cache_.insert(key, std::make_shared<const tile>(render_escape_tile(param, key, format_, kernel)));
+
+            lock.lock();
+            queued_.erase(key);
+            generation_++;
+            running_--;
+            lock.unlock();
+            idle_cv_.notify_all();
+            if (on_ready) on_ready();
+        }
+    }
+
+    void request(const tile_key& key, const escape_params& param) {
+        std::lock_guard lock(mtx_);
+        if (!queued_.insert(key).second) return;
+        jobs_.emplace_back(key, param);
+        // only the newest requests matter while browsing, the rest are dropped and asked for again if needed
+        if (jobs_.size() > max_queued) {
+            queued_.erase(jobs_.front().first);
+            jobs_.pop_front();
+        }
+        cv_.notify_one();
+    }
+
+public:
+    static constexpr std::size_t max_queued = 1024;
+
+    /**
+     * @brief called on a background thread after every finished tile, e.g. glfwPostEmptyEvent to wake a blocked loop
+     */
+    std::function<void()> on_ready;
+
+    tile_browser(tile_cache& cache, tile_format format,
+                 std::size_t threads = std::max(std::thread::hardware_concurrency(), 2u) - 1)
+        : cache_{cache}, format_{format} {
+        for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); i++) threads_.emplace_back([this] { run(); });
+    }
+
+    tile_browser(const tile_browser&) = delete;
+    tile_browser& operator=(const tile_browser&) = delete;
+
+    ~tile_browser() {
+        {
+            std::lock_guard lock(mtx_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    /**
+     * @brief number of tiles finished so far; a change means a composed view may have become sharper
+     */
+    std::size_t generation() {
+        std::lock_guard lock(mtx_);
+        return generation_;
+    }
+
+    std::size_t pending() {
+        std::lock_guard lock(mtx_);
+        return jobs_.size() + running_;
+    }
+
+    /**
+     * @brief block until every requested tile is in the cache
+     */
+    void wait() {
+        std::unique_lock lock(mtx_);
+        idle_cv_.wait(lock, [this] { return jobs_.empty() && !running_; });
+    }
+
+    /**
+     * @brief coarsest level whose pixels are no larger than the pixels of a view of scale on min_len pixels
+     */
+    static int level_for(double scale, std::size_t min_len) {
+        const double spacing = 2.0 * scale / static_cast<double>(min_len);
+        const double level = std::ceil(std::log2(tile_root_extent / (tile_size * spacing)));
+        return std::clamp(static_cast<int>(level), 0, tile_max_level);
+    }
+
+    /**
+     * @brief fill out with width x height (iteration count, smooth count) pairs for view, row 0 at the bottom
+     * Uses the same pixel -> plane mapping as escape_axis() and samples the nearest tile pixel.
+     * @return pixels drawn from a coarser tile than the view asks for; 0 once the view is complete
+     */
+    std::size_t compose(const escape_params& param, const tile_view& view, std::size_t width, std::size_t height,
+                        std::vector<std::array<float, 2>>& out) {
+        out.assign(width * height, {0.0f, -1.0f});
+        if (!width || !height) return 0;
+
+        const auto m = static_cast<double>(std::min(width, height));
+        const int level = level_for(view.scale, std::min(width, height));
+        const double e = tile_extent(level);
+        const auto params = tile_params_hash(param, format_);
+
+        // tile index and pixel inside the tile, per column and per row
+        const auto axis = [&](std::size_t len, double center) {
+            std::vector<std::pair<std::int64_t, std::size_t>> ret(len);
+            for (std::size_t i = 0; i < len; i++) {
+                const double p =
+                    ((static_cast<double>(i) + 0.5) * 2.0 - static_cast<double>(len)) / m * view.scale + center;
+                const double t = std::floor(p / e);
+                const auto u = static_cast<std::size_t>((p / e - t) * tile_size);
+                ret[i] = {static_cast<std::int64_t>(t), std::min(u, tile_size - 1)};
+            }
+            return ret;
+        };
+        const auto xs = axis(width, view.center[0]);
+        const auto ys = axis(height, view.center[1]);
+
+        // every visible tile is resolved once: the tile itself, or its nearest cached ancestor and how far up it is
+        const auto tx0 = xs.front().first;
+        const auto ty0 = ys.front().first;
+        const auto tiles_x = static_cast<std::size_t>(xs.back().first - tx0 + 1);
+        const auto tiles_y = static_cast<std::size_t>(ys.back().first - ty0 + 1);
+        std::vector<std::pair<std::shared_ptr<const tile>, int>> visible(tiles_x * tiles_y);
+
+        // requested center out, so the middle of the view sharpens first
+        std::vector<std::size_t> order(visible.size());
+        for (std::size_t i = 0; i < order.size(); i++) order[i] = i;
+        const auto distance = [&](std::size_t i) {
+            const auto dx = static_cast<double>(i % tiles_x) - (tiles_x - 1) / 2.0;
+            const auto dy = static_cast<double>(i / tiles_x) - (tiles_y - 1) / 2.0;
+            return dx * dx + dy * dy;
+        };
+        std::sort(order.begin(), order.end(), [&](auto a, auto b) { return distance(a) > distance(b); });
+
+        for (const auto i : order) {
+            const tile_key key = {param.kind, params, level, tx0 + static_cast<std::int64_t>(i % tiles_x),
+                                  ty0 + static_cast<std::int64_t>(i / tiles_x)};
+            if (auto t = cache_.find(key)) {
+                visible[i] = {std::move(t), 0};
+                continue;
+            }
+            request(key, param);
+            for (int k = 1; k <= level; k++) {
+                if (auto t = cache_.find(key.ancestor(k), false)) {
+                    visible[i] = {std::move(t), k};
+                    break;
+                }
+            }
+        }
+
+        std::size_t coarse = 0;
+        for (std::size_t row = 0; row < height; row++) {
+            const auto [ty, v] = ys[row];
+            const auto* line = visible.data() + static_cast<std::size_t>(ty - ty0) * tiles_x;
+            for (std::size_t col = 0; col < width; col++) {
+                const auto [tx, u] = xs[col];
+                const auto& [t, k] = line[static_cast<std::size_t>(tx - tx0)];
+                if (!t) {
+                    coarse++;
+                    continue;
+                }
+                if (k) coarse++;
+                // position inside the ancestor: the tile's offset among the ancestor's descendants plus the pixel,
+                // scaled down by 2^k
+                const auto ax = (static_cast<std::size_t>(tx - ((tx >> k) << k)) * tile_size + u) >> k;
+                const auto ay = (static_cast<std::size_t>(ty - ((ty >> k) << k)) * tile_size + v) >> k;
+                out[row * width + col] = t->texel(ay * tile_size + ax);
+            }
+        }
+        return coarse;
+    }
+};
+
+#endif  // PRACC_GL_TILE_CACHE_H
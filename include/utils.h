@@ -4,9 +4,13 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#include <fstream>
+#include <cstddef>
+#include <iostream>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 struct Vertex {
     float x_;
@@ -27,16 +31,6 @@ struct Color {
 #endif
 };
 
-std::optional<std::string> read_file(const char* path) {
-    std::ifstream in(path);
-
-    if (in) {
-        return std::string{std::istreambuf_iterator{in}, std::istreambuf_iterator<decltype(in)::char_type>{}};
-    }
-
-    return std::nullopt;
-}
-
 const char* ec_to_string(GLenum ec) {
     switch (ec) {
         case GL_NO_ERROR:
@@ -100,8 +94,12 @@ GLboolean print_program_log(GLuint program) {
     return status;
 }
 
-std::optional<GLuint> create_program(const char* vsrc, const char* fsrc) {
+/**
+ * @param retrievable ask the driver to keep the linked binary for glGetProgramBinary
+ */
+std::optional<GLuint> create_program(const char* vsrc, const char* fsrc, bool retrievable = false) {
     const auto program = glCreateProgram();
+    if (retrievable) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
     if (!(vsrc && fsrc)) return std::nullopt;
 
@@ -129,4 +127,62 @@ std::optional<GLuint> create_program(const char* vsrc, const char* fsrc) {
     return std::nullopt;
 }
 
+/**
+ * @brief full screen quad feeding program's "position" attribute
+ * @return {vao, vertex count} for glDrawArrays(GL_TRIANGLE_FAN, ...)
+ */
+std::pair<GLuint, std::size_t> create_quad_vao(GLuint program) {
+    auto in_location = glGetAttribLocation(program, "position");
+    std::vector<Vertex> vertexes;
+    vertexes.emplace_back(-1.0, -1.0);
+    vertexes.emplace_back(-1.0, 1.0);
+    vertexes.emplace_back(1.0, 1.0);
+    vertexes.emplace_back(1.0, -1.0);
+
+    GLuint vbo;
+    glCreateBuffers(1, &vbo);
+
+    glNamedBufferData(vbo, std::size(vertexes) * sizeof(decltype(vertexes)::value_type), std::data(vertexes),
+                      GL_STATIC_DRAW);
+
+    // https://stackoverflow.com/questions/16380005/opengl-3-4-glvertexattribpointer-stride-and-offset-miscalculation
+    GLuint vao;
+    glCreateVertexArrays(1, &vao);
+    glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
+    glVertexArrayAttribFormat(vao, in_location, 2, GL_FLOAT, GL_FALSE, 0);
+    glEnableVertexArrayAttrib(vao, in_location);
+    glVertexArrayAttribBinding(vao, in_location, 0);
+
+    return {vao, std::size(vertexes)};
+}
+
+/**
+ * @brief glfwTerminate() at scope exit
+ * Declared right after glfwInit() so that GL objects owned by later locals are destroyed while the context
+ * still exists.
+ */
+struct glfw_terminate_guard {
+    glfw_terminate_guard() = default;
+    glfw_terminate_guard(const glfw_terminate_guard&) = delete;
+    glfw_terminate_guard& operator=(const glfw_terminate_guard&) = delete;
+    ~glfw_terminate_guard() { glfwTerminate(); }
+};
+
+void GLAPIENTRY print_debug_message(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                    [[maybe_unused]] GLsizei length, const GLchar* message,
+                                    [[maybe_unused]] const void* userParam) {
+    std::cerr << "-----glDebugMessageCallback-----" << std::endl
+              << "source: " << source << std::endl
+              << "type: " << type << std::endl
+              << "id: " << id << std::endl
+              << "severity: " << severity << std::endl
+              << "message: " << message << std::endl;
+}
+
+void print_gl_info() {
+    std::cout << "OpenGL Version:" << glGetString(GL_VERSION) << std::endl;
+    std::cout << "Vendor:" << glGetString(GL_VENDOR) << std::endl;
+    std::cout << "Renderer:" << glGetString(GL_RENDERER) << std::endl;
+}
+
 #endif // PRACC_GL_UTILS_H
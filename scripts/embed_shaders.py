@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+# embed_shaders.py OUTPUT SHADER...
+# Writes a header with every shader as a constexpr std::string_view named embedded_<file name>,
+# e.g. mandelbrot.frag -> embedded_mandelbrot_frag.
+
+import os
+import re
+import sys
+
+DELIMITER = 'glsl'
+
+
+def identifier(path):
+    return 'embedded_' + re.sub(r'[^0-9A-Za-z]', '_', os.path.basename(path))
+
+
+def main():
+    out_path, shaders = sys.argv[1], sys.argv[2:]
+
+    lines = [
+        '// generated by scripts/embed_shaders.py, do not edit',
+        '',
+        '#ifndef PRACC_GL_EMBEDDED_SHADERS_H',
+        '#define PRACC_GL_EMBEDDED_SHADERS_H',
+        '',
+        '#include <string_view>',
+        '',
+    ]
+
+    for path in shaders:
+        with open(path, encoding='utf-8') as f:
+            source = f.read()
+        if ')' + DELIMITER + '"' in source:
+            sys.exit(f'{path}: contains the raw string delimiter )' + DELIMITER + '"')
+        lines.append(f'inline constexpr std::string_view {identifier(path)} = R"{DELIMITER}({source}){DELIMITER}";')
+        lines.append('')
+
+    lines.append('#endif  // PRACC_GL_EMBEDDED_SHADERS_H')
+
+    with open(out_path, 'w', encoding='utf-8') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,70 @@
+// adaptive antialiasing, appended after palette_color.glsl to the AA_SAMPLES variants of the fractal shaders
+// (adaptive_aa.h is the CPU side). Drawn over a pane the palette pass has just colored, it keeps only the
+// pixels with a neighbour in another band or basin of the iteration texture and replaces their color by the
+// mean of up to AA_SAMPLES jittered samples of evaluate(), which the fractal shader defines.
+#if AA_SAMPLES
+
+layout(binding = 0) uniform sampler2D iterations;
+// a pixel stops once a batch of samples moves its mean by less than this in every channel
+uniform float aa_tolerance;
+
+vec2 evaluate(vec2 offset);
+vec3 palette_color(vec2 it);
+
+// aa_hash() in adaptive_aa.h
+uint aa_hash(uvec2 p) {
+	uint h = p.x * 0x8da6b343u ^ p.y * 0xd8163841u;
+	h = (h ^ (h >> 16)) * 0x7feb352du;
+	h = (h ^ (h >> 15)) * 0x846ca68bu;
+	return h ^ (h >> 16);
+}
+
+// aa_offset() in adaptive_aa.h: the R2 sequence, rotated by a per pixel hash
+vec2 aa_offset(uint i, uvec2 p) {
+	uint h = aa_hash(p);
+	vec2 rotation = vec2(float(h & 0xffffu), float(h >> 16)) / 65536.0;
+	return fract(rotation + float(i) * vec2(0.7548776662, 0.5698402910)) - 0.5;
+}
+
+// aa_same_band() in adaptive_aa.h; smooth coloring (mode 1) is continuous across a step of one
+bool aa_same(vec2 a, vec2 b) {
+	if (min(a.g, 0.0) != min(b.g, 0.0)) return false;
+	return mode == 1 ? abs(a.r - b.r) <= 1.0 : a.r == b.r;
+}
+
+vec4 antialias() {
+	ivec2 p = ivec2(gl_FragCoord.xy);
+	ivec2 last = textureSize(iterations, 0) - 1;
+	vec2 center = texelFetch(iterations, p, 0).rg;
+	bool edge = false;
+	for (int dy = -1; dy <= 1; dy++) {
+		for (int dx = -1; dx <= 1; dx++) {
+			edge = edge || !aa_same(center, texelFetch(iterations, clamp(p + ivec2(dx, dy), ivec2(0), last), 0).rg);
+		}
+	}
+	if (!edge) discard;
+
+	// batches of 4, 4, 8, 16, ...: the first stops if its samples agree, the others if they barely moved the mean
+	vec3 sum = vec3(0.0);
+	vec3 lo = vec3(1.0e30);
+	vec3 hi = vec3(-1.0e30);
+	vec3 mean = vec3(0.0);
+	uint n = 0u;
+	while (n < uint(AA_SAMPLES)) {
+		uint end = min(max(n * 2u, 4u), uint(AA_SAMPLES));
+		for (; n < end; n++) {
+			vec3 c = palette_color(evaluate(aa_offset(n, uvec2(p))));
+			sum += c;
+			lo = min(lo, c);
+			hi = max(hi, c);
+		}
+		vec3 next = sum / float(n);
+		vec3 change = n <= 4u ? hi - lo : abs(next - mean);
+		mean = next;
+		if (all(lessThan(change, vec3(aa_tolerance)))) break;
+	}
+
+	return vec4(mean, 1.0);
+}
+
+#endif
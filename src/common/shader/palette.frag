@@ -0,0 +1,13 @@
+#version 450
+
+// second pass: colors the iteration texture written by the fractal shaders with palette_color.glsl,
+// which the executables append to this source
+layout(binding = 0) uniform sampler2D iterations;
+
+layout(location = 0) out vec4 fragment;
+
+vec3 palette_color(vec2 it);
+
+void main() {
+	fragment = vec4(palette_color(texelFetch(iterations, ivec2(gl_FragCoord.xy), 0).rg), 1.0);
+}
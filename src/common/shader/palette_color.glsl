@@ -0,0 +1,33 @@
+// palette.frag's coloring as a function, appended by the executables to palette.frag and to the
+// antialiasing variants of the fractal shaders, which color their extra samples the same way
+// 0: gradient over r / max_iter, 1: gradient over g / max_iter, 2: palette[r], 3: palette[r] darkened by g
+uniform uint mode;
+uniform float max_iter;
+
+layout(binding = 1) uniform sampler1D palette;
+
+vec3 palette_color(vec2 it) {
+	if (mode == 2) {
+		return texelFetch(palette, int(it.r), 0).rgb;
+	}
+
+	// newton_shade() in newton.h
+	if (mode == 3) {
+		float shade = clamp(1.0 - log2(1.0 + max(it.g, 0.0)) / log2(1.0 + max_iter), 0.15, 1.0);
+		return texelFetch(palette, int(it.r), 0).rgb * shade;
+	}
+
+	if (it.g == -2.0) {
+		return vec3(1.0, 1.0, 1.0);
+	}
+
+	if (it.g < 0.0) {
+		return vec3(0.0, 0.0, 0.0);
+	}
+
+	// texel centers, so t = 0 and t = 1 hit the first and last entry exactly
+	float t = clamp((mode == 1 ? it.g : it.r) / max_iter, 0.0, 1.0);
+	float n = float(textureSize(palette, 0));
+	// explicit lod: the antialiasing loop is non-uniform control flow, where derivatives are undefined
+	return textureLod(palette, (t * (n - 1.0) + 0.5) / n, 0.0).rgb;
+}
@@ -0,0 +1,625 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "include/adaptive_aa.h"
+#include "include/buddhabrot.h"
+#include "include/escape_precise.h"
+#include "include/escape_time.h"
+#include "include/image_io.h"
+#include "include/newton.h"
+#include "include/palette.h"
+#include "include/perturbation.h"
+#include "include/render_farm.h"
+#include "include/subdivision.h"
+#include "include/thread_pool.h"
+
+// GPU-less counterpart of the mandelbrot / newton_fractal executables; writes one frame to a PPM file.
+//   cpu_render <mandelbrot|julia|newton|deep|buddhabrot> [options]
+//     --size W H       (default 1000 1000)
+//     --iter N         (default 50, 100 for newton, 1000 for deep / buddhabrot)
+//     --c RE IM        julia constant (default -0.5 0.0, what the GL view shows for init = (0, 0))
+//     --scale S        view scale (default 1.5 for mandelbrot / deep, 2.0 for julia, 1.0 for newton)
+//     --center RE IM   view center as decimal strings of any length (default -0.5 0, 0 0 for julia);
+//                      mandelbrot / julia keep up to quad-double of it, deep all of it
+//     --precision auto|float|double|dd|qd
+//                      arithmetic of mandelbrot / julia / newton; auto picks the narrowest one that
+//                      resolves a pixel at --scale (default auto; newton is at least double)
+//     --isa scalar|avx2|avx512
+//     --threads N      (default hardware_concurrency)
+//     --palette NAME   classic|fire|ice|grayscale for mandelbrot / julia / deep (default classic)
+//     --smooth         color by continuous iteration count; newton darkens slowly converging pixels
+//     --tolerance T    newton stops a pixel once a step is shorter than T, 0 runs all --iter steps (default 1e-6)
+//     --aa N           mandelbrot / julia / newton: supersample the pixels next to a band or basin boundary
+//                      with up to N (4 - 64) jittered samples each, fewer where they agree (default 0, off)
+//     --no-interior    mandelbrot / julia, untiled: iterate the interior to --iter instead of stopping it at the
+//                      cardioid / bulb / cycle checks; same image, for timing them
+//     --subdivide      mandelbrot / julia, untiled: Mariani-Silver subdivision, rectangles with a uniform border
+//                      are filled instead of computed (with --smooth only those that did not escape)
+//     --verify         --subdivide, then also render every pixel and fail if any count differs
+//     --samples N      buddhabrot: sampled c in total, over every run of a --checkpoint (default 1000000)
+//     --min-iter N     buddhabrot: draw only orbits that escape after at least N iterations (default 0)
+//     --anti           buddhabrot: draw the orbits that do not escape instead
+//     --uniform        buddhabrot: sample c uniformly instead of by Metropolis-Hastings
+//     --seed N         buddhabrot (default 1)
+//     --checkpoint PATH
+//                      buddhabrot: save the chains and the density to PATH every --checkpoint-every seconds and
+//                      at the end; a matching PATH is resumed
+//     --checkpoint-every S
+//                      (default 60)
+//     --out PATH       (default out.ppm)
+//     --tile N         mandelbrot / julia: render N x N tiles straight into a memory-mapped --out, a tiled
+//                      BigTIFF for .tif / .tiff, else PPM; an interrupted render resumes when run again
+//                      (default 256 with --farm / --worker / a .tif --out)
+//     --farm N         tiled, with the tiles rendered by N worker processes
+//     --worker CMD     one more worker, a shell command speaking the farm protocol on stdin / stdout,
+//                      e.g. "ssh node cpu_render farm-worker --threads 32"; may be repeated
+//     --farm-timeout S restart a worker that sent nothing for S seconds (default 600)
+//   cpu_render farm-worker [--threads N] [--isa ...]
+//                      worker process of --farm / --worker
+
+struct cli_options {
+    std::string_view fractal = "mandelbrot";
+    std::size_t width = 1000;
+    std::size_t height = 1000;
+    std::uint32_t max_iter = 0;
+    float c[2] = {-0.5f, 0.0f};
+    double scale = 0.0;
+    std::string_view center[2] = {"-0.5", "0"};
+    bool center_set = false;
+    std::optional<precision_level> precision;
+    escape_isa isa = detect_escape_isa();
+    std::size_t threads = std::thread::hardware_concurrency();
+    palette_preset palette = palette_preset::classic;
+    bool smooth = false;
+    std::optional<double> tolerance;
+    std::uint32_t aa = 0;
+    bool interior_checks = true;
+    bool subdivide = false;
+    bool verify = false;
+    std::uint64_t samples = 1000000;
+    std::uint32_t min_iter = 0;
+    bool anti = false;
+    bool uniform = false;
+    std::uint64_t seed = 1;
+    const char* checkpoint = nullptr;
+    double checkpoint_every = 60.0;
+    const char* out = "out.ppm";
+    std::size_t farm = 0;
+    std::vector<std::string> farm_commands;
+    std::chrono::seconds farm_timeout{600};
+    std::size_t tile = 256;
+    bool tiled = false;
+};
+
+cli_options parse_options(int argc, char** argv) {
+    cli_options opt;
+    if (argc > 1) opt.fractal = argv[1];
+
+    for (int i = 2; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        const auto need = [&](int n) {
+            if (i + n >= argc) {
+                std::cerr << "missing value for " << arg << std::endl;
+                std::exit(2);
+            }
+        };
+
+        if (arg == "--size") {
+            need(2);
+            opt.width = std::stoul(argv[++i]);
+            opt.height = std::stoul(argv[++i]);
+        } else if (arg == "--iter") {
+            need(1);
+            opt.max_iter = std::stoul(argv[++i]);
+        } else if (arg == "--c") {
+            need(2);
+            opt.c[0] = std::stof(argv[++i]);
+            opt.c[1] = std::stof(argv[++i]);
+        } else if (arg == "--scale") {
+            need(1);
+            opt.scale = std::stod(argv[++i]);
+        } else if (arg == "--center") {
+            need(2);
+            opt.center[0] = argv[++i];
+            opt.center[1] = argv[++i];
+            opt.center_set = true;
+        } else if (arg == "--precision") {
+            need(1);
+            const std::string_view p = argv[++i];
+            if (p == "auto") {
+                opt.precision.reset();
+            } else if (p == "float") {
+                opt.precision = precision_level::float32;
+            } else if (p == "double") {
+                opt.precision = precision_level::float64;
+            } else if (p == "dd") {
+                opt.precision = precision_level::double_double;
+            } else if (p == "qd") {
+                opt.precision = precision_level::quad_double;
+            } else {
+                std::cerr << "unknown precision: " << p << std::endl;
+                std::exit(2);
+            }
+        } else if (arg == "--isa") {
+            need(1);
+            const std::string_view isa = argv[++i];
+            if (isa == "scalar") {
+                opt.isa = escape_isa::scalar;
+            } else if (isa == "avx2") {
+                opt.isa = escape_isa::avx2;
+            } else if (isa == "avx512") {
+                opt.isa = escape_isa::avx512;
+            } else {
+                std::cerr << "unknown isa: " << isa << std::endl;
+                std::exit(2);
+            }
+        } else if (arg == "--threads") {
+            need(1);
+            opt.threads = std::stoul(argv[++i]);
+        } else if (arg == "--palette") {
+            need(1);
+            opt.palette = palette_preset_from_string(argv[++i]);
+        } else if (arg == "--smooth") {
+            opt.smooth = true;
+        } else if (arg == "--tolerance") {
+            need(1);
+            opt.tolerance = std::stod(argv[++i]);
+        } else if (arg == "--aa") {
+            need(1);
+            opt.aa = std::stoul(argv[++i]);
+        } else if (arg == "--no-interior") {
+            opt.interior_checks = false;
+        } else if (arg == "--subdivide") {
+            opt.subdivide = true;
+        } else if (arg == "--verify") {
+            opt.subdivide = true;
+            opt.verify = true;
+        } else if (arg == "--samples") {
+            need(1);
+            opt.samples = std::stoull(argv[++i]);
+        } else if (arg == "--min-iter") {
+            need(1);
+            opt.min_iter = std::stoul(argv[++i]);
+        } else if (arg == "--anti") {
+            opt.anti = true;
+        } else if (arg == "--uniform") {
+            opt.uniform = true;
+        } else if (arg == "--seed") {
+            need(1);
+            opt.seed = std::stoull(argv[++i]);
+        } else if (arg == "--checkpoint") {
+            need(1);
+            opt.checkpoint = argv[++i];
+        } else if (arg == "--checkpoint-every") {
+            need(1);
+            opt.checkpoint_every = std::stod(argv[++i]);
+        } else if (arg == "--out") {
+            need(1);
+            opt.out = argv[++i];
+        } else if (arg == "--farm") {
+            need(1);
+            opt.farm = std::stoul(argv[++i]);
+        } else if (arg == "--worker") {
+            need(1);
+            opt.farm_commands.emplace_back(argv[++i]);
+        } else if (arg == "--farm-timeout") {
+            need(1);
+            opt.farm_timeout = std::chrono::seconds(std::max(std::stol(argv[++i]), 1L));
+        } else if (arg == "--tile") {
+            need(1);
+            opt.tile = std::max<std::size_t>(std::stoul(argv[++i]), 1);
+            opt.tiled = true;
+        } else {
+            std::cerr << "unknown option: " << arg << std::endl;
+            std::exit(2);
+        }
+    }
+
+    if (mapped_layout_for(opt.out) == mapped_layout::tiff) opt.tiled = true;
+    return opt;
+}
+
+template <typename F>
+double measure(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void print_aa_stats(const aa_stats& stats, double elapsed, double render_elapsed) {
+    std::cout << "aa: " << 100.0 * stats.edge_fraction() << "% edge pixels, " << stats.mean_samples()
+              << " samples each, " << elapsed << " s (+" << 100.0 * elapsed / render_elapsed << "%)" << std::endl;
+}
+
+std::vector<std::array<float, 3>> render_escape(const cli_options& opt, work_stealing_pool& pool) {
+    const bool julia = opt.fractal == "julia";
+    escape_params param;
+    param.kind = julia ? fractal_kind::julia : fractal_kind::mandelbrot;
+    param.c[0] = opt.c[0];
+    param.c[1] = opt.c[1];
+    param.max_iter = opt.max_iter ? opt.max_iter : 50;
+    param.interior_checks = opt.interior_checks;
+
+    auto view = julia ? julia_default_view : mandelbrot_default_view;
+    auto precise = opt.center_set ? precise_view_from_strings(opt.center[0], opt.center[1], view.scale)
+                                  : to_precise_view(view);
+    if (opt.scale) precise.scale = opt.scale;
+    const auto precision = opt.precision.value_or(escape_precision(precise, opt.width, opt.height));
+    view.scale = static_cast<float>(precise.scale);
+    view.center[0] = static_cast<float>(precise.center[0][0]);
+    view.center[1] = static_cast<float>(precise.center[1][0]);
+
+    const auto isa = std::min(opt.isa, detect_escape_isa());
+    const auto kernel = select_escape_kernel(isa);
+    const auto wide_kernel = select_precise_kernel(precision, isa);
+    escape_buffer buf(opt.width, opt.height);
+
+    constexpr std::size_t band = 16;
+    const auto render_full = [&](escape_buffer& out) {
+        pool.parallel_for((out.height + band - 1) / band, [&](std::size_t i) {
+            const auto end = std::min((i + 1) * band, out.height);
+            if (precision == precision_level::float32) {
+                render_escape_time_rows(param, view, out, i * band, end, kernel);
+            } else {
+                render_precise_rows(param, precise, out, i * band, end, wide_kernel);
+            }
+        });
+    };
+    subdivision_options subdivision;
+    subdivision.interior_only = opt.smooth;
+    subdivision_stats subdivided;
+    const auto elapsed = measure([&] {
+        if (!opt.subdivide) {
+            render_full(buf);
+        } else if (precision == precision_level::float32) {
+            subdivided = render_escape_subdivided(param, view, buf, pool, kernel, subdivision);
+        } else {
+            subdivided = render_precise_subdivided(param, precise, buf, pool,
+                                                   select_precise_points_kernel(precision, isa), subdivision);
+        }
+    });
+
+    std::cout << "isa: " << escape_isa_to_string(isa) << std::endl
+              << "precision: " << precision_level_to_string(precision) << std::endl
+              << "threads: " << pool.size() << std::endl
+              << "time: " << elapsed << " s" << std::endl
+              << "pixels/s: " << static_cast<double>(opt.width * opt.height) / elapsed << std::endl;
+    if (param.interior_checks) {
+        const auto interior = count_interior(buf.interior);
+        std::cout << "interior: cardioid " << interior.cardioid << ", bulb " << interior.bulb << ", period "
+                  << interior.period << std::endl;
+    }
+    if (opt.subdivide) std::cout << "subdivision: " << 100.0 * subdivided.filled_fraction() << "% filled" << std::endl;
+    if (opt.verify) {
+        escape_buffer full(opt.width, opt.height);
+        const auto full_elapsed = measure([&] { render_full(full); });
+        const auto mismatches = subdivision_mismatches(buf, full);
+        std::cout << "verify: full render " << full_elapsed << " s, " << mismatches << " pixels differ" << std::endl;
+        if (mismatches) std::exit(1);
+    }
+
+    const palette_lut lut(palette_preset_stops(opt.palette));
+    auto rgb = colorize_escape_time(buf, param.max_iter, lut, opt.smooth);
+    if (opt.aa) {
+        std::vector<float> mu(buf.iter.size());
+        for (std::size_t i = 0; i < mu.size(); i++) mu[i] = smooth_iteration(buf.re[i], buf.im[i], buf.iter[i]);
+        const auto edges = aa_edges(buf.width, buf.height, [&](std::size_t i, std::size_t j) {
+            return aa_same_band(static_cast<float>(buf.iter[i]), mu[i], static_cast<float>(buf.iter[j]), mu[j],
+                                opt.smooth);
+        });
+
+        // the logarithms of smooth_iteration() only when they color
+        const auto color = [&](float re, float im, std::uint32_t iter) {
+            if (!(re * re + im * im > 4.0f)) return std::array<float, 3>{};
+            const float n = opt.smooth ? smooth_iteration(re, im, iter) : static_cast<float>(iter);
+            return lut.sample(n / static_cast<float>(param.max_iter));
+        };
+
+        // a batch of points at fractional pixel positions: in float gathered into escape_span::ys spans for the
+        // selected kernel like render_escape_subdivided(), else one at a time through the wide kernel on a 1 x 1
+        // tile of the image panned by the point
+        const auto w = static_cast<float>(buf.width);
+        const auto h = static_cast<float>(buf.height);
+        const auto m = static_cast<float>(std::min(buf.width, buf.height));
+        const auto sample = [&](const aa_point* points, std::size_t count, std::array<float, 3>* colors) {
+            if (precision == precision_level::float32) {
+                constexpr std::size_t chunk = 256;
+                float px[chunk], py[chunk], re[chunk], im[chunk];
+                std::uint32_t iter[chunk];
+                std::uint8_t interior[chunk];
+                for (std::size_t j = 0; j < count; j += chunk) {
+                    const auto len = std::min(chunk, count - j);
+                    for (std::size_t k = 0; k < len; k++) {
+                        const auto& p = points[j + k];
+                        px[k] = ((static_cast<float>(p.x) + p.dx + 0.5f) * 2.0f - w) / m * view.scale + view.center[0];
+                        py[k] = ((static_cast<float>(p.y) + p.dy + 0.5f) * 2.0f - h) / m * view.scale + view.center[1];
+                    }
+                    kernel(param, {px, 0.0f, len, re, im, iter, interior, py});
+                    for (std::size_t k = 0; k < len; k++) colors[j + k] = color(re[k], im[k], iter[k]);
+                }
+                return;
+            }
+            escape_buffer one(1, 1);
+            for (std::size_t i = 0; i < count; i++) {
+                auto v = precise;
+                v.pan[0] = static_cast<double>(points[i].x) + points[i].dx;
+                v.pan[1] = static_cast<double>(points[i].y) + points[i].dy;
+                v.frame[0] = buf.width;
+                v.frame[1] = buf.height;
+                wide_kernel(param, v, one, 0, 0, 1, 1);
+                colors[i] = color(one.re[0], one.im[0], one.iter[0]);
+            }
+        };
+
+        aa_stats stats;
+        const auto aa_elapsed = measure([&] {
+            stats = supersample_edges_batched(rgb, buf.width, buf.height, edges, sample, pool, opt.aa);
+        });
+        print_aa_stats(stats, aa_elapsed, elapsed);
+    }
+    // the float axis test is meaningless once float cannot resolve the view
+    if (!julia && precision == precision_level::float32) draw_escape_axes(rgb, buf.width, buf.height, view);
+    return rgb;
+}
+
+// supersampled like render_newton_tile computes a pixel, with the sample offset added to the pan
+template <typename T>
+aa_stats antialias_newton(const newton_params<T>& param, const newton_buffer& buf,
+                          std::vector<std::array<float, 3>>& rgb, const cli_options& opt, work_stealing_pool& pool) {
+    const auto edges =
+        aa_edges(buf.width, buf.height, [&](std::size_t i, std::size_t j) { return buf.root[i] == buf.root[j]; });
+    const auto a = newton_coefficients_as<std::complex<T>, 0>(newton_polynomial_coefficients(param));
+    const auto colors = newton_default_colors();
+    const auto sample = [&](std::size_t x, std::size_t y, float dx, float dy) {
+        const std::array<T, 2> pan = {param.pan[0] + T{dx}, param.pan[1] + T{dy}};
+        auto z = newton_pixel_to_plane(x, y, buf.width, buf.height, param.scale, pan);
+        float smooth = 0.0f;
+        newton_converge(z, a, param.max_iter, param.tolerance, &smooth);
+        auto c = colors[nearest_root(z, param.roots) % colors.size()];
+        const float s = opt.smooth ? newton_shade(smooth, param.max_iter) : 1.0f;
+        for (auto& v : c) v *= s;
+        return c;
+    };
+    return supersample_edges(rgb, buf.width, buf.height, edges, sample, pool, opt.aa);
+}
+
+std::vector<std::array<float, 3>> render_newton(const cli_options& opt, work_stealing_pool& pool) {
+    auto param = newton_default_params<double>();
+    if (opt.scale) param.scale = opt.scale;
+    if (opt.max_iter) param.max_iter = opt.max_iter;
+    if (opt.tolerance) param.tolerance = *opt.tolerance;
+
+    const auto isa = std::min(opt.isa, detect_escape_isa());
+    const auto precision = std::max(opt.precision.value_or(newton_precision(param, opt.width, opt.height)),
+                                    precision_level::float64);
+    newton_buffer buf(opt.width, opt.height);
+    const auto elapsed = measure([&] {
+        if (precision == precision_level::float64) {
+            render_newton(param, buf, pool, 32, isa);
+        } else if (precision == precision_level::double_double) {
+            render_newton(newton_params_cast<double_double<double>>(param), buf, pool, 32, isa);
+        } else {
+            render_newton(newton_params_cast<quad_double>(param), buf, pool, 32, isa);
+        }
+    });
+
+    std::cout << "isa: " << escape_isa_to_string(isa) << std::endl
+              << "precision: " << precision_level_to_string(precision) << std::endl
+              << "threads: " << pool.size() << std::endl
+              << "time: " << elapsed << " s" << std::endl
+              << "pixels/s: " << static_cast<double>(opt.width * opt.height) / elapsed << std::endl;
+
+    const auto stats = make_iteration_stats(buf.iter);
+    std::cout << "steps: mean " << stats.mean << ", p99 " << stats.p99 << ", max " << stats.max << std::endl;
+
+    auto rgb = opt.smooth ? colorize_newton(buf, newton_default_colors(), param.max_iter)
+                          : colorize_newton(buf, newton_default_colors());
+    if (opt.aa) {
+        aa_stats stats;
+        const auto aa_elapsed = measure([&] {
+            if (precision == precision_level::float64) {
+                stats = antialias_newton(param, buf, rgb, opt, pool);
+            } else if (precision == precision_level::double_double) {
+                stats = antialias_newton(newton_params_cast<double_double<double>>(param), buf, rgb, opt, pool);
+            } else {
+                stats = antialias_newton(newton_params_cast<quad_double>(param), buf, rgb, opt, pool);
+            }
+        });
+        print_aa_stats(stats, aa_elapsed, elapsed);
+    }
+    return rgb;
+}
+
+std::vector<std::array<float, 3>> render_deep(const cli_options& opt, work_stealing_pool& pool) {
+    const std::uint32_t max_iter = opt.max_iter ? opt.max_iter : 1000;
+    deep_view view;
+    if (opt.scale) view.scale = opt.scale;
+    const auto limbs = deep_limbs(view.scale, std::min(opt.width, opt.height));
+    view.center[0] = big_fixed::from_string(opt.center[0], limbs);
+    view.center[1] = big_fixed::from_string(opt.center[1], limbs);
+
+    reference_orbit ref;
+    const auto ref_elapsed = measure([&] { ref = compute_reference_orbit(view, opt.width, opt.height, max_iter); });
+
+    escape_buffer buf(opt.width, opt.height);
+    constexpr std::size_t band = 16;
+    const auto elapsed = measure([&] {
+        pool.parallel_for((buf.height + band - 1) / band, [&](std::size_t i) {
+            render_perturbation_rows(ref, view, max_iter, buf, i * band, std::min((i + 1) * band, buf.height));
+        });
+    });
+
+    std::cout << "reference: " << std::size(ref.z) << " iterations, " << limbs * 32 << " bits, " << ref_elapsed
+              << " s" << std::endl
+              << "series skip: " << ref.skip << std::endl
+              << "threads: " << pool.size() << std::endl
+              << "time: " << elapsed << " s" << std::endl
+              << "pixels/s: " << static_cast<double>(opt.width * opt.height) / elapsed << std::endl;
+
+    return colorize_escape_time(buf, max_iter, palette_lut(palette_preset_stops(opt.palette)), opt.smooth);
+}
+
+/**
+ * @brief orbit density of the mandelbrot view, in rounds between which --checkpoint is saved
+ */
+std::vector<std::array<float, 3>> render_buddhabrot(const cli_options& opt, work_stealing_pool& pool) {
+    buddhabrot_params param;
+    param.max_iter = opt.max_iter ? opt.max_iter : 1000;
+    param.min_iter = opt.min_iter;
+    param.anti = opt.anti;
+    param.metropolis = !opt.uniform;
+    param.seed = opt.seed;
+
+    auto view = mandelbrot_default_view;
+    if (opt.scale) view.scale = static_cast<float>(opt.scale);
+    if (opt.center_set) {
+        view.center[0] = std::stof(std::string(opt.center[0]));
+        view.center[1] = std::stof(std::string(opt.center[1]));
+    }
+
+    buddhabrot_renderer renderer(param, view, opt.width, opt.height, pool.size());
+    if (opt.checkpoint && renderer.load(opt.checkpoint)) {
+        std::cout << "resumed: " << renderer.samples() << " samples from " << opt.checkpoint << std::endl;
+    }
+    const auto before = renderer.samples();
+
+    bool saved = true;
+    double since_save = 0.0;
+    const auto round = static_cast<std::uint64_t>(pool.size()) * 16384;
+    const auto elapsed = measure([&] {
+        while (renderer.samples() < opt.samples) {
+            since_save += measure([&] { renderer.run(pool, std::min(round, opt.samples - renderer.samples())); });
+            saved = false;
+            if (opt.checkpoint && since_save >= opt.checkpoint_every) {
+                saved = renderer.save(opt.checkpoint, pool);
+                since_save = 0.0;
+            }
+        }
+    });
+    if (opt.checkpoint && !saved && !renderer.save(opt.checkpoint, pool)) {
+        std::cerr << "failed to write " << opt.checkpoint << std::endl;
+    }
+
+    const auto samples = static_cast<double>(renderer.samples());
+    std::cout << "mode: " << (param.anti ? "anti-buddhabrot" : "buddhabrot") << ", "
+              << (param.metropolis ? "metropolis" : "uniform") << std::endl
+              << "samples: " << renderer.samples() << std::endl;
+    if (param.metropolis) {
+        std::cout << "accepted: " << 100.0 * static_cast<double>(renderer.accepted()) / std::max(samples, 1.0) << "%"
+                  << std::endl;
+    }
+    std::cout << "threads: " << pool.size() << std::endl
+              << "time: " << elapsed << " s" << std::endl
+              << "samples/s: " << (samples - static_cast<double>(before)) / elapsed << std::endl;
+
+    return colorize_buddhabrot(renderer.density(pool), palette_lut(palette_preset_stops(opt.palette)));
+}
+
+farm_view make_farm_view(const cli_options& opt) {
+    const bool julia = opt.fractal == "julia";
+    farm_view view;
+    view.kind = julia ? fractal_kind::julia : fractal_kind::mandelbrot;
+    view.width = opt.width;
+    view.height = opt.height;
+    view.tile = opt.tile;
+    view.center[0] = opt.center_set ? opt.center[0] : julia ? "0" : "-0.5";
+    view.center[1] = opt.center_set ? opt.center[1] : "0";
+    view.scale = opt.scale ? opt.scale : julia ? 2.0 : 1.5;
+    view.max_iter = opt.max_iter ? opt.max_iter : 50;
+    view.c[0] = opt.c[0];
+    view.c[1] = opt.c[1];
+    view.precision = opt.precision.value_or(
+        escape_precision(precise_view_from_strings(view.center[0], view.center[1], view.scale), opt.width, opt.height));
+    view.smooth = opt.smooth;
+    return view;
+}
+
+/**
+ * @brief mandelbrot / julia tile by tile into a mapped --out, locally or on the farm; resumes a partial --out
+ */
+int render_tiled(const cli_options& opt) {
+    if (opt.fractal != "mandelbrot" && opt.fractal != "julia") {
+        std::cerr << "tiled output renders mandelbrot and julia only" << std::endl;
+        return 1;
+    }
+
+    const auto view = make_farm_view(opt);
+    const palette_lut lut(palette_preset_stops(opt.palette));
+    mapped_image image;
+    if (!image.open(opt.out, view.width, view.height, view.tile, mapped_layout_for(opt.out),
+                    farm_view_to_string(view))) {
+        return 1;
+    }
+    const auto before = image.done();
+    std::cout << "precision: " << precision_level_to_string(view.precision) << std::endl
+              << "tiles: " << view.tile_count() << ", " << before << " done already" << std::endl;
+
+    bool ok = true;
+    double elapsed = 0.0;
+    if (opt.farm || !opt.farm_commands.empty()) {
+        farm_options farm;
+        farm.workers = opt.farm;
+        farm.commands = opt.farm_commands;
+        farm.timeout = opt.farm_timeout;
+        farm.threads_per_worker = std::max<std::size_t>(opt.threads / std::max<std::size_t>(opt.farm, 1), 1);
+        std::cout << "workers: " << farm.workers << " local x " << farm.threads_per_worker << " threads, "
+                  << farm.commands.size() << " commands" << std::endl;
+        elapsed = measure([&] { ok = run_farm_tiles(view, farm, image, lut); });
+    } else {
+        work_stealing_pool pool(opt.threads);
+        const auto isa = std::min(opt.isa, detect_escape_isa());
+        std::cout << "isa: " << escape_isa_to_string(isa) << std::endl << "threads: " << pool.size() << std::endl;
+        elapsed = measure([&] {
+            for (std::size_t i = 0; i < view.tile_count(); i++) {
+                if (!image.done(i)) write_farm_tile(image, view, i, render_farm_tile(view, i, pool, isa), lut);
+            }
+        });
+    }
+
+    const auto rendered = static_cast<double>(view.tile_count() - before) / static_cast<double>(view.tile_count());
+    std::cout << "time: " << elapsed << " s" << std::endl
+              << "pixels/s: " << rendered * static_cast<double>(opt.width * opt.height) / elapsed << std::endl;
+    if (!image.close() || !ok) {
+        std::cerr << "incomplete " << opt.out << ", run again to resume" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const auto opt = parse_options(argc, argv);
+    if (opt.aa && (opt.tiled || opt.farm || !opt.farm_commands.empty() || opt.fractal == "deep")) {
+        std::cerr << "--aa is ignored: only untiled mandelbrot / julia / newton renders are antialiased" << std::endl;
+    }
+    if (opt.tiled || opt.farm || !opt.farm_commands.empty()) return render_tiled(opt);
+    work_stealing_pool pool(opt.threads);
+
+    if (opt.fractal == "farm-worker") return run_farm_worker(0, 1, pool, std::min(opt.isa, detect_escape_isa()));
+
+    std::vector<std::array<float, 3>> rgb;
+    if (opt.fractal == "mandelbrot" || opt.fractal == "julia") {
+        rgb = render_escape(opt, pool);
+    } else if (opt.fractal == "newton") {
+        rgb = render_newton(opt, pool);
+    } else if (opt.fractal == "deep") {
+        rgb = render_deep(opt, pool);
+    } else if (opt.fractal == "buddhabrot") {
+        rgb = render_buddhabrot(opt, pool);
+    } else {
+        std::cerr << "unknown fractal: " << opt.fractal << std::endl;
+        std::exit(1);
+    }
+
+    if (!write_ppm(opt.out, opt.width, opt.height, rgb)) {
+        std::cerr << "failed to write " << opt.out << std::endl;
+        std::exit(1);
+    }
+}
@@ -4,22 +4,189 @@
 #include <backends/imgui_impl_opengl3.h>
 #include <imgui.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
 #include <iostream>
 #include <iterator>
+#include <numbers>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <tuple>
 #include <vector>
 
+#include "include/animation_path.h"
+#include "include/interior_counter.h"
+#include "include/julia_atlas.h"
+#include "include/offscreen.h"
+#include "include/palette.h"
+#include "include/palette_pass.h"
+#include "include/perturbation.h"
+#include "include/profiler_overlay.h"
+#include "include/program_cache.h"
+#include "include/redraw.h"
+#include "include/scroll_cache.h"
+#include "include/shader_variants.h"
+#include "include/tile_cache.h"
 #include "include/utils.h"
 
 constexpr std::pair glfw_winsize = {1000, 1000};
 
-int main() {
+// Batch mode: same two panes as the window; frame i puts the julia init at angle 2 pi i / frames
+// on a circle of radius 0.5 instead of following the mouse. With --path the mandelbrot pane follows the
+// keyframed center / scale through the perturbation shader and the julia pane the keyframed init.
+int main_headless(const headless_options& opt) {
+    auto context = egl_headless_context::create();
+    if (!context || !init_glew_headless()) std::exit(1);
+
+    std::optional<std::vector<animation_key>> keys;
+    if (!opt.path.empty() && !(keys = load_animation_path(opt.path))) std::exit(1);
+    const auto frames = opt.frames ? opt.frames : keys ? animation_length(*keys) : 1;
+
+    print_gl_info();
+    glEnable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(print_debug_message, nullptr);
+
+    program_cache programs;
+    const std::vector<std::string_view> aa_libraries = {embedded_palette_color_glsl, embedded_antialias_glsl};
+    program_variants mandelbrot_variants(programs, embedded_mandelbrot_vert, embedded_mandelbrot_frag, aa_libraries);
+    program_variants julia_variants(programs, embedded_julia_vert, embedded_julia_frag, aa_libraries);
+    const auto mandelbrot_program = mandelbrot_variants.get();
+    const auto julia_program = julia_variants.get();
+    const shader_defines aa_variant = {{"AA_SAMPLES", std::to_string(opt.aa)}};
+    const auto mandelbrot_aa_program = opt.aa && !keys ? mandelbrot_variants.get(aa_variant) : 0;
+    const auto julia_aa_program = opt.aa ? julia_variants.get(aa_variant) : 0;
+    const auto [mandelbrot_vao, mandelbrot_vao_len] = create_quad_vao(mandelbrot_program);
+    const auto [julia_vao, julia_vao_len] = create_quad_vao(julia_program);
+    program_variants mandelbrot_deep_variants(programs, embedded_mandelbrot_vert, embedded_mandelbrot_deep_frag);
+    const auto mandelbrot_deep_program = keys ? mandelbrot_deep_variants.get() : 0;
+    program_variants palette_variants(programs, embedded_mandelbrot_vert, embedded_palette_frag,
+                                      {embedded_palette_color_glsl});
+    const auto palette_program = palette_variants.get();
+    programs.print_stats();
+
+    frame_cache iterations(GL_RG32F);
+    iterations.resize(opt.width, opt.height);
+    palette_texture palette;
+    palette.upload(palette_lut(palette_preset_stops(palette_preset::classic)).colors());
+
+    GLuint orbit_ssbo;
+    glCreateBuffers(1, &orbit_ssbo);
+    interior_counter interior;
+
+    // the reference orbit of frame i + 1 is computed on another thread while frame i renders
+    const auto reference = [&](std::size_t frame) {
+        const auto f = sample_animation(*keys, frame);
+        deep_view view;
+        view.center[0] = f.center[0];
+        view.center[1] = f.center[1];
+        view.scale = f.scale;
+        return compute_reference_orbit(view, opt.width / 2, opt.height, f.max_iter);
+    };
+    std::future<reference_orbit> next_ref;
+    if (keys) next_ref = std::async(std::launch::async, reference, 0);
+
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+
+    const auto ret = run_headless(opt, frames, [&](std::size_t frame, int width, int height) {
+        const double angle = 2.0 * std::numbers::pi * frame / frames;
+        float init[2] = {static_cast<float>(0.5 * std::cos(angle)), static_cast<float>(0.5 * std::sin(angle))};
+        animation_frame path;
+        reference_orbit ref;
+        if (keys) {
+            path = sample_animation(*keys, frame);
+            init[0] = static_cast<float>(path.init[0]);
+            init[1] = static_cast<float>(path.init[1]);
+            ref = next_ref.get();
+            if (frame + 1 < frames) next_ref = std::async(std::launch::async, reference, frame + 1);
+        }
+
+        GLint target;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
+        iterations.bind();
+        interior.begin_frame();
+
+        glViewport(0, 0, width / 2, height);
+        if (keys) {
+            glNamedBufferData(orbit_ssbo, std::size(ref.z) * sizeof(decltype(ref.z)::value_type), std::data(ref.z),
+                              GL_STREAM_DRAW);
+            glUseProgram(mandelbrot_deep_program);
+            glUniform2f(glGetUniformLocation(mandelbrot_deep_program, "winsize"), width / 2.0, height);
+            glUniform1d(glGetUniformLocation(mandelbrot_deep_program, "scale"), path.scale);
+            glUniform1ui(glGetUniformLocation(mandelbrot_deep_program, "max_iter"), path.max_iter);
+            glUniform1ui(glGetUniformLocation(mandelbrot_deep_program, "skip"), ref.skip);
+            glUniform2dv(glGetUniformLocation(mandelbrot_deep_program, "series"), std::size(ref.series),
+                         reinterpret_cast<const GLdouble*>(std::data(ref.series)));
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, orbit_ssbo);
+        } else {
+            glUseProgram(mandelbrot_program);
+            glUniform2f(glGetUniformLocation(mandelbrot_program, "winsize"), width / 2.0, height);
+        }
+        glBindVertexArray(mandelbrot_vao);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, mandelbrot_vao_len);
+
+        glViewport(width / 2, 0, width / 2, height);
+        glUseProgram(julia_program);
+        glUniform2f(glGetUniformLocation(julia_program, "winsize"), width / 2.0, height);
+        glUniform2f(glGetUniformLocation(julia_program, "init"), init[0], init[1]);
+        glBindVertexArray(julia_vao);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, julia_vao_len);
+        glBindVertexArray(0);
+        glUseProgram(0);
+        interior.end_frame(true);
+
+        // a zoom path colors by the smooth count so that bands do not flicker from frame to frame
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        const auto mode = keys ? palette_mode::smooth : palette_mode::iteration;
+        glViewport(0, 0, width / 2, height);
+        draw_palette_pass(palette_program, mandelbrot_vao, mandelbrot_vao_len, iterations.texture(), palette, mode,
+                          keys ? static_cast<float>(path.max_iter) : 50.0f);
+        glViewport(width / 2, 0, width / 2, height);
+        draw_palette_pass(palette_program, julia_vao, julia_vao_len, iterations.texture(), palette, mode, 50.0f);
+
+        // the deep zoom pane has no antialiasing variant
+        if (mandelbrot_aa_program) {
+            glViewport(0, 0, width / 2, height);
+            glUseProgram(mandelbrot_aa_program);
+            glUniform2f(glGetUniformLocation(mandelbrot_aa_program, "winsize"), width / 2.0, height);
+            draw_antialias_pass(mandelbrot_aa_program, mandelbrot_vao, mandelbrot_vao_len, iterations.texture(),
+                                palette, mode, 50.0f);
+        }
+        if (julia_aa_program) {
+            glViewport(width / 2, 0, width / 2, height);
+            glUseProgram(julia_aa_program);
+            glUniform2f(glGetUniformLocation(julia_aa_program, "winsize"), width / 2.0, height);
+            glUniform2f(glGetUniformLocation(julia_aa_program, "init"), init[0], init[1]);
+            draw_antialias_pass(julia_aa_program, julia_vao, julia_vao_len, iterations.texture(), palette, mode,
+                                50.0f);
+        }
+    });
+
+    interior.finish();
+    const auto& counts = interior.total();
+    std::cout << "interior: cardioid " << counts.cardioid << ", bulb " << counts.bulb << ", period " << counts.period
+              << std::endl;
+
+    glDeleteBuffers(1, &orbit_ssbo);
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    const auto headless = parse_headless_options(argc, argv);
+    if (headless.enabled) return main_headless(headless);
+
     if (!glfwInit()) std::exit(1);
+    const glfw_terminate_guard glfw_guard;
     glfwSetErrorCallback([](int ec, const char* desc) { std::cerr << "ec: " << ec << "desc: " << desc << std::endl; });
+    // the frame cache is blitted to the window, which a multisampled default framebuffer would refuse;
+    // antialiasing is the adaptive pass instead
+    glfwWindowHint(GLFW_SAMPLES, 0);
     auto* window = glfwCreateWindow(glfw_winsize.first, glfw_winsize.second, "GLFW", nullptr, nullptr);
 
     if (!window) {
@@ -28,7 +195,6 @@ int main() {
     }
 
     glfwMakeContextCurrent(window);
-    glfwWindowHint(GLFW_SAMPLES, 8);
 
     if (!glewInit()) {
         glfwTerminate();
@@ -45,137 +211,433 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 460");
 
-    std::cout << "OpenGL Version:" << glGetString(GL_VERSION) << std::endl;
-    std::cout << "Vendor:" << glGetString(GL_VENDOR) << std::endl;
-    std::cout << "Renderer:" << glGetString(GL_RENDERER) << std::endl;
+    print_gl_info();
     glEnable(GL_DEBUG_OUTPUT);
-    glDebugMessageCallback(
-        [](GLenum source, GLenum type, GLuint id, GLenum severity, [[maybe_unused]] GLsizei length,
-           const GLchar* message, [[maybe_unused]] const void* userParam) {
-            std::cerr << "-----glDebugMessageCallback-----" << std::endl
-                      << "source: " << source << std::endl
-                      << "type: " << type << std::endl
-                      << "id: " << id << std::endl
-                      << "severity: " << severity << std::endl
-                      << "message: " << message << std::endl;
-        },
-        nullptr);
-
-    auto [mandelbrot_program, mandelbrot_vao, mandelbrot_vao_len] = []() {
-        auto vsrc = read_file("shader/mandelbrot.vert").value();
-        auto fsrc = read_file("shader/mandelbrot.frag").value();
-
-        auto program = create_program(vsrc.data(), fsrc.data()).value();
-
-        auto in_location = glGetAttribLocation(program, "position");
-        std::vector<Vertex> vertexes;
-        vertexes.emplace_back(-1.0, -1.0);
-        vertexes.emplace_back(-1.0, 1.0);
-        vertexes.emplace_back(1.0, 1.0);
-        vertexes.emplace_back(1.0, -1.0);
-
-        GLuint vbo;
-        glCreateBuffers(1, &vbo);
-
-        glNamedBufferData(vbo, std::size(vertexes) * sizeof(decltype(vertexes)::value_type), std::data(vertexes),
-                          GL_STATIC_DRAW);
-
-        GLuint vao;
-        glCreateVertexArrays(1, &vao);
-        glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
-        glVertexArrayAttribFormat(vao, in_location, 2, GL_FLOAT, GL_FALSE, 0);
-        glEnableVertexArrayAttrib(vao, in_location);
-        glVertexArrayAttribBinding(vao, in_location, 0);
-
-        return std::tuple{program, vao, std::size(vertexes)};
-    }();
-
-    auto [julia_program, julia_vao, julia_vao_len] = []() {
-        auto vsrc = read_file("shader/julia.vert").value();
-        auto fsrc = read_file("shader/julia.frag").value();
-
-        auto program = create_program(vsrc.data(), fsrc.data()).value();
-
-        auto in_location = glGetAttribLocation(program, "position");
-        std::vector<Vertex> vertexes;
-        vertexes.emplace_back(-1.0, -1.0);
-        vertexes.emplace_back(-1.0, 1.0);
-        vertexes.emplace_back(1.0, 1.0);
-        vertexes.emplace_back(1.0, -1.0);
-
-        GLuint vbo;
-        glCreateBuffers(1, &vbo);
-
-        glNamedBufferData(vbo, std::size(vertexes) * sizeof(decltype(vertexes)::value_type), std::data(vertexes),
-                          GL_STATIC_DRAW);
-
-        GLuint vao;
-        glCreateVertexArrays(1, &vao);
-        glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
-        glVertexArrayAttribFormat(vao, in_location, 2, GL_FLOAT, GL_FALSE, 0);
-        glEnableVertexArrayAttrib(vao, in_location);
-        glVertexArrayAttribBinding(vao, in_location, 0);
-
-        return std::tuple{program, vao, std::size(vertexes)};
-    }();
+    glDebugMessageCallback(print_debug_message, nullptr);
+
+    // every iteration cap / precision pair is linked up front so the settings never stall on a compile;
+    // the variants without interior checks only when they are first switched off
+    const char* const iteration_labels[] = {"50", "100", "200", "500", "1000"};
+    const std::vector<std::uint32_t> iteration_caps = {50, 100, 200, 500, 1000};
+    const auto escape_defines = [](std::uint32_t max_iter, bool use_double, bool interior_checks) -> shader_defines {
+        return {{"MAX_ITER", std::to_string(max_iter)},
+                {"USE_DOUBLE", use_double ? "1" : "0"},
+                {"INTERIOR_CHECKS", interior_checks ? "1" : "0"}};
+    };
+    std::vector<shader_defines> escape_variants;
+    for (const auto cap : iteration_caps) {
+        for (const auto use_double : {false, true}) escape_variants.push_back(escape_defines(cap, use_double, true));
+    }
+
+    // antialiasing variants are linked when first switched on
+    const char* const aa_labels[] = {"off", "4", "16", "64"};
+    const std::uint32_t aa_caps[] = {0, 4, 16, 64};
+    const auto aa_defines = [](shader_defines defines, std::uint32_t samples) {
+        defines.emplace_back("AA_SAMPLES", std::to_string(samples));
+        return defines;
+    };
+
+    program_cache programs;
+    const std::vector<std::string_view> aa_libraries = {embedded_palette_color_glsl, embedded_antialias_glsl};
+    program_variants mandelbrot_variants(programs, embedded_mandelbrot_vert, embedded_mandelbrot_frag, aa_libraries);
+    program_variants julia_variants(programs, embedded_julia_vert, embedded_julia_frag, aa_libraries);
+    mandelbrot_variants.prebuild(escape_variants);
+    julia_variants.prebuild(escape_variants);
+    const auto [mandelbrot_vao, mandelbrot_vao_len] = create_quad_vao(mandelbrot_variants.get());
+    const auto [julia_vao, julia_vao_len] = create_quad_vao(julia_variants.get());
+
+    // perturbation deep zoom, same quad as the normal mandelbrot pass
+    program_variants mandelbrot_deep_variants(programs, embedded_mandelbrot_vert, embedded_mandelbrot_deep_frag);
+    const auto mandelbrot_deep_program = mandelbrot_deep_variants.get();
+
+    // second pass, colors both panes from the iteration buffer
+    program_variants palette_variants(programs, embedded_mandelbrot_vert, embedded_palette_frag,
+                                      {embedded_palette_color_glsl});
+    const auto palette_program = palette_variants.get();
+    programs.print_stats();
+
+    GLuint orbit_ssbo;
+    glCreateBuffers(1, &orbit_ssbo);
+    interior_counter interior;
 
     glClearColor(0.0, 0.0, 0.0, 1.0);
 
     float init[2] = {};
+    int iteration_index = 0;
+    bool use_double = false;
+    bool interior_checks = true;
+
+    bool deep_zoom = false;
+    int deep_iter = 1000;
+    deep_view view;
+    reference_orbit ref;
+    bool ref_dirty = true;
+    int ref_winsize[2] = {};
+    std::size_t ref_version = 0;
+
+    int palette_index = 0;
+    auto stops = palette_preset_stops(palette_preset::classic);
+    bool smooth = false;
+    palette_texture palette;
+    int aa_index = 0;
+
+    // left drag pans the mandelbrot pane; a pan only draws the strips it exposes
+    drag_pan drag;
+    std::array<int, 2> mandelbrot_pan{};
+
+    // tile cache mode: the mandelbrot pane is composed on the CPU from a quadtree of cached tiles, so zooming
+    // back out or revisiting a place is free; evicted tiles go to a file next to the program cache, opened the
+    // first time the mode is switched on and sized to spill_factor times the memory budget at that point
+    bool use_tiles = false;
+    bool spill_opened = false;
+    constexpr std::size_t spill_factor = 4;
+    int tile_budget_mib = 256;
+    tile_cache tiles(static_cast<std::size_t>(tile_budget_mib) << 20);
+    tile_browser browser(tiles, tile_format::smooth_half);
+    browser.on_ready = [] { glfwPostEmptyEvent(); };
+    tile_view tiles_view;
+    std::array<int, 2> tiles_pan{};
+    std::vector<std::array<float, 2>> tile_texels;
+
+    // julia atlas mode: the julia pane shows blended low resolution renders from a grid of c at once, and the
+    // exact pane once the atlas threads have rendered it; both on the CPU, in float
+    bool use_atlas = false;
+    bool atlas_blend = true;
+    julia_atlas atlas;
+    atlas.on_ready = [] { glfwPostEmptyEvent(); };
+    std::vector<std::array<float, 2>> julia_texels;
+
+    // Each pane's iterations are recomputed only when its inputs change, and recolored from the iteration
+    // buffer only when they or the palette change; idle frames just blit the cache.
+    frame_cache cache;
+    frame_cache iterations(GL_RG32F);
+    dirty_state<int, int, int, bool, bool, bool, std::size_t> mandelbrot_dirty;
+    dirty_state<int, int, int, double, double, double, std::size_t> tiles_dirty;
+    dirty_state<int, int, int, bool, bool, float, float> julia_dirty;
+    dirty_state<int, int, int, bool, bool, float, float, std::size_t> atlas_dirty;
+    dirty_state<palette_stops, bool, int> palette_dirty;
+    redraw_scheduler scheduler;
+    frame_profiler profiler;
+    bool show_profiler = false;
 
     while (!glfwWindowShouldClose(window)) {
-        glClear(GL_COLOR_BUFFER_BIT);
-
+        profiler.begin_frame();
         int winsize[2];
         glfwGetWindowSize(window, &winsize[0], &winsize[1]);
+        if (cache.resize(winsize[0], winsize[1]) | iterations.resize(winsize[0], winsize[1])) {
+            mandelbrot_dirty.invalidate();
+            tiles_dirty.invalidate();
+            julia_dirty.invalidate();
+        }
 
         double mouse[2];
         glfwGetCursorPos(window, &mouse[0], &mouse[1]);
+        const double mouse_px[2] = {mouse[0], mouse[1]};
         mouse[0] = (2.0 * mouse[0] - winsize[0]) / winsize[0];
         mouse[1] = (-2.0 * mouse[1] + winsize[1]) / winsize[1];
 
-        glViewport(0, 0, winsize[0] / 2, winsize[1]);
-        glUseProgram(mandelbrot_program);
-        glUniform2f(glGetUniformLocation(mandelbrot_program, "winsize"), winsize[0] / 2.0, winsize[1]);
-        glBindVertexArray(mandelbrot_vao);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, mandelbrot_vao_len);
-        glBindVertexArray(0);
-        glUseProgram(0);
+        if (deep_zoom && (ref_dirty || ref_winsize[0] != winsize[0] || ref_winsize[1] != winsize[1])) {
+            const auto timer = profiler.pass("reference orbit", false);
+            ref = compute_reference_orbit(view, winsize[0] / 2, winsize[1], deep_iter);
+            glNamedBufferData(orbit_ssbo, std::size(ref.z) * sizeof(decltype(ref.z)::value_type), std::data(ref.z),
+                              GL_STATIC_DRAW);
+            ref_dirty = false;
+            ref_winsize[0] = winsize[0];
+            ref_winsize[1] = winsize[1];
+            ref_version++;
+        }
+
+        iterations.bind();
+        interior.begin_frame();
+        bool mandelbrot_changed = false;
+        bool julia_changed = false;
+
+        const auto variant = escape_defines(iteration_caps[iteration_index], use_double, interior_checks);
+        const pixel_rect mandelbrot_area = {0, 0, winsize[0] / 2, winsize[1]};
+        std::vector<pixel_rect> mandelbrot_rects;
+        if (use_tiles && !spill_opened) {
+            spill_opened = true;
+            if (const auto dir = default_program_cache_dir(); !dir.empty()) {
+                std::error_code ec;
+                std::filesystem::create_directories(dir, ec);
+                const auto bytes = spill_factor * (static_cast<std::size_t>(tile_budget_mib) << 20);
+                if (!tiles.enable_spill((dir / "tiles.bin").string(), bytes)) {
+                    std::cerr << "tile cache: no spill file in " << dir << std::endl;
+                }
+            }
+        }
+        if (use_tiles && !deep_zoom) {
+            // the GPU pass is drawn again in full once the tile mode is left
+            mandelbrot_dirty.invalidate();
+            if (tiles_dirty.update(winsize[0], winsize[1], iteration_index, tiles_view.scale, tiles_view.center[0],
+                                   tiles_view.center[1], browser.generation())) {
+                const auto timer = profiler.pass("tiles", false);
+                escape_params param;
+                param.max_iter = iteration_caps[iteration_index];
+                param.interior_checks = interior_checks;
+                browser.compose(param, tiles_view, winsize[0] / 2, winsize[1], tile_texels);
+                glTextureSubImage2D(iterations.texture(), 0, 0, 0, winsize[0] / 2, winsize[1], GL_RG, GL_FLOAT,
+                                    tile_texels.data());
+                mandelbrot_changed = true;
+            }
+        } else if (mandelbrot_dirty.update(winsize[0], winsize[1], iteration_index, use_double, interior_checks,
+                                           deep_zoom, ref_version)) {
+            mandelbrot_rects = {mandelbrot_area};
+        } else if (!deep_zoom && drag.pan != mandelbrot_pan) {
+            const int dx = mandelbrot_pan[0] - drag.pan[0];
+            const int dy = mandelbrot_pan[1] - drag.pan[1];
+            iterations.scroll(mandelbrot_area, dx, dy);
+            mandelbrot_rects = exposed_strips(mandelbrot_area, dx, dy);
+        }
+        if (!mandelbrot_rects.empty()) {
+            const auto timer = profiler.pass("mandelbrot");
+            const auto mandelbrot_program = mandelbrot_variants.get(variant);
+            glViewport(0, 0, winsize[0] / 2, winsize[1]);
+            if (deep_zoom) {
+                glUseProgram(mandelbrot_deep_program);
+                glUniform2f(glGetUniformLocation(mandelbrot_deep_program, "winsize"), winsize[0] / 2.0, winsize[1]);
+                glUniform1d(glGetUniformLocation(mandelbrot_deep_program, "scale"), view.scale);
+                glUniform1ui(glGetUniformLocation(mandelbrot_deep_program, "max_iter"), deep_iter);
+                glUniform1ui(glGetUniformLocation(mandelbrot_deep_program, "skip"), ref.skip);
+                glUniform2dv(glGetUniformLocation(mandelbrot_deep_program, "series"), std::size(ref.series),
+                             reinterpret_cast<const GLdouble*>(std::data(ref.series)));
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, orbit_ssbo);
+            } else {
+                glUseProgram(mandelbrot_program);
+                glUniform2f(glGetUniformLocation(mandelbrot_program, "winsize"), winsize[0] / 2.0, winsize[1]);
+                glUniform2f(glGetUniformLocation(mandelbrot_program, "pan"), drag.pan[0], drag.pan[1]);
+                mandelbrot_pan = drag.pan;
+            }
+            glBindVertexArray(mandelbrot_vao);
+            glEnable(GL_SCISSOR_TEST);
+            for (const auto& r : mandelbrot_rects) {
+                glScissor(r.x, r.y, r.width, r.height);
+                glDrawArrays(GL_TRIANGLE_FAN, 0, mandelbrot_vao_len);
+            }
+            glDisable(GL_SCISSOR_TEST);
+            glBindVertexArray(0);
+            glUseProgram(0);
+            mandelbrot_changed = true;
+        }
 
-        glViewport(winsize[0] / 2, 0, winsize[0] / 2, winsize[1]);
-        glUseProgram(julia_program);
-        glUniform2f(glGetUniformLocation(julia_program, "winsize"), winsize[0] / 2.0, winsize[1]);
         init[0] = mouse[0] * 2 + 1;
         init[1] = mouse[1];
-        glUniform2f(glGetUniformLocation(julia_program, "init"), init[0], init[1]);
-        glBindVertexArray(julia_vao);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, julia_vao_len);
-        glBindVertexArray(0);
-        glUseProgram(0);
-
-        glViewport(0, 0, winsize[0], winsize[1]);
+        bool julia_drawn = false;
+        if (use_atlas) {
+            // the GPU pass is drawn again in full once the atlas is switched off
+            julia_dirty.invalidate();
+            if (atlas_dirty.update(winsize[0], winsize[1], iteration_index, interior_checks, atlas_blend, init[0],
+                                   init[1], atlas.generation())) {
+                const auto timer = profiler.pass("julia atlas", false);
+                const auto c = julia_constant(init[0], init[1]);
+                escape_params param;
+                param.kind = fractal_kind::julia;
+                param.c[0] = c[0];
+                param.c[1] = c[1];
+                param.max_iter = iteration_caps[iteration_index];
+                param.interior_checks = interior_checks;
+                atlas.build(param);
+                const auto w = static_cast<std::size_t>(winsize[0] / 2);
+                const auto h = static_cast<std::size_t>(winsize[1]);
+                // the exact pane once it is done, the atlas until then; with neither the last pane stays up
+                if (atlas.exact(param, w, h, julia_texels) || atlas.preview(c, w, h, atlas_blend, julia_texels)) {
+                    glTextureSubImage2D(iterations.texture(), 0, winsize[0] / 2, 0, winsize[0] / 2, winsize[1], GL_RG,
+                                        GL_FLOAT, julia_texels.data());
+                    julia_changed = true;
+                }
+            }
+        } else {
+            atlas_dirty.invalidate();
+        }
+        if (!use_atlas && julia_dirty.update(winsize[0], winsize[1], iteration_index, use_double, interior_checks,
+                                             init[0], init[1])) {
+            const auto timer = profiler.pass("julia");
+            const auto julia_program = julia_variants.get(variant);
+            glViewport(winsize[0] / 2, 0, winsize[0] / 2, winsize[1]);
+            glUseProgram(julia_program);
+            glUniform2f(glGetUniformLocation(julia_program, "winsize"), winsize[0] / 2.0, winsize[1]);
+            glUniform2f(glGetUniformLocation(julia_program, "init"), init[0], init[1]);
+            glBindVertexArray(julia_vao);
+            glDrawArrays(GL_TRIANGLE_FAN, 0, julia_vao_len);
+            glBindVertexArray(0);
+            glUseProgram(0);
+            julia_changed = true;
+            julia_drawn = true;
+        }
+        // the tile cache, deep zoom and atlas passes count nothing, but a GPU pass drawn with them does
+        interior.end_frame(!mandelbrot_rects.empty() || julia_drawn);
+
+        const bool palette_changed = palette_dirty.update(stops, smooth, aa_index);
+        if (palette_changed) palette.upload(palette_lut(stops).colors());
+
+        cache.bind();
+        const auto mode = smooth ? palette_mode::smooth : palette_mode::iteration;
+        if (mandelbrot_changed || julia_changed || palette_changed) {
+            const auto timer = profiler.pass("palette");
+            if (mandelbrot_changed || palette_changed) {
+                glViewport(0, 0, winsize[0] / 2, winsize[1]);
+                const auto max_iter = deep_zoom ? deep_iter : iteration_caps[iteration_index];
+                draw_palette_pass(palette_program, mandelbrot_vao, mandelbrot_vao_len, iterations.texture(), palette,
+                                  mode, static_cast<float>(max_iter));
+            }
+            if (julia_changed || palette_changed) {
+                glViewport(winsize[0] / 2, 0, winsize[0] / 2, winsize[1]);
+                draw_palette_pass(palette_program, julia_vao, julia_vao_len, iterations.texture(), palette, mode,
+                                  static_cast<float>(iteration_caps[iteration_index]));
+            }
+        }
+        // recolors the edge pixels of the panes just colored; the deep zoom, tile cache and atlas passes have no
+        // variant
+        if (aa_caps[aa_index] && (mandelbrot_changed || julia_changed || palette_changed)) {
+            const auto timer = profiler.pass("antialias");
+            const auto aa_variant = aa_defines(variant, aa_caps[aa_index]);
+            const auto max_iter = static_cast<float>(iteration_caps[iteration_index]);
+            if ((mandelbrot_changed || palette_changed) && !deep_zoom && !use_tiles) {
+                const auto program = mandelbrot_variants.get(aa_variant);
+                glViewport(0, 0, winsize[0] / 2, winsize[1]);
+                glUseProgram(program);
+                glUniform2f(glGetUniformLocation(program, "winsize"), winsize[0] / 2.0, winsize[1]);
+                glUniform2f(glGetUniformLocation(program, "pan"), mandelbrot_pan[0], mandelbrot_pan[1]);
+                draw_antialias_pass(program, mandelbrot_vao, mandelbrot_vao_len, iterations.texture(), palette, mode,
+                                    max_iter);
+            }
+            if ((julia_changed || palette_changed) && !use_atlas) {
+                const auto program = julia_variants.get(aa_variant);
+                glViewport(winsize[0] / 2, 0, winsize[0] / 2, winsize[1]);
+                glUseProgram(program);
+                glUniform2f(glGetUniformLocation(program, "winsize"), winsize[0] / 2.0, winsize[1]);
+                glUniform2f(glGetUniformLocation(program, "init"), init[0], init[1]);
+                draw_antialias_pass(program, julia_vao, julia_vao_len, iterations.texture(), palette, mode, max_iter);
+            }
+        }
+        const bool changed = mandelbrot_changed || julia_changed || palette_changed;
+
+        {
+            const auto timer = profiler.pass("present");
+            cache.present();
+        }
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        // wheel zooms the deep view around the cursor
+        if (deep_zoom && !imgui_io.WantCaptureMouse && imgui_io.MouseWheel != 0.0f && mouse[0] < 0.0) {
+            const double m = std::min(winsize[0] / 2, winsize[1]);
+            const double dx = (mouse_px[0] * 2.0 - winsize[0] / 2.0) / m * view.scale;
+            const double dy = ((winsize[1] - mouse_px[1]) * 2.0 - winsize[1]) / m * view.scale;
+            const double next_scale = view.scale * std::pow(1.25, -imgui_io.MouseWheel);
+
+            const auto limbs = deep_limbs(next_scale, m);
+            const double t = 1.0 - next_scale / view.scale;
+            view.center[0] = view.center[0].with_limbs(limbs) + big_fixed(dx * t, limbs);
+            view.center[1] = view.center[1].with_limbs(limbs) + big_fixed(dy * t, limbs);
+            view.scale = next_scale;
+            ref_dirty = true;
+        }
+
+        const bool over_mandelbrot = !imgui_io.WantCaptureMouse && mouse[0] < 0.0;
+        drag.update(!deep_zoom && over_mandelbrot && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS,
+                    mouse_px[0], mouse_px[1]);
+
+        // in tile mode the wheel zooms around the cursor and a drag moves the center by the pixels dragged
+        if (use_tiles && !deep_zoom) {
+            const double m = std::min(winsize[0] / 2, winsize[1]);
+            const double spacing = 2.0 * tiles_view.scale / m;
+            tiles_view.center[0] += (drag.pan[0] - tiles_pan[0]) * spacing;
+            tiles_view.center[1] += (drag.pan[1] - tiles_pan[1]) * spacing;
+            tiles_pan = drag.pan;
+
+            if (over_mandelbrot && imgui_io.MouseWheel != 0.0f) {
+                const double dx = (mouse_px[0] * 2.0 - winsize[0] / 2.0) / m * tiles_view.scale;
+                const double dy = ((winsize[1] - mouse_px[1]) * 2.0 - winsize[1]) / m * tiles_view.scale;
+                // no deeper than the finest tile level can show
+                const double min_scale = tile_extent(tile_max_level) / tile_size * m / 2.0;
+                const double next_scale =
+                    std::max(tiles_view.scale * std::pow(1.25, -imgui_io.MouseWheel), min_scale);
+                const double t = 1.0 - next_scale / tiles_view.scale;
+                tiles_view.center[0] += dx * t;
+                tiles_view.center[1] += dy * t;
+                tiles_view.scale = next_scale;
+            }
+        }
+
         ImGui::Begin("Settings");
         ImGui::SliderFloat2("init", init, -2.0, 2.0);
+        ImGui::Checkbox("redraw every frame", &scheduler.continuous);
+        ImGui::Combo("iterations", &iteration_index, iteration_labels, std::size(iteration_labels));
+        ImGui::Checkbox("double precision", &use_double);
+        ImGui::Checkbox("interior checks", &interior_checks);
+        if (interior_checks) {
+            const auto& counts = interior.last();
+            ImGui::Text("last redraw: cardioid %zu, bulb %zu, period %zu", counts.cardioid, counts.bulb, counts.period);
+        }
+        if (ImGui::Combo("palette", &palette_index, palette_preset_names, std::size(palette_preset_names))) {
+            stops = palette_preset_stops(static_cast<palette_preset>(palette_index));
+        }
+        for (std::size_t i = 0; i < stops.size(); i++) {
+            ImGui::ColorEdit3(("stop " + std::to_string(i + 1)).c_str(), stops[i].data());
+        }
+        ImGui::Checkbox("smooth", &smooth);
+        ImGui::Combo("antialiasing", &aa_index, aa_labels, std::size(aa_labels));
+        ImGui::Text("pan: %d, %d", drag.pan[0], drag.pan[1]);
+        ImGui::SameLine();
+        if (ImGui::Button("reset pan")) drag.reset();
+        ImGui::Checkbox("tile cache", &use_tiles);
+        if (use_tiles) {
+            if (ImGui::SliderInt("tile budget (MiB)", &tile_budget_mib, 16, 4096)) {
+                tiles.set_budget(static_cast<std::size_t>(tile_budget_mib) << 20);
+            }
+            if (ImGui::Button("reset tile view")) tiles_view = tile_view{};
+            const auto stats = tiles.stats();
+            ImGui::Text("scale: %g, level: %d", tiles_view.scale,
+                        tile_browser::level_for(tiles_view.scale, std::min(winsize[0] / 2, winsize[1])));
+            ImGui::Text("tiles: %zu (%.1f MiB), spilled: %zu, pending: %zu", tiles.size(),
+                        static_cast<double>(tiles.bytes()) / (1 << 20), tiles.spilled(), browser.pending());
+            ImGui::Text("hits: %zu, misses: %zu, from disk: %zu", stats.hits, stats.misses, stats.spill_hits);
+        }
+        ImGui::Checkbox("julia atlas", &use_atlas);
+        if (use_atlas) {
+            ImGui::Checkbox("blend atlas entries", &atlas_blend);
+            const auto [ready, planned] = atlas.progress();
+            ImGui::Text("atlas entries: %zu / %zu", ready, planned);
+        }
+        ImGui::Checkbox("deep zoom", &deep_zoom);
+        if (deep_zoom) {
+            ref_dirty |= ImGui::SliderInt("deep iterations", &deep_iter, 50, 100000);
+            if (ImGui::Button("reset view")) {
+                view = deep_view{};
+                ref_dirty = true;
+            }
+            const auto digits = static_cast<std::size_t>(std::max(0.0, -std::log10(view.scale))) + 4;
+            ImGui::Text("scale: %g", view.scale);
+            ImGui::Text("re: %s", view.center[0].to_string(digits).c_str());
+            ImGui::Text("im: %s", view.center[1].to_string(digits).c_str());
+            ImGui::Text("reference: %zu, series skip: %u", std::size(ref.z), ref.skip);
+        }
+        ImGui::Checkbox("frame times", &show_profiler);
         ImGui::End();
-        ImGui::Render();
+        if (show_profiler) draw_profiler_overlay(profiler);
 
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            const auto timer = profiler.pass("imgui");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         glViewport(0, 0, winsize[0], winsize[1]);
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            const auto timer = profiler.pass("swap", false);
+            glfwSwapBuffers(window);
+        }
+        profiler.end_frame();
+        // an ImGui edit is applied by the next frame, so it must not block before that one is drawn
+        scheduler.next(changed || ref_dirty || (!deep_zoom && !use_tiles && drag.pan != mandelbrot_pan));
     }
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
-    glDeleteProgram(mandelbrot_program);
-    glDeleteProgram(julia_program);
-    glfwTerminate();
+    glDeleteBuffers(1, &orbit_ssbo);
 }
@@ -1,20 +1,58 @@
-#version 460
+#version 450
+
+// specialization, the executable injects its own values after the #version line
+#ifndef MAX_ITER
+#define MAX_ITER 50
+#endif
+#ifndef USE_DOUBLE
+#define USE_DOUBLE 0
+#endif
+#ifndef AA_SAMPLES
+#define AA_SAMPLES 0
+#endif
+#ifndef INTERIOR_CHECKS
+#define INTERIOR_CHECKS 1
+#endif
+
+#if USE_DOUBLE
+#define real_t double
+#define vec2_t dvec2
+#else
+#define real_t float
+#define vec2_t vec2
+#endif
 
 layout(location = 0) uniform vec2 winsize;
 layout(location = 1) uniform vec2 init;
 
+// first pass: raw results into the RG32F iteration texture, palette.frag colors them
+// r: iteration count, g: smooth iteration count, -1 if the point did not escape
+#if AA_SAMPLES
+// the AA_SAMPLES variant instead recolors the edge pixels of the colored pane, see antialias.glsl
 layout(location = 0) out vec4 fragment;
+vec4 antialias();
+#else
+layout(location = 0) out vec2 fragment;
+#endif
+
+// 3 if the last julia() call was stopped by the cycle check, else 0; the same codes as mandelbrot.frag
+uint interior_exit = 0u;
+#if INTERIOR_CHECKS && !AA_SAMPLES
+layout(std430, binding = 2) buffer interior_counter {
+	uint interior_counts[3];
+};
+#endif
 
 struct Complex {
-	float real;
-	float imag;
+	real_t real;
+	real_t imag;
 };
 
 Complex c_one() { return Complex(1.0, 0.0); }
 Complex c_i() { return Complex(0.0, 1.0); }
 
-float c_norm(Complex c) {
-    return length(vec2(c.real, c.imag));
+real_t c_norm(Complex c) {
+    return length(vec2_t(c.real, c.imag));
 }
 
 Complex c_add(Complex self, Complex other) {
@@ -31,35 +69,60 @@ Complex c_mul(Complex self, Complex other) {
 }
 
 Complex c_div(Complex self, Complex other) {
-    float norm = c_norm(other);
+    real_t norm = c_norm(other);
     return Complex((self.real * other.real + self.imag * other.imag) / (norm * norm),
                    (self.imag * other.real - self.real * other.imag) / (norm * norm));
 }
 
+// only the cycle check of mandelbrot() applies, the cardioid and the bulb are regions of c
 vec3 julia(Complex z, Complex c, uint n) {
+	interior_exit = 0u;
 	Complex ret = c_add(c_mul(z, z), c);
+#if INTERIOR_CHECKS
+	Complex saved = ret;
+#endif
 	uint i = 0;
 	for (i = 0; i < n; i++) {
 		ret = c_add(c_mul(ret, ret), c);
 
 		if (c_norm(ret) > 2.0) break;
+#if INTERIOR_CHECKS
+		if (ret == saved) {
+			interior_exit = 3u;
+			i = n;
+			break;
+		}
+		if ((i & (i + 1u)) == 0u) saved = ret;
+#endif
 	}
 
 	return vec3(ret.real, ret.imag, i);
 }
 
-void main() {
-    vec2 p = (gl_FragCoord.xy * 2.0 - winsize) / min(winsize.x, winsize.y);
+// first pass result at gl_FragCoord.xy + offset, offset 0 for the pixel itself
+vec2 evaluate(vec2 offset) {
+    vec2_t p = ((vec2_t(gl_FragCoord.xy) + vec2_t(offset)) * 2.0 - vec2_t(winsize)) / real_t(min(winsize.x, winsize.y));
 	p *= 2.0;
     p.x -= 4.0;
     vec2 c = init * 1.5;
     c.x -= 0.5;
 
-	vec3 a = julia(Complex(p.x, p.y), Complex(c.x, c.y), 50);
-	vec3 color;
-	color.x = 1.0 * (a.z / 50) * float(length(a.xy) > 2.0);
-	color.y = 1.0 * (a.z / 50) * float(length(a.xy) > 2.0);
-	color.z = 1.0 * (1.0 - a.z / 100) * float(length(a.xy) > 2.0);
+	vec3 a = julia(Complex(p.x, p.y), Complex(c.x, c.y), MAX_ITER);
+	float mu = -1.0;
+	if (length(a.xy) > 2.0) {
+		mu = max(0.0, a.z + 1.0 - log2(log(length(a.xy))));
+	}
+
+	return vec2(a.z, mu);
+}
 
-	fragment = vec4(color, 1.0);
+void main() {
+#if AA_SAMPLES
+	fragment = antialias();
+#else
+	fragment = evaluate(vec2(0.0));
+#if INTERIOR_CHECKS
+	if (interior_exit != 0u) atomicAdd(interior_counts[interior_exit - 1u], 1u);
+#endif
+#endif
 }
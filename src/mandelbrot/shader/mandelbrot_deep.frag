@@ -0,0 +1,62 @@
+#version 450
+
+layout(location = 0) uniform vec2 winsize;
+layout(location = 1) uniform double scale;
+layout(location = 2) uniform uint max_iter;
+layout(location = 3) uniform uint skip;
+layout(location = 4) uniform dvec2[3] series;
+
+// W_0 = 0, W_1 = center, ... computed on the CPU in arbitrary precision (include/perturbation.h)
+layout(std430, binding = 0) readonly buffer Reference {
+	dvec2 orbit[];
+};
+
+// first pass like mandelbrot.frag: (iteration count, smooth iteration count or -1) for palette.frag
+layout(location = 0) out vec2 fragment;
+
+dvec2 dc_mul(dvec2 self, dvec2 other) {
+	return dvec2(self.x * other.x - self.y * other.y, self.x * other.y + self.y * other.x);
+}
+
+double dc_norm2(dvec2 c) {
+	return dot(c, c);
+}
+
+vec3 mandelbrot_deep(dvec2 dc, uint n) {
+	uint last = uint(orbit.length()) - 1;
+	uint m = skip;
+	dvec2 delta = dc_mul(dc_mul(dc_mul(series[2], dc) + series[1], dc) + series[0], dc);
+	dvec2 z = orbit[m] + delta;
+	if (m == last) {
+		delta = z;
+		m = 0;
+	}
+
+	uint i = skip - 1;
+	for (; i < n; i++) {
+		delta = dc_mul(2.0 * orbit[m] + delta, delta) + dc;
+		m++;
+		z = orbit[m] + delta;
+
+		if (dc_norm2(z) > 4.0) break;
+
+		if (dc_norm2(z) < dc_norm2(delta) || m == last) {
+			delta = z;
+			m = 0;
+		}
+	}
+
+	return vec3(z.x, z.y, i);
+}
+
+void main() {
+	dvec2 dc = (dvec2(gl_FragCoord.xy) * 2.0 - dvec2(winsize)) / double(min(winsize.x, winsize.y)) * scale;
+
+	vec3 a = mandelbrot_deep(dc, max_iter);
+	float mu = -1.0;
+	if (length(a.xy) > 2.0) {
+		mu = max(0.0, a.z + 1.0 - log2(log(length(a.xy))));
+	}
+
+	fragment = vec2(a.z, mu);
+}
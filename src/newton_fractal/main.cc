@@ -4,22 +4,204 @@
 #include <backends/imgui_impl_opengl3.h>
 #include <imgui.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <numbers>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <tuple>
 
+#include "include/animation_path.h"
+#include "include/offscreen.h"
+#include "include/palette_pass.h"
+#include "include/profiler_overlay.h"
+#include "include/program_cache.h"
+#include "include/redraw.h"
+#include "include/scroll_cache.h"
+#include "include/shader_variants.h"
 #include "include/utils.h"
 
 constexpr std::pair glfw_winsize = {1000, 1000};
 
-int main() {
+// roots can be added up to this many; each count is its own shader variant
+constexpr std::size_t max_roots = animation_max_roots;
+
+// clang-format off
+const std::vector<std::array<GLfloat, 2>> default_roots = {
+    {1.0, 0.0},
+    {-1.0, 0.0},
+    {0.0, 1.0},
+    {0.0, -1.0},
+    {1.0, 1.0}
+};
+// clang-format on
+
+/**
+ * @brief coefficients a_0 .. a_n of the polynomial with these roots, as the vec2 array the shader reads
+ * They are expanded in double; the float rounding happens once, on upload.
+ */
+std::vector<GLfloat> root_coefficients(const std::vector<std::array<GLfloat, 2>>& roots) {
+    std::vector<std::complex<double>> z;
+    for (const auto& r : roots) z.emplace_back(r[0], r[1]);
+
+    std::vector<GLfloat> ret;
+    for (const auto& a : newton_coefficients(z)) {
+        ret.push_back(static_cast<GLfloat>(a.real()));
+        ret.push_back(static_cast<GLfloat>(a.imag()));
+    }
+    return ret;
+}
+
+/**
+ * @brief a root for the "add root" button and a color for its basin, spread by the golden angle
+ */
+std::array<GLfloat, 2> next_root(std::size_t i) {
+    const auto z = std::polar(1.5, 2.399963229728653 * static_cast<double>(i));
+    return {static_cast<GLfloat>(z.real()), static_cast<GLfloat>(z.imag())};
+}
+
+std::array<float, 3> next_color(std::size_t i) {
+    std::array<float, 3> ret;
+    ImGui::ColorConvertHSVtoRGB(std::fmod(0.618034f * static_cast<float>(i), 1.0f), 0.32f, 1.0f, ret[0], ret[1],
+                                ret[2]);
+    return ret;
+}
+
+/**
+ * @brief upload roots and the coefficients the iteration evaluates
+ */
+void upload_roots(GLuint program, const std::vector<std::array<GLfloat, 2>>& roots) {
+    const auto coeffs = root_coefficients(roots);
+    glUniform2fv(glGetUniformLocation(program, "coeffs"), std::size(coeffs) / 2, std::data(coeffs));
+    glUniform2fv(glGetUniformLocation(program, "roots"), std::size(roots), std::data(roots)->data());
+}
+
+/**
+ * @brief average, p99 and largest step count of the last frame, from g of the iteration texture
+ * The readback stalls until the frame is drawn, so it only runs while the stats are shown.
+ */
+iteration_stats read_iteration_stats(GLuint texture, int width, int height) {
+    std::vector<GLfloat> rg(static_cast<std::size_t>(width) * height * 2);
+    glGetTextureImage(texture, 0, GL_RG, GL_FLOAT, std::size(rg) * sizeof(GLfloat), std::data(rg));
+    std::vector<GLfloat> counts(std::size(rg) / 2);
+    for (std::size_t i = 0; i < std::size(counts); i++) counts[i] = rg[2 * i + 1];
+    return make_iteration_stats(std::move(counts));
+}
+
+// Batch mode: frame i rotates the roots by 2 pi i / frames around the origin. With --path the roots, colors,
+// center and scale follow the keyframes instead; iter and init there are the mandelbrot executable's.
+int main_headless(const headless_options& opt) {
+    auto context = egl_headless_context::create();
+    if (!context || !init_glew_headless()) std::exit(1);
+
+    animation_key home;
+    home.center[0] = home.center[1] = "0";
+    home.scale = 1.0;
+    std::optional<std::vector<animation_key>> keys;
+    if (!opt.path.empty() && !(keys = load_animation_path(opt.path, home))) std::exit(1);
+    const auto frames = opt.frames ? opt.frames : keys ? animation_length(*keys) : 1;
+
+    print_gl_info();
+    glEnable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(print_debug_message, nullptr);
+
+    program_cache programs;
+    program_variants variants(programs, embedded_newton_fractal_vert, embedded_newton_fractal_frag,
+                              {embedded_palette_color_glsl, embedded_antialias_glsl});
+    const auto root_defines = [](std::size_t root_count) -> shader_defines {
+        return {{"ROOT_COUNT", std::to_string(root_count)}};
+    };
+    const auto aa_defines = [&](std::size_t root_count) -> shader_defines {
+        return {{"ROOT_COUNT", std::to_string(root_count)}, {"AA_SAMPLES", std::to_string(opt.aa)}};
+    };
+    const auto [vao, vao_len] = create_quad_vao(variants.get(root_defines(std::size(default_roots))));
+    program_variants palette_variants(programs, embedded_newton_fractal_vert, embedded_palette_frag,
+                                      {embedded_palette_color_glsl});
+    const auto palette_program = palette_variants.get();
+    programs.print_stats();
+
+    frame_cache iterations(GL_RG32F);
+    iterations.resize(opt.width, opt.height);
+    palette_texture palette;
+    palette.upload(newton_default_colors());
+
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+
+    const auto ret = run_headless(opt, frames, [&](std::size_t frame, int width, int height) {
+        const double angle = 2.0 * std::numbers::pi * frame / frames;
+        auto roots = default_roots;
+        for (std::size_t i = 0; i < std::size(roots); i++) {
+            roots[i][0] = default_roots[i][0] * std::cos(angle) - default_roots[i][1] * std::sin(angle);
+            roots[i][1] = default_roots[i][0] * std::sin(angle) + default_roots[i][1] * std::cos(angle);
+        }
+        double scale = 1.0;
+        double pan[2] = {};
+
+        if (keys) {
+            const auto path = sample_animation(*keys, frame);
+            roots = path.roots.empty() ? default_roots : path.roots;
+            roots.resize(std::min(std::size(roots), max_roots));
+            auto colors = path.colors.empty() ? newton_default_colors() : path.colors;
+            while (std::size(colors) < std::size(roots)) colors.push_back(next_color(std::size(colors)));
+            palette.upload(colors);
+
+            // pan is in pixels: a center c is c / scale half heights away
+            scale = path.scale;
+            const double m = std::min(width, height);
+            pan[0] = path.center[0].to_double() / scale * m / 2.0;
+            pan[1] = path.center[1].to_double() / scale * m / 2.0;
+        }
+        const auto program = variants.get(root_defines(std::size(roots)));
+        const auto use = [&](GLuint p) {
+            glUseProgram(p);
+            glUniform2f(glGetUniformLocation(p, "winsize"), width, height);
+            glUniform1f(glGetUniformLocation(p, "scale"), scale);
+            glUniform2f(glGetUniformLocation(p, "pan"), pan[0], pan[1]);
+            glUniform1f(glGetUniformLocation(p, "tolerance"), 1e-6f);
+            upload_roots(p, roots);
+        };
+
+        GLint target;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
+        iterations.bind();
+
+        glViewport(0, 0, width, height);
+        use(program);
+        glBindVertexArray(vao);
+        glDrawArrays(GL_TRIANGLE_FAN, 0, vao_len);
+        glBindVertexArray(0);
+        glUseProgram(0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        draw_palette_pass(palette_program, vao, vao_len, iterations.texture(), palette, palette_mode::shaded, 100.0f);
+        if (opt.aa) {
+            const auto aa_program = variants.get(aa_defines(std::size(roots)));
+            use(aa_program);
+            draw_antialias_pass(aa_program, vao, vao_len, iterations.texture(), palette, palette_mode::shaded, 100.0f);
+        }
+    });
+
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    const auto headless = parse_headless_options(argc, argv);
+    if (headless.enabled) return main_headless(headless);
+
     if (!glfwInit()) std::exit(1);
+    const glfw_terminate_guard glfw_guard;
     glfwSetErrorCallback([](int ec, const char* desc) { std::cerr << "ec: " << ec << "desc: " << desc << std::endl; });
+    // the frame cache is blitted to the window, which a multisampled default framebuffer would refuse;
+    // antialiasing is the adaptive pass instead
+    glfwWindowHint(GLFW_SAMPLES, 0);
     auto* window = glfwCreateWindow(glfw_winsize.first, glfw_winsize.second, "GLFW", nullptr, nullptr);
 
     if (!window) {
@@ -28,7 +210,6 @@ int main() {
     }
 
     glfwMakeContextCurrent(window);
-    glfwWindowHint(GLFW_SAMPLES, 8);
 
     if (!glewInit()) {
         glfwTerminate();
@@ -45,127 +226,231 @@ int main() {
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 460");
 
-    std::cout << "OpenGL Version:" << glGetString(GL_VERSION) << std::endl;
-    std::cout << "Vendor:" << glGetString(GL_VENDOR) << std::endl;
-    std::cout << "Renderer:" << glGetString(GL_RENDERER) << std::endl;
+    print_gl_info();
     glEnable(GL_DEBUG_OUTPUT);
-    glDebugMessageCallback(
-        [](GLenum source, GLenum type, GLuint id, GLenum severity, [[maybe_unused]] GLsizei length,
-           const GLchar* message, [[maybe_unused]] const void* userParam) {
-            std::cerr << "-----glDebugMessageCallback-----" << std::endl
-                      << "source: " << source << std::endl
-                      << "type: " << type << std::endl
-                      << "id: " << id << std::endl
-                      << "severity: " << severity << std::endl
-                      << "message: " << message << std::endl;
-        },
-        nullptr);
-
-    // https://stackoverflow.com/questions/16380005/opengl-3-4-glvertexattribpointer-stride-and-offset-miscalculation
-    auto [program, vao, vao_len] = []() {
-        auto vsrc = read_file("shader/newton_fractal.vert").value();
-        auto fsrc = read_file("shader/newton_fractal.frag").value();
-
-        auto program = create_program(vsrc.data(), fsrc.data()).value();
-
-        auto in_location = glGetAttribLocation(program, "position");
-        std::vector<Vertex> vertexes;
-        vertexes.emplace_back(-1.0, -1.0);
-        vertexes.emplace_back(-1.0, 1.0);
-        vertexes.emplace_back(1.0, 1.0);
-        vertexes.emplace_back(1.0, -1.0);
-
-        GLuint vbo;
-        glCreateBuffers(1, &vbo);
-
-        glNamedBufferData(vbo, std::size(vertexes) * sizeof(decltype(vertexes)::value_type), std::data(vertexes),
-                          GL_STATIC_DRAW);
-
-        GLuint vao;
-        glCreateVertexArrays(1, &vao);
-        glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
-        glVertexArrayAttribFormat(vao, in_location, 2, GL_FLOAT, GL_FALSE, 0);
-        glEnableVertexArrayAttrib(vao, in_location);
-        glVertexArrayAttribBinding(vao, in_location, 0);
-
-        return std::tuple{program, vao, std::size(vertexes)};
-    }();
+    glDebugMessageCallback(print_debug_message, nullptr);
+
+    // every iteration cap / precision pair is linked up front so the settings never stall on a compile;
+    // other root counts are linked the first time they are used and then come from the program cache
+    const char* const iteration_labels[] = {"25", "50", "100", "200"};
+    const std::vector<std::uint32_t> iteration_caps = {25, 50, 100, 200};
+    const auto newton_defines = [](std::uint32_t max_iter, bool use_double, std::size_t root_count) -> shader_defines {
+        return {{"MAX_ITER", std::to_string(max_iter)},
+                {"ROOT_COUNT", std::to_string(root_count)},
+                {"USE_DOUBLE", use_double ? "1" : "0"}};
+    };
+    std::vector<shader_defines> newton_variants;
+    for (const auto cap : iteration_caps) {
+        for (const auto use_double : {false, true}) {
+            newton_variants.push_back(newton_defines(cap, use_double, std::size(default_roots)));
+        }
+    }
+
+    // antialiasing variants are linked when first switched on
+    const char* const aa_labels[] = {"off", "4", "16", "64"};
+    const std::uint32_t aa_caps[] = {0, 4, 16, 64};
+
+    program_cache programs;
+    program_variants variants(programs, embedded_newton_fractal_vert, embedded_newton_fractal_frag,
+                              {embedded_palette_color_glsl, embedded_antialias_glsl});
+    variants.prebuild(newton_variants);
+    const auto [vao, vao_len] = create_quad_vao(variants.get());
+    program_variants palette_variants(programs, embedded_newton_fractal_vert, embedded_palette_frag,
+                                      {embedded_palette_color_glsl});
+    const auto palette_program = palette_variants.get();
+    programs.print_stats();
 
     glClearColor(0.0, 0.0, 0.0, 1.0);
 
-    // clang-format off
-    GLfloat roots[] = {
-        1.0, 0.0,
-        -1.0, 0.0,
-        0.0, 1.0,
-        0.0, -1.0,
-        1.0, 1.0
-    };
-    GLfloat colors[] = {
-        255 / 255.0f, 173 / 255.0f, 173 / 255.0f,
-        255 / 255.0f, 173 / 255.0f, 255 / 255.0f,
-        173 / 255.0f, 173 / 255.0f, 255 / 255.0f,
-        173 / 255.0f, 255 / 255.0f, 255 / 255.0f,
-        173 / 255.0f, 255 / 255.0f, 173 / 255.0f
-    };
-    // clang-format on
+    auto roots = default_roots;
+    auto colors = newton_default_colors();
     GLfloat scale = 1.0;
     int detail_scale = 1;
     auto im_winsize = ImVec2{200.0, 300.0};
     bool only_first = true;
+    int iteration_index = 2;
+    bool use_double = false;
+    // pixels stop once a step is shorter than tolerance; shaded darkens them by the steps that took
+    bool early_exit = true;
+    GLfloat tolerance = 1e-6f;
+    bool shaded = true;
+    int aa_index = 0;
+    bool show_stats = false;
+    std::optional<iteration_stats> stats;
 
-    while (!glfwWindowShouldClose(window)) {
-        glClear(GL_COLOR_BUFFER_BIT);
+    // The root each pixel converges to is recomputed only when the roots or the view change; editing a color
+    // only recolors the iteration buffer, and idle frames just blit the cache.
+    frame_cache cache;
+    frame_cache iterations(GL_RG32F);
+    dirty_state<int, int, GLfloat, int, int, bool, GLfloat, decltype(roots)> fractal_dirty;
+    dirty_state<decltype(colors)> colors_dirty;
+    dirty_state<bool, int> shading_dirty;
+    palette_texture palette;
+    redraw_scheduler scheduler;
+    frame_profiler profiler;
+    bool show_profiler = false;
 
-        glUseProgram(program);
+    // left drag pans the view; a pan only draws the strips it exposes
+    drag_pan drag;
+    std::array<int, 2> drawn_pan{};
+
+    while (!glfwWindowShouldClose(window)) {
+        profiler.begin_frame();
         int winsize[2];
         glfwGetWindowSize(window, &winsize[0], &winsize[1]);
-        glViewport(0, 0, winsize[0], winsize[1]);
-        glUniform2f(glGetUniformLocation(program, "winsize"), winsize[0], winsize[1]);
-        glUniform1f(glGetUniformLocation(program, "scale"), scale / detail_scale);
+        if (cache.resize(winsize[0], winsize[1]) | iterations.resize(winsize[0], winsize[1])) {
+            fractal_dirty.invalidate();
+        }
 
-        glUniform2fv(glGetUniformLocation(program, "roots"), std::size(roots) / 2, roots);
-        glUniform3fv(glGetUniformLocation(program, "colors"), std::size(colors) / 3, colors);
+        const pixel_rect area = {0, 0, winsize[0], winsize[1]};
+        std::vector<pixel_rect> rects;
+        const GLfloat tol = early_exit ? tolerance : 0.0f;
+        if (fractal_dirty.update(winsize[0], winsize[1], scale, detail_scale, iteration_index, use_double, tol,
+                                 roots)) {
+            rects = {area};
+        } else if (drag.pan != drawn_pan) {
+            const int dx = drawn_pan[0] - drag.pan[0];
+            const int dy = drawn_pan[1] - drag.pan[1];
+            iterations.scroll(area, dx, dy);
+            rects = exposed_strips(area, dx, dy);
+        }
 
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, vao_len);
-        glBindVertexArray(0);
-        glUseProgram(0);
+        // the fractal pass and its antialiasing variant share every view uniform
+        const auto variant = newton_defines(iteration_caps[iteration_index], use_double, std::size(roots));
+        const auto use = [&](GLuint program, const std::array<int, 2>& pan) {
+            glUseProgram(program);
+            glUniform2f(glGetUniformLocation(program, "winsize"), winsize[0], winsize[1]);
+            glUniform1f(glGetUniformLocation(program, "scale"), scale / detail_scale);
+            glUniform2f(glGetUniformLocation(program, "pan"), pan[0], pan[1]);
+            glUniform1f(glGetUniformLocation(program, "tolerance"), tol);
+            upload_roots(program, roots);
+        };
+
+        const bool fractal_changed = !rects.empty();
+        if (fractal_changed) {
+            const auto timer = profiler.pass("fractal");
+            iterations.bind();
+            use(variants.get(variant), drag.pan);
+            glViewport(0, 0, winsize[0], winsize[1]);
+
+            glBindVertexArray(vao);
+            glEnable(GL_SCISSOR_TEST);
+            for (const auto& r : rects) {
+                glScissor(r.x, r.y, r.width, r.height);
+                glDrawArrays(GL_TRIANGLE_FAN, 0, vao_len);
+            }
+            glDisable(GL_SCISSOR_TEST);
+            glBindVertexArray(0);
+            glUseProgram(0);
+            drawn_pan = drag.pan;
+            stats.reset();
+        }
+        if (show_stats && !stats) {
+            const auto timer = profiler.pass("stats readback");
+            stats = read_iteration_stats(iterations.texture(), winsize[0], winsize[1]);
+        }
+
+        const bool colors_changed = colors_dirty.update(colors);
+        if (colors_changed) palette.upload(colors);
+
+        const bool shading_changed = shading_dirty.update(shaded, aa_index);
+        const bool changed = fractal_changed || colors_changed || shading_changed;
+        const auto mode = shaded ? palette_mode::shaded : palette_mode::indexed;
+        const auto max_iter = static_cast<float>(iteration_caps[iteration_index]);
+        if (changed) {
+            const auto timer = profiler.pass("palette");
+            cache.bind();
+            glViewport(0, 0, winsize[0], winsize[1]);
+            draw_palette_pass(palette_program, vao, vao_len, iterations.texture(), palette, mode, max_iter);
+        }
+        // recolors the pixels on a basin boundary
+        if (changed && aa_caps[aa_index]) {
+            const auto timer = profiler.pass("antialias");
+            auto aa_variant = variant;
+            aa_variant.emplace_back("AA_SAMPLES", std::to_string(aa_caps[aa_index]));
+            const auto program = variants.get(aa_variant);
+            use(program, drawn_pan);
+            draw_antialias_pass(program, vao, vao_len, iterations.texture(), palette, mode, max_iter);
+        }
+
+        {
+            const auto timer = profiler.pass("present");
+            cache.present();
+        }
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        double cursor[2];
+        glfwGetCursorPos(window, &cursor[0], &cursor[1]);
+        drag.update(!imgui_io.WantCaptureMouse && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS,
+                    cursor[0], cursor[1]);
+
         if (only_first) ImGui::SetNextWindowSize(im_winsize);
         ImGui::Begin("Settings");
+        ImGui::Checkbox("redraw every frame", &scheduler.continuous);
         ImGui::SliderFloat("scale", &scale, 1.0f, 10.0f);
         ImGui::SliderInt("detail scale", &detail_scale, 1, 10);
+        ImGui::Combo("iterations", &iteration_index, iteration_labels, std::size(iteration_labels));
+        ImGui::Checkbox("double precision", &use_double);
+        ImGui::Checkbox("early exit", &early_exit);
+        if (early_exit) {
+            ImGui::SameLine();
+            ImGui::SliderFloat("tolerance", &tolerance, 1e-7f, 1e-2f, "%.1e", ImGuiSliderFlags_Logarithmic);
+        }
+        ImGui::Checkbox("shade by convergence", &shaded);
+        ImGui::Combo("antialiasing", &aa_index, aa_labels, std::size(aa_labels));
+        ImGui::Checkbox("iteration stats", &show_stats);
+        if (show_stats && stats) {
+            ImGui::Text("steps: mean %.2f, p99 %.2f, max %.2f", stats->mean, stats->p99, stats->max);
+        }
+        ImGui::Text("pan: %d, %d", drag.pan[0], drag.pan[1]);
+        ImGui::SameLine();
+        if (ImGui::Button("reset pan")) drag.reset();
 
-        ImGui::SliderFloat2("root 1", roots + 0, -10.0f, 10.0f);
-        ImGui::SliderFloat2("root 2", roots + 2, -10.0f, 10.0f);
-        ImGui::SliderFloat2("root 3", roots + 4, -10.0f, 10.0f);
-        ImGui::SliderFloat2("root 4", roots + 6, -10.0f, 10.0f);
-        ImGui::SliderFloat2("root 5", roots + 8, -10.0f, 10.0f);
-
-        ImGui::ColorEdit3("color 1", colors + 0);
-        ImGui::ColorEdit3("color 2", colors + 3);
-        ImGui::ColorEdit3("color 3", colors + 6);
-        ImGui::ColorEdit3("color 4", colors + 9);
-        ImGui::ColorEdit3("color 5", colors + 12);
+        // a root and the color of its basin per row; removing one keeps the colors of the others
+        std::optional<std::size_t> removed;
+        for (std::size_t i = 0; i < std::size(roots); i++) {
+            ImGui::PushID(static_cast<int>(i));
+            const auto label = "root " + std::to_string(i + 1);
+            ImGui::SliderFloat2(label.c_str(), roots[i].data(), -10.0f, 10.0f);
+            ImGui::SameLine();
+            ImGui::ColorEdit3("##color", colors[i].data(), ImGuiColorEditFlags_NoInputs);
+            if (std::size(roots) > 1) {
+                ImGui::SameLine();
+                if (ImGui::SmallButton("x")) removed = i;
+            }
+            ImGui::PopID();
+        }
+        if (removed) {
+            roots.erase(roots.begin() + *removed);
+            colors.erase(colors.begin() + *removed);
+        }
+        if (std::size(roots) < max_roots && ImGui::Button("add root")) {
+            roots.push_back(next_root(std::size(roots)));
+            colors.push_back(next_color(std::size(colors)));
+        }
+        ImGui::Text("degree %zu", std::size(roots));
+        ImGui::Checkbox("frame times", &show_profiler);
         ImGui::End();
-        ImGui::Render();
-
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (show_profiler) draw_profiler_overlay(profiler);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            const auto timer = profiler.pass("imgui");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        {
+            const auto timer = profiler.pass("swap", false);
+            glfwSwapBuffers(window);
+        }
+        profiler.end_frame();
+        scheduler.next(changed || drag.pan != drawn_pan);
         only_first = false;
     }
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
-
-    glDeleteProgram(program);
-    glfwTerminate();
 }
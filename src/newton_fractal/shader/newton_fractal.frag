@@ -1,22 +1,57 @@
-#version 460
+#version 450
+
+// specialization, the executable injects its own values after the #version line
+#ifndef MAX_ITER
+#define MAX_ITER 100
+#endif
+#ifndef ROOT_COUNT
+#define ROOT_COUNT 5
+#endif
+#ifndef USE_DOUBLE
+#define USE_DOUBLE 0
+#endif
+#ifndef AA_SAMPLES
+#define AA_SAMPLES 0
+#endif
+
+#if USE_DOUBLE
+#define real_t double
+#define vec2_t dvec2
+#else
+#define real_t float
+#define vec2_t vec2
+#endif
 
 layout(location = 0) uniform vec2 winsize;
 layout(location = 1) uniform float scale;
-layout(location = 2) uniform vec2[5] roots;
-layout(location = 7) uniform vec3[5] colors;
-
+// whole pixels the view is panned by, added to gl_FragCoord so a scrolled cache lines up exactly
+layout(location = 2) uniform vec2 pan;
+// a_0 .. a_n of prod (z - root_i), a_n leading; the executable expands them whenever a root moves
+layout(location = 3) uniform vec2[ROOT_COUNT + 1] coeffs;
+layout(location = 4 + ROOT_COUNT) uniform vec2[ROOT_COUNT] roots;
+// a pixel stops once a step is shorter than this, 0 runs all MAX_ITER steps
+layout(location = 4 + 2 * ROOT_COUNT) uniform float tolerance;
+
+// first pass: index of the root reached in r of the RG32F iteration texture, palette.frag looks up its color;
+// g is the fractional step count, which palette.frag's shaded mode darkens slow pixels by
+#if AA_SAMPLES
+// the AA_SAMPLES variant instead recolors the edge pixels of the colored pane, see antialias.glsl
 layout(location = 0) out vec4 fragment;
+vec4 antialias();
+#else
+layout(location = 0) out vec2 fragment;
+#endif
 
 struct Complex {
-	float real;
-	float imag;
+	real_t real;
+	real_t imag;
 };
 
 Complex c_one() { return Complex(1.0, 0.0); }
 Complex c_i() { return Complex(0.0, 1.0); }
 
-float c_norm(Complex c) {
-    return length(vec2(c.real, c.imag));
+real_t c_norm(Complex c) {
+    return length(vec2_t(c.real, c.imag));
 }
 
 Complex c_add(Complex self, Complex other) {
@@ -33,7 +68,7 @@ Complex c_mul(Complex self, Complex other) {
 }
 
 Complex c_div(Complex self, Complex other) {
-    float norm = c_norm(other);
+    real_t norm = c_norm(other);
     return Complex((self.real * other.real + self.imag * other.imag) / (norm * norm),
                    (self.imag * other.real - self.real * other.imag) / (norm * norm));
 }
@@ -65,41 +100,69 @@ Dual d_div(Dual self, Dual other) {
                 c_div(c_sub(c_mul(self.imag, other.real), c_mul(self.real, other.imag)), norm));
 }
 
-Dual f(Dual z) {
-	Dual ret = d_one();
-	for (uint i = 0; i < roots.length(); i++) {
-		ret = d_mul(ret, d_sub(z, Dual(Complex(roots[i].x, roots[i].y), Complex(0.0, 0.0))));
+// one Horner step of f and f' together: (p, p') -> (p z + a, p' z + p), two c_mul against the three of d_mul
+Dual d_horner(Dual self, Complex z, Complex a) {
+    return Dual(c_add(c_mul(self.real, z), a), c_add(c_mul(self.imag, z), self.real));
+}
+
+// f(z) with f'(z) in the dual part; ROOT_COUNT is a constant of the variant, so the loop unrolls
+Dual f(Complex z) {
+	Dual ret = Dual(Complex(coeffs[ROOT_COUNT].x, coeffs[ROOT_COUNT].y), Complex(0.0, 0.0));
+	for (int k = ROOT_COUNT - 1; k >= 0; k--) {
+		ret = d_horner(ret, z, Complex(coeffs[k].x, coeffs[k].y));
 	}
 
 	return ret;
 }
 
-Dual df(Dual z) {
-	return f(z);
+// newton_smooth_count() in newton.h: steps minus how much of the last step was left over
+float smooth_count(uint steps, float last2, float tol2) {
+	if (!(last2 > 0.0)) return float(steps) - 1.0;
+	return float(steps) - clamp(log2(log(last2) / log(tol2)), 0.0, 1.0);
 }
 
-Complex newton(Complex init, uint n) {
+Complex newton(Complex init, uint n, out float count) {
+	real_t tol2 = real_t(tolerance) * real_t(tolerance);
+	count = float(n);
 	for (uint i = 0; i < n; i++) {
-		init = c_sub(init, c_div(f(Dual(init, c_one())).real, df(Dual(init, c_one())).imag));
+		Dual fz = f(init);
+		Complex step = c_div(fz.real, fz.imag);
+		init = c_sub(init, step);
+
+		real_t d2 = step.real * step.real + step.imag * step.imag;
+		if (d2 < tol2) {
+			count = smooth_count(i + 1, float(d2), float(tol2));
+			break;
+		}
 	}
 
 	return init;
 }
 
-void main() {
-    vec2 p = (gl_FragCoord.xy * 2.0 - winsize.xy) / min(winsize.x, winsize.y);
+// first pass result at gl_FragCoord.xy + offset, offset 0 for the pixel itself
+vec2 evaluate(vec2 offset) {
+    vec2_t p = ((vec2_t(gl_FragCoord.xy) + vec2_t(offset) + vec2_t(pan)) * 2.0 - vec2_t(winsize.xy)) / real_t(min(winsize.x, winsize.y));
 
     p *= scale;
-	Complex a = newton(Complex(p.x, p.y), 100);
+	float count;
+	Complex a = newton(Complex(p.x, p.y), MAX_ITER, count);
 
-	vec3 c = colors[0];
-	float d = distance(vec2(a.real, a.imag), roots[0]);
+	uint root = 0;
+	real_t d = distance(vec2_t(a.real, a.imag), vec2_t(roots[0]));
 	for (uint i = 1; i < roots.length(); i++) {
-		if (d > distance(vec2(a.real, a.imag), roots[i])) {
-			c = colors[i];
-			d = distance(vec2(a.real, a.imag), roots[i]);
+		if (d > distance(vec2_t(a.real, a.imag), vec2_t(roots[i]))) {
+			root = i;
+			d = distance(vec2_t(a.real, a.imag), vec2_t(roots[i]));
 		}
 	}
 
-	fragment = vec4(c, 1.0);
+	return vec2(float(root), count);
+}
+
+void main() {
+#if AA_SAMPLES
+	fragment = antialias();
+#else
+	fragment = evaluate(vec2(0.0));
+#endif
 }